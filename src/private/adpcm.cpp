@@ -0,0 +1,359 @@
+#include "adpcm.h"
+#include "simd.h"
+#include <string.h>
+
+#define ADPCM_STEP_COUNT 89
+
+struct AdpcmTables
+{
+    int32_t diff[ADPCM_STEP_COUNT * 16];    // signed delta for (stepIndex * 16 + code)
+    int32_t next[ADPCM_STEP_COUNT * 16];    // next stepIndex * 16 for the same entry
+};
+
+internal constexpr auto BuildTables() -> AdpcmTables
+{
+    constexpr int16_t steps[ADPCM_STEP_COUNT] =
+    {
+        7, 8, 9, 10, 11, 12, 13, 14, 16, 17, 19, 21, 23, 25, 28, 31, 34, 37, 41, 45,
+        50, 55, 60, 66, 73, 80, 88, 97, 107, 118, 130, 143, 157, 173, 190, 209, 230,
+        253, 279, 307, 337, 371, 408, 449, 494, 544, 598, 658, 724, 796, 876, 963,
+        1060, 1166, 1282, 1411, 1552, 1707, 1878, 2066, 2272, 2499, 2749, 3024, 3327,
+        3660, 4026, 4428, 4871, 5358, 5894, 6484, 7132, 7845, 8630, 9493, 10442, 11487,
+        12635, 13899, 15289, 16818, 18500, 20350, 22385, 24623, 27086, 29794, 32767
+    };
+    constexpr int indexAdjust[8] = {-1, -1, -1, -1, 2, 4, 6, 8};
+
+    AdpcmTables tables = {};
+    for (int stepIndex = 0; stepIndex < ADPCM_STEP_COUNT; ++stepIndex)
+    {
+        int step = steps[stepIndex];
+        for (int code = 0; code < 16; ++code)
+        {
+            int diff = step >> 3;
+            if (code & 1) diff += step >> 2;
+            if (code & 2) diff += step >> 1;
+            if (code & 4) diff += step;
+            int next = stepIndex + indexAdjust[code & 7];
+            next = next < 0 ? 0 : (next >= ADPCM_STEP_COUNT ? ADPCM_STEP_COUNT - 1 : next);
+
+            tables.diff[stepIndex * 16 + code] = (code & 8) ? -diff : diff;
+            tables.next[stepIndex * 16 + code] = next * 16;
+        }
+    }
+    return tables;
+}
+
+global constexpr AdpcmTables adpcmTables = BuildTables();
+
+internal inline int32_t ClampSample(int32_t value)
+{
+    return value > 32767 ? 32767 : (value < -32768 ? -32768 : value);
+}
+
+auto AdpcmEncodedSize(int channels, uint32_t frameCount) -> size_t
+{
+    size_t blockCount = (frameCount + ADPCM_BLOCK_FRAMES - 1) / ADPCM_BLOCK_FRAMES;
+    return blockCount * channels * ADPCM_CHANNEL_BYTES;
+}
+
+auto AdpcmEncode(const int16_t* left, const int16_t* right, int channels, uint32_t frameCount, uint8_t* out) -> uint32_t
+{
+    uint32_t blockCount = (frameCount + ADPCM_BLOCK_FRAMES - 1) / ADPCM_BLOCK_FRAMES;
+    // The step index carries over block boundaries, it only has to be rebuilt after a seek
+    int32_t stepIndex16[2] = {};
+
+    for (uint32_t block = 0; block < blockCount; ++block)
+    {
+        uint32_t firstFrame = block * ADPCM_BLOCK_FRAMES;
+        for (int channel = 0; channel < channels; ++channel)
+        {
+            const int16_t* in = channel == 0 ? left : right;
+            uint8_t* header = out + (block * channels + channel) * ADPCM_CHANNEL_BYTES;
+            uint8_t* nibbles = header + 4;
+
+            int32_t predictor = in[firstFrame];
+            int32_t index16 = stepIndex16[channel];
+            memcpy(header, &in[firstFrame], sizeof(int16_t));
+            header[2] = (uint8_t)(index16 / 16);
+            header[3] = 0;
+
+            for (int k = 1; k < ADPCM_BLOCK_FRAMES; ++k)
+            {
+                // Past the end we hold the last sample so the tail doesn't click
+                uint32_t frame = firstFrame + k;
+                int32_t target = in[frame < frameCount ? frame : frameCount - 1];
+
+                // Try every code against the decoder's own tables, the result is bit exact
+                int bestCode = 0;
+                int32_t bestError = INT32_MAX;
+                for (int code = 0; code < 16; ++code)
+                {
+                    int32_t decoded = ClampSample(predictor + adpcmTables.diff[index16 + code]);
+                    int32_t error = decoded > target ? decoded - target : target - decoded;
+                    if (error < bestError)
+                    {
+                        bestError = error;
+                        bestCode = code;
+                    }
+                }
+
+                predictor = ClampSample(predictor + adpcmTables.diff[index16 + bestCode]);
+                index16 = adpcmTables.next[index16 + bestCode];
+
+                int byteIndex = (k - 1) >> 1;
+                if ((k - 1) & 1)
+                {
+                    nibbles[byteIndex] |= (uint8_t)(bestCode << 4);
+                }
+                else
+                {
+                    nibbles[byteIndex] = (uint8_t)bestCode;
+                }
+            }
+            stepIndex16[channel] = index16;
+        }
+    }
+    return blockCount;
+}
+
+auto AdpcmLoad(AdpcmSound& sound, MemoryArena& arena, const void* file, size_t fileSize) -> bool
+{
+    sound = {};
+    if (fileSize < sizeof(AdpcmFileHeader))
+    {
+        return false;
+    }
+
+    AdpcmFileHeader header;
+    memcpy(&header, file, sizeof(header));
+    size_t blockBytes = (size_t)header.channels * ADPCM_CHANNEL_BYTES;
+    if (memcmp(header.magic, "ADPC", 4) != 0 || header.version != 1 ||
+        header.blockFrames != ADPCM_BLOCK_FRAMES || (header.channels != 1 && header.channels != 2) ||
+        header.blockCount != (header.frameCount + ADPCM_BLOCK_FRAMES - 1) / ADPCM_BLOCK_FRAMES ||
+        fileSize - sizeof(header) < header.blockCount * blockBytes)
+    {
+        OutputDebugStringA("Unsupported or malformed adpcm file\n");
+        return false;
+    }
+
+    sound.samplesPerSecond = (int)header.samplesPerSecond;
+    sound.channels = header.channels;
+    sound.frameCount = header.frameCount;
+    sound.blockCount = header.blockCount;
+    sound.blockBytes = (uint32_t)blockBytes;
+    sound.blocks = (uint8_t*)PushSize(arena, header.blockCount * blockBytes);
+    memcpy(sound.blocks, (const uint8_t*)file + sizeof(header), header.blockCount * blockBytes);
+    return true;
+}
+
+void AdpcmDecoderInitialize(AdpcmDecoder& decoder, MemoryArena& arena)
+{
+    decoder = {};
+    decoder.left = PushArray(arena, ADPCM_DECODE_LANES * ADPCM_BLOCK_FRAMES, float);
+    decoder.right = PushArray(arena, ADPCM_DECODE_LANES * ADPCM_BLOCK_FRAMES, float);
+}
+
+#pragma region Block decoding
+// Each lane is one channel of one block, laneOffsets are byte offsets into blocks
+
+internal void DecodeLanesScalar(const uint8_t* blocks, const int32_t* laneOffsets, int laneCount, float* const* out)
+{
+    const float scale = 1.0f / 32768.0f;
+    // Two chains per pass so the table loads of one hide the latency of the other
+    for (int lane = 0; lane < laneCount; lane += 2)
+    {
+        const uint8_t* a = blocks + laneOffsets[lane];
+        const uint8_t* b = blocks + laneOffsets[lane + 1 < laneCount ? lane + 1 : lane];
+        float* outA = out[lane];
+        float* outB = out[lane + 1 < laneCount ? lane + 1 : lane];
+
+        int32_t predictorA = (int16_t)(a[0] | (a[1] << 8));
+        int32_t predictorB = (int16_t)(b[0] | (b[1] << 8));
+        int32_t indexA = (a[2] < ADPCM_STEP_COUNT ? a[2] : ADPCM_STEP_COUNT - 1) * 16;
+        int32_t indexB = (b[2] < ADPCM_STEP_COUNT ? b[2] : ADPCM_STEP_COUNT - 1) * 16;
+        outA[0] = (float)predictorA * scale;
+        outB[0] = (float)predictorB * scale;
+
+        for (int byte = 0; byte < (ADPCM_BLOCK_FRAMES - 1) / 2; ++byte)
+        {
+            int32_t bitsA = a[4 + byte];
+            int32_t bitsB = b[4 + byte];
+            for (int half = 0; half < 2; ++half)
+            {
+                int32_t entryA = indexA + (bitsA & 15);
+                int32_t entryB = indexB + (bitsB & 15);
+                predictorA = ClampSample(predictorA + adpcmTables.diff[entryA]);
+                predictorB = ClampSample(predictorB + adpcmTables.diff[entryB]);
+                indexA = adpcmTables.next[entryA];
+                indexB = adpcmTables.next[entryB];
+                outA[1 + byte * 2 + half] = (float)predictorA * scale;
+                outB[1 + byte * 2 + half] = (float)predictorB * scale;
+                bitsA >>= 4;
+                bitsB >>= 4;
+            }
+        }
+    }
+}
+
+SIMD_TARGET_AVX2
+internal inline void Transpose8x8(__m256* rows)
+{
+    __m256 t0 = _mm256_unpacklo_ps(rows[0], rows[1]);
+    __m256 t1 = _mm256_unpackhi_ps(rows[0], rows[1]);
+    __m256 t2 = _mm256_unpacklo_ps(rows[2], rows[3]);
+    __m256 t3 = _mm256_unpackhi_ps(rows[2], rows[3]);
+    __m256 t4 = _mm256_unpacklo_ps(rows[4], rows[5]);
+    __m256 t5 = _mm256_unpackhi_ps(rows[4], rows[5]);
+    __m256 t6 = _mm256_unpacklo_ps(rows[6], rows[7]);
+    __m256 t7 = _mm256_unpackhi_ps(rows[6], rows[7]);
+    __m256 u0 = _mm256_shuffle_ps(t0, t2, _MM_SHUFFLE(1, 0, 1, 0));
+    __m256 u1 = _mm256_shuffle_ps(t0, t2, _MM_SHUFFLE(3, 2, 3, 2));
+    __m256 u2 = _mm256_shuffle_ps(t1, t3, _MM_SHUFFLE(1, 0, 1, 0));
+    __m256 u3 = _mm256_shuffle_ps(t1, t3, _MM_SHUFFLE(3, 2, 3, 2));
+    __m256 u4 = _mm256_shuffle_ps(t4, t6, _MM_SHUFFLE(1, 0, 1, 0));
+    __m256 u5 = _mm256_shuffle_ps(t4, t6, _MM_SHUFFLE(3, 2, 3, 2));
+    __m256 u6 = _mm256_shuffle_ps(t5, t7, _MM_SHUFFLE(1, 0, 1, 0));
+    __m256 u7 = _mm256_shuffle_ps(t5, t7, _MM_SHUFFLE(3, 2, 3, 2));
+    rows[0] = _mm256_permute2f128_ps(u0, u4, 0x20);
+    rows[1] = _mm256_permute2f128_ps(u1, u5, 0x20);
+    rows[2] = _mm256_permute2f128_ps(u2, u6, 0x20);
+    rows[3] = _mm256_permute2f128_ps(u3, u7, 0x20);
+    rows[4] = _mm256_permute2f128_ps(u0, u4, 0x31);
+    rows[5] = _mm256_permute2f128_ps(u1, u5, 0x31);
+    rows[6] = _mm256_permute2f128_ps(u2, u6, 0x31);
+    rows[7] = _mm256_permute2f128_ps(u3, u7, 0x31);
+}
+
+SIMD_TARGET_AVX2
+internal void DecodeLanesAVX2(const uint8_t* blocks, const int32_t* laneOffsets, int laneCount, float* const* out)
+{
+    // Idle lanes repeat lane 0, their output is thrown away
+    alignas(32) int32_t offsets[ADPCM_DECODE_LANES];
+    for (int lane = 0; lane < ADPCM_DECODE_LANES; ++lane)
+    {
+        offsets[lane] = laneOffsets[lane < laneCount ? lane : 0];
+    }
+
+    __m256i offset = _mm256_load_si256((const __m256i*)offsets);
+    __m256i header = _mm256_i32gather_epi32((const int*)blocks, offset, 1);
+    __m256i predictor = _mm256_srai_epi32(_mm256_slli_epi32(header, 16), 16);
+    __m256i index = _mm256_and_si256(_mm256_srli_epi32(header, 16), _mm256_set1_epi32(0xFF));
+    index = _mm256_slli_epi32(_mm256_min_epi32(index, _mm256_set1_epi32(ADPCM_STEP_COUNT - 1)), 4);
+
+    const __m256i low = _mm256_set1_epi32(-32768);
+    const __m256i high = _mm256_set1_epi32(32767);
+    const __m256i nibbleMask = _mm256_set1_epi32(15);
+    const __m256i lastIndex = _mm256_set1_epi32((ADPCM_STEP_COUNT - 1) * 16);
+    // The index walk only needs the low 3 bits of the code, a permute keeps it off the gather latency
+    const __m256i indexAdjust = _mm256_setr_epi32(-16, -16, -16, -16, 32, 64, 96, 128);
+    const __m256 scale = _mm256_set1_ps(1.0f / 32768.0f);
+
+    alignas(32) float first[ADPCM_DECODE_LANES];
+    _mm256_store_ps(first, _mm256_mul_ps(_mm256_cvtepi32_ps(predictor), scale));
+    for (int lane = 0; lane < laneCount; ++lane)
+    {
+        out[lane][0] = first[lane];
+    }
+
+    for (int word = 0; word < (ADPCM_BLOCK_FRAMES - 1) / 8; ++word)
+    {
+        // 8 codes per gathered word, decoded sample major and transposed back to one row per lane
+        offset = _mm256_add_epi32(offset, _mm256_set1_epi32(4));
+        __m256i bits = _mm256_i32gather_epi32((const int*)blocks, offset, 1);
+        __m256 rows[8];
+        for (int i = 0; i < 8; ++i)
+        {
+            __m256i code = _mm256_and_si256(bits, nibbleMask);
+            __m256i diff = _mm256_i32gather_epi32(adpcmTables.diff, _mm256_add_epi32(index, code), 4);
+            index = _mm256_add_epi32(index, _mm256_permutevar8x32_epi32(indexAdjust, code));
+            index = _mm256_min_epi32(_mm256_max_epi32(index, _mm256_setzero_si256()), lastIndex);
+            predictor = _mm256_min_epi32(_mm256_max_epi32(_mm256_add_epi32(predictor, diff), low), high);
+            bits = _mm256_srli_epi32(bits, 4);
+            rows[i] = _mm256_mul_ps(_mm256_cvtepi32_ps(predictor), scale);
+        }
+
+        Transpose8x8(rows);
+        for (int lane = 0; lane < laneCount; ++lane)
+        {
+            _mm256_storeu_ps(out[lane] + 1 + word * 8, rows[lane]);
+        }
+    }
+}
+
+#pragma endregion
+
+// Decodes as many whole blocks from frame onward as the decoder holds
+internal void FillDecoder(const AdpcmSound& sound, AdpcmDecoder& decoder, uint32_t frame)
+{
+    uint32_t firstBlock = frame / ADPCM_BLOCK_FRAMES;
+    uint32_t blocksPerFill = ADPCM_DECODE_LANES / sound.channels;
+    uint32_t blockCount = sound.blockCount - firstBlock;
+    if (blockCount > blocksPerFill)
+    {
+        blockCount = blocksPerFill;
+    }
+
+    int32_t laneOffsets[ADPCM_DECODE_LANES];
+    float* laneOut[ADPCM_DECODE_LANES];
+    int laneCount = 0;
+    for (uint32_t block = 0; block < blockCount; ++block)
+    {
+        for (int channel = 0; channel < sound.channels; ++channel)
+        {
+            laneOffsets[laneCount] = (int32_t)((firstBlock + block) * sound.blockBytes + channel * ADPCM_CHANNEL_BYTES);
+            laneOut[laneCount] = (channel == 0 ? decoder.left : decoder.right) + block * ADPCM_BLOCK_FRAMES;
+            ++laneCount;
+        }
+    }
+
+    local bool useAvx2 = CpuHasAvx2();
+    if (useAvx2)
+    {
+        DecodeLanesAVX2(sound.blocks, laneOffsets, laneCount, laneOut);
+    }
+    else
+    {
+        DecodeLanesScalar(sound.blocks, laneOffsets, laneCount, laneOut);
+    }
+
+    decoder.firstFrame = firstBlock * ADPCM_BLOCK_FRAMES;
+    decoder.frameCount = blockCount * ADPCM_BLOCK_FRAMES;
+    if (decoder.firstFrame + decoder.frameCount > sound.frameCount)
+    {
+        decoder.frameCount = sound.frameCount - decoder.firstFrame;
+    }
+}
+
+int AdpcmMix(const AdpcmSound& sound, AdpcmDecoder& decoder, uint32_t& framePosition,
+             float* left, float* right, int frameCount, float volume)
+{
+    int framesMixed = 0;
+    while (framesMixed < frameCount && framePosition < sound.frameCount)
+    {
+        if (framePosition < decoder.firstFrame || framePosition >= decoder.firstFrame + decoder.frameCount)
+        {
+            FillDecoder(sound, decoder, framePosition);
+        }
+
+        uint32_t at = framePosition - decoder.firstFrame;
+        int count = frameCount - framesMixed;
+        if ((uint32_t)count > decoder.frameCount - at)
+        {
+            count = (int)(decoder.frameCount - at);
+        }
+
+        const float* inLeft = decoder.left + at;
+        const float* inRight = sound.channels == 2 ? decoder.right + at : inLeft;
+        float* outLeft = left + framesMixed;
+        float* outRight = right + framesMixed;
+        for (int i = 0; i < count; ++i)
+        {
+            outLeft[i] += inLeft[i] * volume;
+            outRight[i] += inRight[i] * volume;
+        }
+
+        framesMixed += count;
+        framePosition += count;
+    }
+    return framesMixed;
+}
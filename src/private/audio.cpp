@@ -0,0 +1,431 @@
+#include "audio.h"
+#include "wav.h"
+#include "ring.h"
+#include <math.h>
+
+void AudioClose(AudioDevice& device)
+{
+    if (device.api)
+    {
+        device.api->close(device);
+    }
+    device.api = nullptr;
+    device.backendData = nullptr;
+    device.isPlaying = false;
+}
+
+internal void FillWriteRange(AudioDevice& device, uint32_t targetCursor, AudioWriteRange& range)
+{
+    range.byteToLock = (device.runningSampleIndex * device.bytesPerSample) % device.bufferSize;
+
+    if (range.byteToLock > targetCursor)
+    {
+        range.bytesToWrite = device.bufferSize - range.byteToLock;
+        range.bytesToWrite += targetCursor;
+    }
+    else
+    {
+        range.bytesToWrite = targetCursor - range.byteToLock;
+    }
+}
+
+auto AudioComputeWriteRange(AudioDevice& device, uint32_t latencyBytes, AudioWriteRange& range) -> bool
+{
+    uint32_t playCursor = 0;
+    uint32_t writeCursor = 0;
+    if (!AudioGetCursors(device, playCursor, writeCursor))
+    {
+        return false;
+    }
+
+    FillWriteRange(device, (playCursor + latencyBytes) % device.bufferSize, range);
+    return true;
+}
+
+internal auto AsRingSpan(const AudioRegions& regions) -> RingSpan
+{
+    return {regions.region1, regions.region1Size, regions.region2, regions.region2Size};
+}
+
+auto AudioWrite(AudioDevice& device, const AudioWriteRange& range, const int16_t* samples) -> bool
+{
+    if (!samples || range.bytesToWrite == 0)
+    {
+        return false;
+    }
+
+    AudioRegions regions;
+    if (!AudioLock(device, range.byteToLock, range.bytesToWrite, regions))
+    {
+        return false;
+    }
+
+    RingSpanCopyIn(AsRingSpan(regions), samples);
+    device.runningSampleIndex += (regions.region1Size + regions.region2Size) / device.bytesPerSample;
+
+    AudioUnlock(device, regions);
+    return true;
+}
+
+auto AudioBeginWrite(AudioDevice& device, const AudioWriteRange& range, SoundOutputBuffer& soundBuffer,
+                     AudioWriteSession& session) -> bool
+{
+    session = {};
+    soundBuffer.samplesPerSecond = device.samplesPerSecond;
+    SetContiguousSamples(soundBuffer, nullptr, 0);
+
+    if (range.bytesToWrite == 0)
+    {
+        return false;
+    }
+
+    if (!AudioLock(device, range.byteToLock, range.bytesToWrite, session.regions))
+    {
+        return false;
+    }
+    session.isLocked = true;
+
+    soundBuffer.regions[0] = {(int16_t*)session.regions.region1, (int)(session.regions.region1Size / device.bytesPerSample)};
+    soundBuffer.regions[1] = {(int16_t*)session.regions.region2, (int)(session.regions.region2Size / device.bytesPerSample)};
+    soundBuffer.sampleCount = soundBuffer.regions[0].sampleCount + soundBuffer.regions[1].sampleCount;
+    return true;
+}
+
+void AudioEndWrite(AudioDevice& device, const SoundOutputBuffer& soundBuffer, AudioWriteSession& session)
+{
+    if (session.isLocked)
+    {
+        device.runningSampleIndex += soundBuffer.sampleCount;
+        AudioUnlock(device, session.regions);
+    }
+    session.isLocked = false;
+}
+
+void AudioClear(AudioDevice& device)
+{
+    // The file ring starts zeroed, and clearing it would append a second of silence to the file
+    if (device.backend == AudioBackend::WavFile)
+    {
+        return;
+    }
+
+    AudioRegions regions;
+    if (!AudioLock(device, 0, device.bufferSize, regions))
+    {
+        return;
+    }
+
+    RingSpanZero(AsRingSpan(regions));
+
+    AudioUnlock(device, regions);
+}
+
+#pragma region Calibration
+
+internal uint32_t RingDistance(uint32_t from, uint32_t to, uint32_t size)
+{
+    return to >= from ? to - from : size - from + to;
+}
+
+internal uint32_t AlignUp(uint32_t value, uint32_t alignment)
+{
+    return ((value + alignment - 1) / alignment) * alignment;
+}
+
+internal void UpdateSafetyBytes(AudioDevice& device, AudioCalibration& calibration)
+{
+    double bytesPerSecond = (double)device.samplesPerSecond * device.bytesPerSample;
+
+    // Once we have seen enough frames trust the measured frame time over the target
+    double secondsPerFrame = calibration.targetSecondsPerFrame;
+    double jitterSeconds = 0.0;
+    if (calibration.frameCount >= 16)
+    {
+        secondsPerFrame = calibration.frameMean;
+        jitterSeconds = 3.0 * sqrt(calibration.frameM2 / (calibration.frameCount - 1));
+    }
+
+    uint32_t jitterBytes = (uint32_t)(jitterSeconds * bytesPerSecond);
+    calibration.safetyBytes = AlignUp(calibration.cursorGranularityBytes + jitterBytes, device.bytesPerSample);
+    calibration.expectedBytesPerFrame = AlignUp((uint32_t)(secondsPerFrame * bytesPerSecond), device.bytesPerSample);
+
+    // Never plan further ahead than the ring can hold
+    uint32_t maxAhead = device.bufferSize / 2;
+    if (calibration.safetyBytes + calibration.expectedBytesPerFrame > maxAhead)
+    {
+        calibration.safetyBytes = maxAhead > calibration.expectedBytesPerFrame ? maxAhead - calibration.expectedBytesPerFrame : 0;
+    }
+}
+
+auto AudioCalibrate(AudioDevice& device, float targetSecondsPerFrame, float measureSeconds, AudioCalibration& calibration) -> bool
+{
+    calibration = {};
+    calibration.targetSecondsPerFrame = targetSecondsPerFrame;
+
+    LARGE_INTEGER frequency, start, now;
+    QueryPerformanceFrequency(&frequency);
+    QueryPerformanceCounter(&start);
+
+    uint32_t lastPlayCursor = 0;
+    uint32_t playCursor = 0;
+    uint32_t writeCursor = 0;
+    if (!AudioGetCursors(device, lastPlayCursor, writeCursor))
+    {
+        return false;
+    }
+
+    int stepCount = 0;
+    do
+    {
+        if (!AudioGetCursors(device, playCursor, writeCursor))
+        {
+            return false;
+        }
+
+        uint32_t gap = RingDistance(playCursor, writeCursor, device.bufferSize);
+        if (gap > calibration.writeCursorGapBytes)
+        {
+            calibration.writeCursorGapBytes = gap;
+        }
+
+        if (playCursor != lastPlayCursor)
+        {
+            uint32_t step = RingDistance(lastPlayCursor, playCursor, device.bufferSize);
+            if (step > calibration.cursorGranularityBytes)
+            {
+                calibration.cursorGranularityBytes = step;
+            }
+            lastPlayCursor = playCursor;
+            ++stepCount;
+        }
+
+        QueryPerformanceCounter(&now);
+    } while ((double)(now.QuadPart - start.QuadPart) / (double)frequency.QuadPart < measureSeconds);
+
+    // A cursor that never moved tells us nothing, callers fall back to a fixed latency
+    if (stepCount < 2)
+    {
+        return false;
+    }
+
+    UpdateSafetyBytes(device, calibration);
+    calibration.isCalibrated = true;
+
+    char message[256];
+    snprintf(message, sizeof(message),
+             "Audio calibration: cursor granularity %u bytes, write gap %u bytes, safety %u bytes, %u bytes/frame\n",
+             calibration.cursorGranularityBytes, calibration.writeCursorGapBytes,
+             calibration.safetyBytes, calibration.expectedBytesPerFrame);
+    OutputDebugStringA(message);
+    return true;
+}
+
+void AudioCalibrationObserveFrame(AudioDevice& device, AudioCalibration& calibration, float secondsElapsed)
+{
+    ++calibration.frameCount;
+    double delta = secondsElapsed - calibration.frameMean;
+    calibration.frameMean += delta / calibration.frameCount;
+    calibration.frameM2 += delta * (secondsElapsed - calibration.frameMean);
+
+    if (calibration.isCalibrated)
+    {
+        UpdateSafetyBytes(device, calibration);
+    }
+}
+
+auto AudioComputeCalibratedWriteRange(AudioDevice& device, AudioCalibration& calibration, float secondsSinceFlip,
+                                      AudioWriteRange& range) -> bool
+{
+    uint32_t playCursor = 0;
+    uint32_t writeCursor = 0;
+    if (!AudioGetCursors(device, playCursor, writeCursor))
+    {
+        calibration.isSynced = false;
+        return false;
+    }
+
+    // First frame (or after losing the device): start writing where the card allows us to
+    if (!calibration.isSynced)
+    {
+        device.runningSampleIndex = writeCursor / device.bytesPerSample;
+        calibration.isSynced = true;
+    }
+
+    // Fell behind the play cursor (underrun, debugger stop), skip ahead instead of writing stale audio
+    uint32_t byteToLock = (device.runningSampleIndex * device.bytesPerSample) % device.bufferSize;
+    if (RingDistance(playCursor, byteToLock, device.bufferSize) > device.bufferSize / 2)
+    {
+        device.runningSampleIndex = writeCursor / device.bytesPerSample;
+    }
+
+    double secondsPerFrame = calibration.frameCount >= 16 ? calibration.frameMean : calibration.targetSecondsPerFrame;
+    double secondsUntilFlip = secondsPerFrame - secondsSinceFlip;
+    if (secondsUntilFlip < 0.0)
+    {
+        secondsUntilFlip = 0.0;
+    }
+    uint32_t expectedBytesUntilFlip = (uint32_t)((secondsUntilFlip / secondsPerFrame) * calibration.expectedBytesPerFrame);
+
+    // Work in unwrapped space relative to the play cursor so comparisons are meaningful
+    uint32_t frameBoundaryByte = playCursor + expectedBytesUntilFlip;
+    uint32_t safeWriteCursor = playCursor + RingDistance(playCursor, writeCursor, device.bufferSize) + calibration.safetyBytes;
+
+    uint32_t targetCursor;
+    if (safeWriteCursor < frameBoundaryByte)
+    {
+        // Low latency card: fill exactly up to the flip after next
+        targetCursor = frameBoundaryByte + calibration.expectedBytesPerFrame;
+    }
+    else
+    {
+        // The card can't keep up with our frame, write a frame past the safe cursor instead
+        targetCursor = safeWriteCursor + calibration.expectedBytesPerFrame;
+    }
+    targetCursor = AlignUp(targetCursor, device.bytesPerSample) % device.bufferSize;
+
+    FillWriteRange(device, targetCursor, range);
+
+    // Already written past the target, nothing to do this frame
+    if (RingDistance(playCursor, range.byteToLock, device.bufferSize) > RingDistance(playCursor, targetCursor, device.bufferSize))
+    {
+        range.bytesToWrite = 0;
+    }
+    return true;
+}
+
+#pragma endregion Calibration
+
+#pragma region Virtual devices (Null, WavFile)
+
+/*
+    NOTE: Null and WavFile have no hardware behind them, so the play cursor is
+    simulated from the performance counter as if a card were consuming samples
+    at samplesPerSecond. The write cursor trails it by a fixed 10ms like a real card.
+*/
+
+struct VirtualAudioDevice
+{
+    LARGE_INTEGER frequency;
+    LARGE_INTEGER playStart;
+    uint8_t* ring;
+    uint32_t writeGapBytes;
+    bool writesFile;
+    WavWriter wav;
+};
+
+internal auto VirtualGetCursors(AudioDevice& device, uint32_t& playCursor, uint32_t& writeCursor) -> bool
+{
+    VirtualAudioDevice* state = (VirtualAudioDevice*)device.backendData;
+    if (!device.isPlaying)
+    {
+        playCursor = 0;
+        writeCursor = state->writeGapBytes;
+        return true;
+    }
+
+    LARGE_INTEGER now;
+    QueryPerformanceCounter(&now);
+    uint64_t samplesPlayed = (uint64_t)(now.QuadPart - state->playStart.QuadPart) * device.samplesPerSecond /
+                             (uint64_t)state->frequency.QuadPart;
+
+    playCursor = (uint32_t)((samplesPlayed * device.bytesPerSample) % device.bufferSize);
+    writeCursor = (playCursor + state->writeGapBytes) % device.bufferSize;
+    return true;
+}
+
+internal auto VirtualLock(AudioDevice& device, uint32_t byteToLock, uint32_t bytesToLock, AudioRegions& regions) -> bool
+{
+    VirtualAudioDevice* state = (VirtualAudioDevice*)device.backendData;
+    if (byteToLock >= device.bufferSize || bytesToLock > device.bufferSize)
+    {
+        return false;
+    }
+
+    RingSpan span = RingSplit(state->ring, device.bufferSize, byteToLock, bytesToLock);
+    regions = {span.first, span.firstSize, span.second, span.secondSize};
+    return true;
+}
+
+internal void VirtualUnlock(AudioDevice& device, AudioRegions& regions)
+{
+    VirtualAudioDevice* state = (VirtualAudioDevice*)device.backendData;
+    if (state->writesFile)
+    {
+        WavWrite(state->wav, regions.region1, regions.region1Size);
+        WavWrite(state->wav, regions.region2, regions.region2Size);
+    }
+}
+
+internal auto VirtualPlay(AudioDevice& device) -> bool
+{
+    VirtualAudioDevice* state = (VirtualAudioDevice*)device.backendData;
+    QueryPerformanceCounter(&state->playStart);
+    return true;
+}
+
+internal void VirtualClose(AudioDevice& device)
+{
+    VirtualAudioDevice* state = (VirtualAudioDevice*)device.backendData;
+    if (state->writesFile)
+    {
+        WavClose(state->wav);
+    }
+    VirtualFree(state, 0, MEM_RELEASE);
+}
+
+global const AudioDeviceApi virtualAudioApi = {
+    VirtualGetCursors,
+    VirtualLock,
+    VirtualUnlock,
+    VirtualPlay,
+    VirtualClose,
+};
+
+internal auto OpenVirtualDevice(AudioDevice& device, AudioBackend backend, int samplesPerSecond, uint32_t bufferSize) -> VirtualAudioDevice*
+{
+    // Device state and the ring share one allocation
+    VirtualAudioDevice* state = (VirtualAudioDevice*)VirtualAlloc(nullptr, sizeof(VirtualAudioDevice) + bufferSize,
+                                                                  MEM_COMMIT | MEM_RESERVE, PAGE_READWRITE);
+    if (!state)
+    {
+        OutputDebugStringA("Failed to allocate virtual audio device\n");
+        return nullptr;
+    }
+
+    *state = {};
+    state->ring = (uint8_t*)(state + 1);
+    QueryPerformanceFrequency(&state->frequency);
+
+    device = {};
+    device.backend = backend;
+    device.api = &virtualAudioApi;
+    device.backendData = state;
+    device.samplesPerSecond = samplesPerSecond;
+    device.bufferSize = bufferSize;
+    state->writeGapBytes = (uint32_t)(samplesPerSecond / 100) * device.bytesPerSample;
+    return state;
+}
+
+auto AudioOpenNull(AudioDevice& device, int samplesPerSecond, uint32_t bufferSize) -> bool
+{
+    return OpenVirtualDevice(device, AudioBackend::Null, samplesPerSecond, bufferSize) != nullptr;
+}
+
+auto AudioOpenWavFile(AudioDevice& device, const char* path, int samplesPerSecond, uint32_t bufferSize) -> bool
+{
+    VirtualAudioDevice* state = OpenVirtualDevice(device, AudioBackend::WavFile, samplesPerSecond, bufferSize);
+    if (!state)
+    {
+        return false;
+    }
+
+    if (!WavOpen(state->wav, path, samplesPerSecond, device.channels, 16))
+    {
+        AudioClose(device);
+        return false;
+    }
+    state->writesFile = true;
+    return true;
+}
+
+#pragma endregion Virtual devices
@@ -0,0 +1,179 @@
+#include "audio.h"
+#include <dsound.h>
+
+internal auto InitDSound(HWND hwnd, int sampleRate, int channels, int bufferSize, LPDIRECTSOUNDBUFFER& secondaryBuffer) -> bool
+{
+    // Initialize DirectSound
+    HMODULE dsoundModule = LoadLibraryA("dsound.dll");
+    if (!dsoundModule) {
+        OutputDebugStringA("Failed to load dsound.dll\n");
+        return false;
+    }
+
+    typedef HRESULT(WINAPI* DirectSoundCreateFunc)(LPCGUID, LPDIRECTSOUND*, LPUNKNOWN);
+    DirectSoundCreateFunc DirectSoundCreate = (DirectSoundCreateFunc)GetProcAddress(dsoundModule, "DirectSoundCreate");
+
+    if (!DirectSoundCreate) {
+        OutputDebugStringA("Failed to get DirectSoundCreate function\n");
+        return false;
+    }
+
+    // Create DirectSound object
+    LPDIRECTSOUND directSound;
+    HRESULT hr = DirectSoundCreate(nullptr, &directSound, nullptr);
+    if (FAILED(hr)) {
+        OutputDebugStringA("Failed to create DirectSound object\n");
+        return false;
+    }
+
+    // Set the cooperative level
+    // DSSCL_DEFAULT would use the default cooperative level
+    // DSSCL_PRIORITY is often used for games to ensure low latency and high performance
+    // DSSCL_EXCLUSIVE is used for applications that need exclusive access to the sound device
+    // DSSCL_BACKGROUND is used for applications that do not need exclusive access to the sound device
+    // DSSCL_WRITEPRIMARY is used for applications that need to write to the primary buffer
+    // DSSCL_DEFAULT is used for applications that do not need to set a specific cooperative level
+    hr = directSound->SetCooperativeLevel(hwnd, DSSCL_PRIORITY);
+    if (FAILED(hr)) {
+        OutputDebugStringA("Failed to set cooperative level\n");
+        return false;
+    }
+
+    // Create a primary buffer
+    // The primary buffer is used to control the sound device and set the format
+    // It is not used for playing sound directly, but rather to set the format for secondary buffers
+    
+    DSBUFFERDESC bufferDesc = {};
+    bufferDesc.dwSize = sizeof(DSBUFFERDESC); // Size of the structure
+    //bufferDesc.dwFlags = DSBCAPS_CTRLVOLUME | DSBCAPS_CTRLFREQUENCY | DSBCAPS_CTRLPOSITIONNOTIFY; // Flags for the primary buffer
+    bufferDesc.dwFlags = DSBCAPS_PRIMARYBUFFER; 
+
+
+    LPDIRECTSOUNDBUFFER primaryBuffer;
+    hr = directSound->CreateSoundBuffer(&bufferDesc, &primaryBuffer, nullptr);
+    if (FAILED(hr)) {
+        OutputDebugStringA("Failed to create primary sound buffer\n");
+        return false;
+    }
+
+    // Set the format of the primary buffer
+    WAVEFORMATEX waveFormat = {};
+    waveFormat.wFormatTag = WAVE_FORMAT_PCM;
+    waveFormat.nChannels = channels;
+    waveFormat.nSamplesPerSec = sampleRate;
+    waveFormat.wBitsPerSample = 16; // 16-bit samples
+    waveFormat.nBlockAlign = (waveFormat.nChannels * waveFormat.wBitsPerSample) / 8;
+    waveFormat.nAvgBytesPerSec = waveFormat.nSamplesPerSec * waveFormat.nBlockAlign;
+
+    hr = primaryBuffer->SetFormat(&waveFormat);
+    if (FAILED(hr)) {
+        OutputDebugStringA("Failed to set format on primary sound buffer\n");
+        return false;
+    }
+
+    // Create a secondary buffer
+    // The secondary buffer is used for playing sound
+
+    // Secondary buffers are used to play sound
+    // The primary buffer can be created with different flags and formats
+    // DSBCAPS_PRIMARYBUFFER is used to indicate that this is a primary buffer
+    // DSBCAPS_CTRLVOLUME is used to indicate that the buffer can control volume
+    // DSBCAPS_CTRLFREQUENCY is used to indicate that the buffer can control frequency
+    // DSBCAPS_CTRLPOSITIONNOTIFY is used to indicate that the buffer can control position notifications
+    // DSBCAPS_GLOBALFOCUS is used to indicate that the buffer can be used when the application is not in focus
+    // DSBCAPS_GETCURRENTPOSITION2 is used to indicate that the buffer can get the current position
+    // DSBCAPS_CTRL3D is used to indicate that the buffer can control 3D sound
+    // DSBCAPS_CTRLFX is used to indicate that the buffer can control effects
+    // DSBCAPS_CTRLDEFAULT is used to indicate that the buffer can control default settings
+    // DSBCAPS_CTRLALL is used to indicate that the buffer can control all settings
+    DSBUFFERDESC secondaryBufferDesc = {};
+    secondaryBufferDesc.dwSize = sizeof(DSBUFFERDESC); // Size of the structure
+    secondaryBufferDesc.dwFlags = 0; // No special flags for the secondary buffer
+    secondaryBufferDesc.dwBufferBytes = bufferSize; // Size of the buffer in bytes
+    secondaryBufferDesc.lpwfxFormat = &waveFormat; // Format of the buffer
+
+    
+    hr = directSound->CreateSoundBuffer(&secondaryBufferDesc, &secondaryBuffer, nullptr);
+    if (FAILED(hr)) {
+        OutputDebugStringA("Failed to create secondary sound buffer\n");
+        return false;
+    }
+    return true;
+}
+
+internal auto DSoundGetCursors(AudioDevice& device, uint32_t& playCursor, uint32_t& writeCursor) -> bool
+{
+    LPDIRECTSOUNDBUFFER secondaryBuffer = (LPDIRECTSOUNDBUFFER)device.backendData;
+    DWORD play = 0;
+    DWORD write = 0;
+    if (FAILED(secondaryBuffer->GetCurrentPosition(&play, &write)))
+    {
+        return false;
+    }
+    playCursor = play;
+    writeCursor = write;
+    return true;
+}
+
+internal auto DSoundLock(AudioDevice& device, uint32_t byteToLock, uint32_t bytesToLock, AudioRegions& regions) -> bool
+{
+    LPDIRECTSOUNDBUFFER secondaryBuffer = (LPDIRECTSOUNDBUFFER)device.backendData;
+    DWORD region1Size = 0;
+    DWORD region2Size = 0;
+    if (FAILED(secondaryBuffer->Lock(byteToLock, bytesToLock, &regions.region1, &region1Size, &regions.region2, &region2Size, 0)))
+    {
+        return false;
+    }
+    regions.region1Size = region1Size;
+    regions.region2Size = region2Size;
+    return true;
+}
+
+internal void DSoundUnlock(AudioDevice& device, AudioRegions& regions)
+{
+    LPDIRECTSOUNDBUFFER secondaryBuffer = (LPDIRECTSOUNDBUFFER)device.backendData;
+    secondaryBuffer->Unlock(regions.region1, regions.region1Size, regions.region2, regions.region2Size);
+}
+
+internal auto DSoundPlay(AudioDevice& device) -> bool
+{
+    LPDIRECTSOUNDBUFFER secondaryBuffer = (LPDIRECTSOUNDBUFFER)device.backendData;
+    if (FAILED(secondaryBuffer->Play(0, 0, DSBPLAY_LOOPING)))
+    {
+        OutputDebugStringA("Failed to play sound buffer\n");
+        return false;
+    }
+    return true;
+}
+
+internal void DSoundClose(AudioDevice& device)
+{
+    LPDIRECTSOUNDBUFFER secondaryBuffer = (LPDIRECTSOUNDBUFFER)device.backendData;
+    secondaryBuffer->Stop();
+    secondaryBuffer->Release();
+}
+
+global const AudioDeviceApi directSoundApi = {
+    DSoundGetCursors,
+    DSoundLock,
+    DSoundUnlock,
+    DSoundPlay,
+    DSoundClose,
+};
+
+auto AudioOpenDirectSound(AudioDevice& device, HWND hwnd, int samplesPerSecond, uint32_t bufferSize) -> bool
+{
+    device = {};
+    LPDIRECTSOUNDBUFFER secondaryBuffer = nullptr;
+    if (!InitDSound(hwnd, samplesPerSecond, device.channels, bufferSize, secondaryBuffer))
+    {
+        return false;
+    }
+
+    device.backend = AudioBackend::DirectSound;
+    device.api = &directSoundApi;
+    device.backendData = secondaryBuffer;
+    device.samplesPerSecond = samplesPerSecond;
+    device.bufferSize = bufferSize;
+    return true;
+}
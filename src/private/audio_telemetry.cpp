@@ -0,0 +1,142 @@
+#include "audio_telemetry.h"
+#include <stdio.h>
+
+void AudioTelemetryRecord(AudioTelemetry& telemetry, const AudioDevice& device, uint32_t playCursor, uint32_t writeCursor,
+                          uint32_t queuedEnd, uint32_t bytesWritten, float mixSeconds)
+{
+    AudioTelemetryFrame& frame = telemetry.frames[telemetry.frameCount % AUDIO_TELEMETRY_FRAMES];
+    frame.frameIndex = telemetry.frameCount;
+    frame.playCursor = playCursor;
+    frame.writeCursor = writeCursor;
+    frame.byteToLock = queuedEnd;
+    frame.bytesWritten = bytesWritten;
+    frame.mixMs = mixSeconds * 1000.0f;
+
+    uint32_t size = device.bufferSize;
+    uint32_t queued = queuedEnd >= playCursor ? queuedEnd - playCursor : size - playCursor + queuedEnd;
+    uint32_t untouchable = writeCursor >= playCursor ? writeCursor - playCursor : size - playCursor + writeCursor;
+    // More than half a ring ahead means the play cursor actually lapped what we queued
+    bool lapped = queued > size / 2;
+    float bytesPerMs = (float)(device.samplesPerSecond * device.bytesPerSample) / 1000.0f;
+    frame.marginMs = lapped ? -(float)(size - queued) / bytesPerMs : (float)queued / bytesPerMs;
+    // The very first frame has nothing queued yet, that's not an underrun
+    frame.underrun = telemetry.frameCount > 0 && (lapped || queued < untouchable);
+
+    if (frame.underrun)
+    {
+        ++telemetry.underrunCount;
+    }
+    if (telemetry.frameCount == 1 || (telemetry.frameCount > 1 && frame.marginMs < telemetry.worstMarginMs))
+    {
+        telemetry.worstMarginMs = frame.marginMs;
+    }
+    ++telemetry.frameCount;
+}
+
+internal void FillRect(OffscreenBuffer& buffer, int minX, int minY, int maxX, int maxY, uint32_t color)
+{
+    minX = minX < 0 ? 0 : minX;
+    minY = minY < 0 ? 0 : minY;
+    maxX = maxX > buffer.width ? buffer.width : maxX;
+    maxY = maxY > buffer.height ? buffer.height : maxY;
+    for (int y = minY; y < maxY; ++y)
+    {
+        uint32_t* pixel = (uint32_t*)((uint8_t*)buffer.data + y * buffer.pitch) + minX;
+        for (int x = minX; x < maxX; ++x)
+        {
+            *pixel++ = color;
+        }
+    }
+}
+
+// Halves the brightness so the graph stays readable over anything
+internal void DarkenRect(OffscreenBuffer& buffer, int minX, int minY, int maxX, int maxY)
+{
+    minX = minX < 0 ? 0 : minX;
+    minY = minY < 0 ? 0 : minY;
+    maxX = maxX > buffer.width ? buffer.width : maxX;
+    maxY = maxY > buffer.height ? buffer.height : maxY;
+    for (int y = minY; y < maxY; ++y)
+    {
+        uint32_t* pixel = (uint32_t*)((uint8_t*)buffer.data + y * buffer.pitch) + minX;
+        for (int x = minX; x < maxX; ++x, ++pixel)
+        {
+            *pixel = (*pixel >> 1) & 0x7F7F7F;
+        }
+    }
+}
+
+void AudioTelemetryDraw(const AudioTelemetry& telemetry, OffscreenBuffer& buffer, float targetSecondsPerFrame)
+{
+    if (!buffer.data)
+    {
+        return;
+    }
+
+    // Oldest frame on the left, 2 pixels per frame, two frame budgets of vertical range
+    const int barWidth = 2;
+    const int graphHeight = 120;
+    const int padding = 8;
+    int graphWidth = AUDIO_TELEMETRY_FRAMES * barWidth;
+    int left = padding;
+    int bottom = buffer.height - padding;
+    int top = bottom - graphHeight;
+    float budgetMs = targetSecondsPerFrame * 1000.0f;
+    float pixelsPerMs = graphHeight / (2.0f * budgetMs);
+
+    DarkenRect(buffer, left, top, left + graphWidth, bottom);
+
+    uint64_t shown = telemetry.frameCount < AUDIO_TELEMETRY_FRAMES ? telemetry.frameCount : AUDIO_TELEMETRY_FRAMES;
+    uint64_t first = telemetry.frameCount - shown;
+    for (uint64_t i = 0; i < shown; ++i)
+    {
+        const AudioTelemetryFrame& frame = telemetry.frames[(first + i) % AUDIO_TELEMETRY_FRAMES];
+        int x = left + (int)(AUDIO_TELEMETRY_FRAMES - shown + i) * barWidth;
+        if (frame.underrun)
+        {
+            FillRect(buffer, x, top, x + barWidth, bottom, 0xFF2020);
+            continue;
+        }
+
+        int marginHeight = (int)(frame.marginMs * pixelsPerMs);
+        marginHeight = marginHeight > graphHeight ? graphHeight : marginHeight;
+        FillRect(buffer, x, bottom - marginHeight, x + barWidth, bottom, 0x20C040);
+
+        // Mix cost drawn over the margin, it should stay a sliver at the bottom
+        int mixHeight = (int)(frame.mixMs * pixelsPerMs) + 1;
+        mixHeight = mixHeight > graphHeight ? graphHeight : mixHeight;
+        FillRect(buffer, x, bottom - mixHeight, x + barWidth, bottom, 0xFFD020);
+    }
+
+    // One frame budget
+    int budgetY = bottom - (int)(budgetMs * pixelsPerMs);
+    FillRect(buffer, left, budgetY, left + graphWidth, budgetY + 1, 0xFFFFFF);
+}
+
+auto AudioTelemetryWriteCsv(const AudioTelemetry& telemetry, const char* path) -> bool
+{
+    HANDLE file = CreateFileA(path, GENERIC_WRITE, 0, nullptr, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file == INVALID_HANDLE_VALUE)
+    {
+        OutputDebugStringA("Failed to create audio telemetry csv\n");
+        return false;
+    }
+
+    char line[160];
+    DWORD written;
+    int length = snprintf(line, sizeof(line), "frame,play_cursor,write_cursor,byte_to_lock,bytes_written,mix_ms,margin_ms,underrun\n");
+    bool ok = WriteFile(file, line, (DWORD)length, &written, nullptr);
+
+    uint64_t shown = telemetry.frameCount < AUDIO_TELEMETRY_FRAMES ? telemetry.frameCount : AUDIO_TELEMETRY_FRAMES;
+    for (uint64_t i = telemetry.frameCount - shown; ok && i < telemetry.frameCount; ++i)
+    {
+        const AudioTelemetryFrame& frame = telemetry.frames[i % AUDIO_TELEMETRY_FRAMES];
+        length = snprintf(line, sizeof(line), "%llu,%u,%u,%u,%u,%.3f,%.3f,%d\n",
+                          (unsigned long long)frame.frameIndex, frame.playCursor, frame.writeCursor,
+                          frame.byteToLock, frame.bytesWritten, frame.mixMs, frame.marginMs, frame.underrun ? 1 : 0);
+        ok = WriteFile(file, line, (DWORD)length, &written, nullptr);
+    }
+
+    CloseHandle(file);
+    return ok;
+}
@@ -0,0 +1,350 @@
+#include "capture.h"
+#include "wav.h"
+#include "debug.h"
+#include <string.h>
+
+#define CAPTURE_SLOT_COUNT 8
+#define CAPTURE_AUDIO_SECONDS 4
+
+struct CaptureSlot
+{
+    void* pixels;
+    uint32_t repeatPrevious;    // frames dropped right before this one, written as copies of the last frame
+    bool isEnd;
+};
+
+struct CaptureState
+{
+    bool active;
+    int width;
+    int height;
+
+    CaptureSlot slots[CAPTURE_SLOT_COUNT];
+    int writeIndex;     // only touched by the frame thread
+    int readIndex;      // only touched by the writer thread
+    uint32_t droppedSinceLastSlot;
+
+    HANDLE freeSlots;   // counts slots the frame thread may fill
+    HANDLE readySlots;  // counts slots waiting for the writer
+    HANDLE thread;
+
+    // Audio never waits for a video slot, it has its own single producer ring in stereo frames
+    int16_t* audioRing;
+    int audioCapacity;
+    volatile LONG audioWritePosition;   // only advanced by the frame thread
+    volatile LONG audioReadPosition;    // only advanced by the writer thread
+
+    HANDLE videoFile;
+    WavWriter wav;
+    uint8_t* rgbScratch;
+    DWORD lastFrameBytes;
+
+    uint32_t framesWritten;
+    uint32_t framesDropped;
+    uint32_t samplesDropped;
+};
+
+global CaptureState capture;
+
+internal void WriteVideoFrame(CaptureSlot& slot)
+{
+    DWORD written;
+    // Dropped frames repeat the last one so the video keeps the audio's length
+    for (uint32_t i = 0; i < slot.repeatPrevious && capture.lastFrameBytes; ++i)
+    {
+        WriteFile(capture.videoFile, capture.rgbScratch, capture.lastFrameBytes, &written, nullptr);
+    }
+    if (slot.isEnd)
+    {
+        return;
+    }
+
+    // PPM wants packed RGB, the back buffer is BGRX
+    int headerSize = sprintf((char*)capture.rgbScratch, "P6\n%d %d\n255\n", capture.width, capture.height);
+    uint8_t* out = capture.rgbScratch + headerSize;
+    uint32_t* pixel = (uint32_t*)slot.pixels;
+    int pixelCount = capture.width * capture.height;
+    for (int i = 0; i < pixelCount; ++i)
+    {
+        uint32_t color = *pixel++;
+        *out++ = (uint8_t)(color >> 16);
+        *out++ = (uint8_t)(color >> 8);
+        *out++ = (uint8_t)(color);
+    }
+
+    capture.lastFrameBytes = (DWORD)(out - capture.rgbScratch);
+    WriteFile(capture.videoFile, capture.rgbScratch, capture.lastFrameBytes, &written, nullptr);
+}
+
+internal void DrainAudio()
+{
+    int writePosition = (int)capture.audioWritePosition;
+    MemoryBarrier();
+    int readPosition = (int)capture.audioReadPosition;
+
+    if (writePosition < readPosition)
+    {
+        int count = capture.audioCapacity - readPosition;
+        WavWrite(capture.wav, capture.audioRing + readPosition * 2, count * 2 * sizeof(int16_t));
+        readPosition = 0;
+    }
+    if (writePosition > readPosition)
+    {
+        int count = writePosition - readPosition;
+        WavWrite(capture.wav, capture.audioRing + readPosition * 2, count * 2 * sizeof(int16_t));
+        readPosition = writePosition;
+    }
+
+    MemoryBarrier();
+    capture.audioReadPosition = readPosition;
+}
+
+internal DWORD WINAPI CaptureThreadProc(LPVOID)
+{
+    for (;;)
+    {
+        WaitForSingleObject(capture.readySlots, INFINITE);
+
+        CaptureSlot& slot = capture.slots[capture.readIndex];
+        capture.readIndex = (capture.readIndex + 1) % CAPTURE_SLOT_COUNT;
+
+        WriteVideoFrame(slot);
+        DrainAudio();
+        if (slot.isEnd)
+        {
+            break;
+        }
+        ++capture.framesWritten;
+
+        ReleaseSemaphore(capture.freeSlots, 1, nullptr);
+    }
+    return 0;
+}
+
+internal void FreeCaptureMemory()
+{
+    for (int i = 0; i < CAPTURE_SLOT_COUNT; ++i)
+    {
+        if (capture.slots[i].pixels)
+        {
+            VirtualFree(capture.slots[i].pixels, 0, MEM_RELEASE);
+            capture.slots[i].pixels = nullptr;
+        }
+    }
+    if (capture.rgbScratch)
+    {
+        VirtualFree(capture.rgbScratch, 0, MEM_RELEASE);
+        capture.rgbScratch = nullptr;
+    }
+    if (capture.audioRing)
+    {
+        VirtualFree(capture.audioRing, 0, MEM_RELEASE);
+        capture.audioRing = nullptr;
+    }
+}
+
+auto CaptureStart(const char* basePath, int width, int height, int samplesPerSecond) -> bool
+{
+    if (capture.active)
+    {
+        return true;
+    }
+
+    capture.width = width;
+    capture.height = height;
+    // One slot is always kept empty so a full ring doesn't look empty
+    capture.audioCapacity = samplesPerSecond * CAPTURE_AUDIO_SECONDS + 1;
+
+    size_t pixelBytes = (size_t)width * height * 4;
+    for (int i = 0; i < CAPTURE_SLOT_COUNT; ++i)
+    {
+        CaptureSlot& slot = capture.slots[i];
+        slot.pixels = VirtualAlloc(nullptr, pixelBytes, MEM_COMMIT | MEM_RESERVE, PAGE_READWRITE);
+        slot.repeatPrevious = 0;
+        slot.isEnd = false;
+    }
+    // Worst case PPM header is well under 64 bytes
+    capture.rgbScratch = (uint8_t*)VirtualAlloc(nullptr, (size_t)width * height * 3 + 64, MEM_COMMIT | MEM_RESERVE, PAGE_READWRITE);
+    capture.audioRing = (int16_t*)VirtualAlloc(nullptr, (size_t)capture.audioCapacity * 2 * sizeof(int16_t),
+                                               MEM_COMMIT | MEM_RESERVE, PAGE_READWRITE);
+
+    bool allocated = capture.rgbScratch && capture.audioRing;
+    for (int i = 0; i < CAPTURE_SLOT_COUNT; ++i)
+    {
+        allocated = allocated && capture.slots[i].pixels;
+    }
+    if (!allocated)
+    {
+        OutputDebugStringA("Failed to allocate capture buffers\n");
+        FreeCaptureMemory();
+        return false;
+    }
+
+    char path[MAX_PATH];
+    snprintf(path, sizeof(path), "%s.ppm", basePath);
+    capture.videoFile = CreateFileA(path, GENERIC_WRITE, 0, nullptr, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (capture.videoFile == INVALID_HANDLE_VALUE)
+    {
+        OutputDebugStringA("Failed to create capture video file\n");
+        FreeCaptureMemory();
+        return false;
+    }
+
+    snprintf(path, sizeof(path), "%s.wav", basePath);
+    if (!WavOpen(capture.wav, path, samplesPerSecond, 2, 16))
+    {
+        CloseHandle(capture.videoFile);
+        FreeCaptureMemory();
+        return false;
+    }
+
+    capture.writeIndex = 0;
+    capture.readIndex = 0;
+    capture.droppedSinceLastSlot = 0;
+    capture.audioWritePosition = 0;
+    capture.audioReadPosition = 0;
+    capture.lastFrameBytes = 0;
+    capture.framesWritten = 0;
+    capture.framesDropped = 0;
+    capture.samplesDropped = 0;
+    capture.freeSlots = CreateSemaphoreA(nullptr, CAPTURE_SLOT_COUNT, CAPTURE_SLOT_COUNT, nullptr);
+    capture.readySlots = CreateSemaphoreA(nullptr, 0, CAPTURE_SLOT_COUNT, nullptr);
+    capture.thread = CreateThread(nullptr, 0, CaptureThreadProc, nullptr, 0, nullptr);
+
+    capture.active = true;
+    return true;
+}
+
+void CaptureAudio(const SoundOutputBuffer& soundBuffer)
+{
+    if (!capture.active)
+    {
+        return;
+    }
+
+    int writePosition = (int)capture.audioWritePosition;
+    int readPosition = (int)capture.audioReadPosition;
+    MemoryBarrier();
+    int freeCount = (readPosition - writePosition - 1 + capture.audioCapacity) % capture.audioCapacity;
+
+    for (const SoundRegion& region : soundBuffer.regions)
+    {
+        if (!region.samples)
+        {
+            continue;
+        }
+
+        int count = region.sampleCount;
+        if (count > freeCount)
+        {
+            // The writer is seconds behind, nothing left to do but lose the tail
+            capture.samplesDropped += count - freeCount;
+            count = freeCount;
+        }
+        freeCount -= count;
+
+        int16_t* src = region.samples;
+        while (count > 0)
+        {
+            int run = capture.audioCapacity - writePosition;
+            if (run > count)
+            {
+                run = count;
+            }
+            memcpy(capture.audioRing + writePosition * 2, src, (size_t)run * 2 * sizeof(int16_t));
+            src += run * 2;
+            count -= run;
+            writePosition = (writePosition + run) % capture.audioCapacity;
+        }
+    }
+
+    MemoryBarrier();
+    capture.audioWritePosition = writePosition;
+}
+
+void CaptureFrame(const OffscreenBuffer& buffer)
+{
+    if (!capture.active)
+    {
+        return;
+    }
+
+    // Never stall the frame: if the writer is behind, drop this frame and repeat the last one later
+    if (WaitForSingleObject(capture.freeSlots, 0) != WAIT_OBJECT_0)
+    {
+        ++capture.framesDropped;
+        ++capture.droppedSinceLastSlot;
+        return;
+    }
+
+    CaptureSlot& slot = capture.slots[capture.writeIndex];
+    capture.writeIndex = (capture.writeIndex + 1) % CAPTURE_SLOT_COUNT;
+    slot.repeatPrevious = capture.droppedSinceLastSlot;
+    slot.isEnd = false;
+    capture.droppedSinceLastSlot = 0;
+
+    if (buffer.width != capture.width || buffer.height != capture.height)
+    {
+        // Still have to hand the slot over, write black rather than desync the audio
+        memset(slot.pixels, 0, (size_t)capture.width * capture.height * 4);
+        ReleaseSemaphore(capture.readySlots, 1, nullptr);
+        return;
+    }
+
+    int rowBytes = buffer.width * buffer.bpp;
+    if (buffer.pitch == rowBytes)
+    {
+        memcpy(slot.pixels, buffer.data, (size_t)rowBytes * buffer.height);
+    }
+    else
+    {
+        uint8_t* src = (uint8_t*)buffer.data;
+        uint8_t* dst = (uint8_t*)slot.pixels;
+        for (int y = 0; y < buffer.height; ++y)
+        {
+            memcpy(dst, src, rowBytes);
+            src += buffer.pitch;
+            dst += rowBytes;
+        }
+    }
+
+    ReleaseSemaphore(capture.readySlots, 1, nullptr);
+}
+
+void CaptureStop()
+{
+    if (!capture.active)
+    {
+        return;
+    }
+
+    // Queue an end marker behind the pending frames so the writer drains them and the audio first
+    WaitForSingleObject(capture.freeSlots, INFINITE);
+    CaptureSlot& end = capture.slots[capture.writeIndex];
+    end.repeatPrevious = capture.droppedSinceLastSlot;
+    end.isEnd = true;
+    capture.writeIndex = (capture.writeIndex + 1) % CAPTURE_SLOT_COUNT;
+    capture.droppedSinceLastSlot = 0;
+    ReleaseSemaphore(capture.readySlots, 1, nullptr);
+
+    WaitForSingleObject(capture.thread, INFINITE);
+    CloseHandle(capture.thread);
+    CloseHandle(capture.freeSlots);
+    CloseHandle(capture.readySlots);
+
+    CloseHandle(capture.videoFile);
+    WavClose(capture.wav);
+    FreeCaptureMemory();
+
+    char message[160];
+    snprintf(message, sizeof(message), "Capture stopped: %u frames written, %u repeated for drops, %u samples lost\n",
+             capture.framesWritten, capture.framesDropped, capture.samplesDropped);
+    OutputDebugStringA(message);
+
+    capture.active = false;
+}
+
+auto CaptureIsActive() -> bool
+{
+    return capture.active;
+}
@@ -0,0 +1,297 @@
+#include "collision.h"
+#include "radix_sort.h"
+#include "simd.h"
+
+#define CONTACTS_PER_COLLIDER 8
+
+// Colliders in grid order, everything the pair walk reads
+struct SortedColliders
+{
+    float* minX;    // swept box
+    float* minY;
+    float* maxX;
+    float* maxY;
+    float* positionX;
+    float* positionY;
+    float* moveX;   // displacement over the frame
+    float* moveY;
+    float* radius;
+    uint32_t* regionIndex;
+};
+
+auto SweptAabb(v2 offset, v2 move, float combinedRadius, float& t, v2& normal) -> bool
+{
+    float enterX, exitX, enterY, exitY;
+    if (move.x == 0.0f)
+    {
+        if (fabsf(offset.x) > combinedRadius)
+        {
+            return false;
+        }
+        enterX = -INFINITY;
+        exitX = INFINITY;
+    }
+    else
+    {
+        float t0 = (-combinedRadius - offset.x) / move.x;
+        float t1 = (combinedRadius - offset.x) / move.x;
+        enterX = Minimum(t0, t1);
+        exitX = Maximum(t0, t1);
+    }
+    if (move.y == 0.0f)
+    {
+        if (fabsf(offset.y) > combinedRadius)
+        {
+            return false;
+        }
+        enterY = -INFINITY;
+        exitY = INFINITY;
+    }
+    else
+    {
+        float t0 = (-combinedRadius - offset.y) / move.y;
+        float t1 = (combinedRadius - offset.y) / move.y;
+        enterY = Minimum(t0, t1);
+        exitY = Maximum(t0, t1);
+    }
+
+    float enter = Maximum(enterX, enterY);
+    float exit = Minimum(exitX, exitY);
+    if (enter > exit || enter > 1.0f || exit < 0.0f)
+    {
+        return false;
+    }
+
+    if (enter < 0.0f)
+    {
+        // Already overlapping, push out along the shallower axis
+        t = 0.0f;
+        float penetrationX = combinedRadius - fabsf(offset.x);
+        float penetrationY = combinedRadius - fabsf(offset.y);
+        normal = penetrationX < penetrationY ? V2(offset.x < 0.0f ? -1.0f : 1.0f, 0.0f)
+                                             : V2(0.0f, offset.y < 0.0f ? -1.0f : 1.0f);
+    }
+    else
+    {
+        t = enter;
+        normal = enterX > enterY ? V2(move.x > 0.0f ? -1.0f : 1.0f, 0.0f) : V2(0.0f, move.y > 0.0f ? -1.0f : 1.0f);
+    }
+    return true;
+}
+
+internal void NarrowPhase(const SortedColliders& sorted, uint32_t i, uint32_t j, ContactList& list, uint32_t capacity)
+{
+    ++list.candidateCount;
+    v2 offset = V2(sorted.positionX[i] - sorted.positionX[j], sorted.positionY[i] - sorted.positionY[j]);
+    v2 move = V2(sorted.moveX[i] - sorted.moveX[j], sorted.moveY[i] - sorted.moveY[j]);
+    float t;
+    v2 normal;
+    if (SweptAabb(offset, move, sorted.radius[i] + sorted.radius[j], t, normal))
+    {
+        if (list.count == capacity)
+        {
+            ++list.droppedCount;
+            return;
+        }
+        list.contacts[list.count++] = {sorted.regionIndex[i], sorted.regionIndex[j], t, normal};
+    }
+}
+
+// Swept box overlap of i against sorted colliders [first, end), four at a time. The columns are
+// padded so the last group can read past end, those lanes are masked off.
+internal void TestRange(const SortedColliders& sorted, uint32_t i, uint32_t first, uint32_t end, ContactList& list,
+                        uint32_t capacity)
+{
+    __m128 minX = _mm_set1_ps(sorted.minX[i]);
+    __m128 minY = _mm_set1_ps(sorted.minY[i]);
+    __m128 maxX = _mm_set1_ps(sorted.maxX[i]);
+    __m128 maxY = _mm_set1_ps(sorted.maxY[i]);
+    for (uint32_t j = first; j < end; j += 4)
+    {
+        __m128 overlapX = _mm_and_ps(_mm_cmple_ps(_mm_loadu_ps(sorted.minX + j), maxX),
+                                     _mm_cmple_ps(minX, _mm_loadu_ps(sorted.maxX + j)));
+        __m128 overlapY = _mm_and_ps(_mm_cmple_ps(_mm_loadu_ps(sorted.minY + j), maxY),
+                                     _mm_cmple_ps(minY, _mm_loadu_ps(sorted.maxY + j)));
+        uint32_t hits = (uint32_t)_mm_movemask_ps(_mm_and_ps(overlapX, overlapY));
+        if (end - j < 4)
+        {
+            hits &= (1u << (end - j)) - 1;
+        }
+        while (hits)
+        {
+            NarrowPhase(sorted, i, j + __builtin_ctz(hits), list, capacity);
+            hits &= hits - 1;
+        }
+    }
+}
+
+auto FindSimContacts(MemoryArena& scratchArena, SimRegion& region, float seconds) -> ContactList
+{
+    ContactList list = {};
+
+    // Swept boxes of everything that collides, and the extent of their centers
+    uint32_t* colliders = PushArray(scratchArena, region.count, uint32_t);
+    uint32_t colliderCount = 0;
+    float maxSide = 0.0f;
+    v2 minCenter = V2(INFINITY, INFINITY);
+    v2 maxCenter = V2(-INFINITY, -INFINITY);
+    for (uint32_t i = 0; i < region.count; ++i)
+    {
+        if (!(region.flags[i] & EntityFlag_Collides))
+        {
+            continue;
+        }
+        colliders[colliderCount++] = i;
+        float moveX = region.velocityX[i] * seconds;
+        float moveY = region.velocityY[i] * seconds;
+        float sideX = 2.0f * region.radius[i] + fabsf(moveX);
+        float sideY = 2.0f * region.radius[i] + fabsf(moveY);
+        maxSide = Maximum(maxSide, Maximum(sideX, sideY));
+        v2 center = V2(region.positionX[i] + 0.5f * moveX, region.positionY[i] + 0.5f * moveY);
+        minCenter = V2(Minimum(minCenter.x, center.x), Minimum(minCenter.y, center.y));
+        maxCenter = V2(Maximum(maxCenter.x, center.x), Maximum(maxCenter.y, center.y));
+    }
+    if (colliderCount < 2)
+    {
+        return list;
+    }
+
+    // About two colliders per cell, cells never smaller than the largest swept box
+    v2 extent = maxCenter - minCenter;
+    float cellSide = Maximum(maxSide, sqrtf(2.0f * extent.x * extent.y / (float)colliderCount));
+    cellSide = Maximum(cellSide, 1e-3f);
+    uint32_t width, height;
+    for (;;)
+    {
+        width = (uint32_t)(extent.x / cellSide) + 1;
+        height = (uint32_t)(extent.y / cellSide) + 1;
+        // Long thin spreads can still blow up the cell count, keep the table in line with the colliders
+        if ((uint64_t)width * height <= 4 * (uint64_t)colliderCount + 1024)
+        {
+            break;
+        }
+        cellSide *= 2.0f;
+    }
+    uint32_t cellCount = width * height;
+    float inverseCellSide = 1.0f / cellSide;
+
+    uint32_t* keys = PushArray(scratchArena, colliderCount, uint32_t);
+    uint32_t* values = PushArray(scratchArena, colliderCount, uint32_t);
+    uint32_t* scratchKeys = PushArray(scratchArena, colliderCount, uint32_t);
+    uint32_t* scratchValues = PushArray(scratchArena, colliderCount, uint32_t);
+    for (uint32_t k = 0; k < colliderCount; ++k)
+    {
+        uint32_t i = colliders[k];
+        float centerX = region.positionX[i] + 0.5f * region.velocityX[i] * seconds;
+        float centerY = region.positionY[i] + 0.5f * region.velocityY[i] * seconds;
+        uint32_t cellX = (uint32_t)((centerX - minCenter.x) * inverseCellSide);
+        uint32_t cellY = (uint32_t)((centerY - minCenter.y) * inverseCellSide);
+        cellX = cellX < width ? cellX : width - 1;
+        cellY = cellY < height ? cellY : height - 1;
+        keys[k] = cellY * width + cellX;
+        values[k] = i;
+    }
+    RadixSort(keys, values, scratchKeys, scratchValues, colliderCount, cellCount - 1);
+
+    SortedColliders sorted;
+    uint32_t paddedCount = colliderCount + 3;
+    sorted.minX = PushArray(scratchArena, paddedCount, float);
+    sorted.minY = PushArray(scratchArena, paddedCount, float);
+    sorted.maxX = PushArray(scratchArena, paddedCount, float);
+    sorted.maxY = PushArray(scratchArena, paddedCount, float);
+    sorted.positionX = PushArray(scratchArena, colliderCount, float);
+    sorted.positionY = PushArray(scratchArena, colliderCount, float);
+    sorted.moveX = PushArray(scratchArena, colliderCount, float);
+    sorted.moveY = PushArray(scratchArena, colliderCount, float);
+    sorted.radius = PushArray(scratchArena, colliderCount, float);
+    sorted.regionIndex = values;
+    for (uint32_t k = 0; k < colliderCount; ++k)
+    {
+        uint32_t i = values[k];
+        float x = region.positionX[i];
+        float y = region.positionY[i];
+        float moveX = region.velocityX[i] * seconds;
+        float moveY = region.velocityY[i] * seconds;
+        float radius = region.radius[i];
+        sorted.positionX[k] = x;
+        sorted.positionY[k] = y;
+        sorted.moveX[k] = moveX;
+        sorted.moveY[k] = moveY;
+        sorted.radius[k] = radius;
+        sorted.minX[k] = x - radius + Minimum(moveX, 0.0f);
+        sorted.minY[k] = y - radius + Minimum(moveY, 0.0f);
+        sorted.maxX[k] = x + radius + Maximum(moveX, 0.0f);
+        sorted.maxY[k] = y + radius + Maximum(moveY, 0.0f);
+    }
+
+    // cellStart[c] is the first sorted collider in cell c or after it
+    uint32_t* cellStart = PushArray(scratchArena, cellCount + 1, uint32_t);
+    uint32_t first = 0;
+    for (uint32_t cell = 0; cell <= cellCount; ++cell)
+    {
+        while (first < colliderCount && keys[first] < cell)
+        {
+            ++first;
+        }
+        cellStart[cell] = first;
+    }
+
+    uint32_t capacity = CONTACTS_PER_COLLIDER * colliderCount;
+    list.contacts = PushArray(scratchArena, capacity, Contact);
+    for (uint32_t i = 0; i < colliderCount; ++i)
+    {
+        uint32_t cell = keys[i];
+        uint32_t cellX = cell % width;
+        uint32_t cellY = cell / width;
+
+        // The rest of this cell and the one to the right sit next to each other in sorted order,
+        // and so do the three cells above
+        uint32_t sameRowEnd = cellStart[cell + (cellX + 1 < width ? 2 : 1)];
+        TestRange(sorted, i, i + 1, sameRowEnd, list, capacity);
+        if (cellY + 1 < height)
+        {
+            uint32_t firstCell = cell + width - (cellX > 0 ? 1 : 0);
+            uint32_t lastCell = cell + width + (cellX + 1 < width ? 1 : 0);
+            TestRange(sorted, i, cellStart[firstCell], cellStart[lastCell + 1], list, capacity);
+        }
+    }
+    return list;
+}
+
+void ResolveSimContacts(SimRegion& region, ContactList& contacts)
+{
+    for (uint32_t c = 0; c < contacts.count; ++c)
+    {
+        Contact& contact = contacts.contacts[c];
+        uint32_t a = contact.a;
+        uint32_t b = contact.b;
+        v2 velocityA = V2(region.velocityX[a], region.velocityY[a]);
+        v2 velocityB = V2(region.velocityX[b], region.velocityY[b]);
+        float approach = Inner(velocityA - velocityB, contact.normal);
+        if (approach >= 0.0f)
+        {
+            // Already separating, an earlier contact this frame took care of it
+            continue;
+        }
+
+        bool aMoves = (region.flags[a] & EntityFlag_Moving) != 0;
+        bool bMoves = (region.flags[b] & EntityFlag_Moving) != 0;
+        if (aMoves && bMoves)
+        {
+            velocityA -= approach * contact.normal;
+            velocityB += approach * contact.normal;
+        }
+        else if (aMoves)
+        {
+            velocityA -= 2.0f * approach * contact.normal;
+        }
+        else if (bMoves)
+        {
+            velocityB += 2.0f * approach * contact.normal;
+        }
+        region.velocityX[a] = velocityA.x;
+        region.velocityY[a] = velocityA.y;
+        region.velocityX[b] = velocityB.x;
+        region.velocityY[b] = velocityB.y;
+    }
+}
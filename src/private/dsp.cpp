@@ -0,0 +1,392 @@
+#include "dsp.h"
+#include "simd.h"
+#include <math.h>
+
+internal float DbToLinear(float db)
+{
+    return powf(10.0f, db / 20.0f);
+}
+
+// Smoothing coefficient for a one pole filter updated once per sub block
+internal float SubBlockCoefficient(float samplesPerSecond, float seconds)
+{
+    if (seconds <= 0.0f)
+    {
+        return 0.0f;
+    }
+    return expf(-(float)DSP_SUB_BLOCK / (seconds * samplesPerSecond));
+}
+
+internal float PeakAbs(const float* left, const float* right, int frameCount)
+{
+    __m128 signMask = _mm_set1_ps(-0.0f);
+    __m128 peak = _mm_setzero_ps();
+    for (int i = 0; i < frameCount; i += 4)
+    {
+        peak = _mm_max_ps(peak, _mm_andnot_ps(signMask, _mm_load_ps(left + i)));
+        peak = _mm_max_ps(peak, _mm_andnot_ps(signMask, _mm_load_ps(right + i)));
+    }
+    peak = _mm_max_ps(peak, _mm_shuffle_ps(peak, peak, _MM_SHUFFLE(1, 0, 3, 2)));
+    peak = _mm_max_ps(peak, _mm_shuffle_ps(peak, peak, _MM_SHUFFLE(2, 3, 0, 1)));
+    return _mm_cvtss_f32(peak);
+}
+
+// Multiplies by a gain that moves linearly from start to end across the frames
+internal void ApplyGainRamp(float* left, float* right, int frameCount, float start, float end)
+{
+    float step = (end - start) / (float)frameCount;
+    __m128 gain = _mm_setr_ps(start, start + step, start + 2.0f * step, start + 3.0f * step);
+    __m128 gainStep = _mm_set1_ps(4.0f * step);
+    for (int i = 0; i < frameCount; i += 4)
+    {
+        _mm_store_ps(left + i, _mm_mul_ps(_mm_load_ps(left + i), gain));
+        _mm_store_ps(right + i, _mm_mul_ps(_mm_load_ps(right + i), gain));
+        gain = _mm_add_ps(gain, gainStep);
+    }
+}
+
+void MixAddScaled(float* outLeft, float* outRight, const float* inLeft, const float* inRight, float gain, int frameCount)
+{
+    __m128 g = _mm_set1_ps(gain);
+    for (int i = 0; i < frameCount; i += 4)
+    {
+        _mm_store_ps(outLeft + i, _mm_add_ps(_mm_load_ps(outLeft + i), _mm_mul_ps(_mm_load_ps(inLeft + i), g)));
+        _mm_store_ps(outRight + i, _mm_add_ps(_mm_load_ps(outRight + i), _mm_mul_ps(_mm_load_ps(inRight + i), g)));
+    }
+}
+
+#pragma region Biquad
+
+void BiquadSet(Biquad& biquad, BiquadType type, float samplesPerSecond, float frequency, float q, float gainDb)
+{
+    // Robert Bristow-Johnson's audio EQ cookbook
+    double w0 = 2.0 * M_PI * frequency / samplesPerSecond;
+    double cosW0 = cos(w0);
+    double alpha = sin(w0) / (2.0 * q);
+    double A = pow(10.0, gainDb / 40.0);
+    double sqrtA2Alpha = 2.0 * sqrt(A) * alpha;
+
+    double b0 = 1, b1 = 0, b2 = 0, a0 = 1, a1 = 0, a2 = 0;
+    switch (type)
+    {
+        case BiquadType::LowPass:
+            b0 = (1.0 - cosW0) / 2.0; b1 = 1.0 - cosW0; b2 = b0;
+            a0 = 1.0 + alpha; a1 = -2.0 * cosW0; a2 = 1.0 - alpha;
+            break;
+        case BiquadType::HighPass:
+            b0 = (1.0 + cosW0) / 2.0; b1 = -(1.0 + cosW0); b2 = b0;
+            a0 = 1.0 + alpha; a1 = -2.0 * cosW0; a2 = 1.0 - alpha;
+            break;
+        case BiquadType::Peaking:
+            b0 = 1.0 + alpha * A; b1 = -2.0 * cosW0; b2 = 1.0 - alpha * A;
+            a0 = 1.0 + alpha / A; a1 = -2.0 * cosW0; a2 = 1.0 - alpha / A;
+            break;
+        case BiquadType::LowShelf:
+            b0 = A * ((A + 1) - (A - 1) * cosW0 + sqrtA2Alpha);
+            b1 = 2 * A * ((A - 1) - (A + 1) * cosW0);
+            b2 = A * ((A + 1) - (A - 1) * cosW0 - sqrtA2Alpha);
+            a0 = (A + 1) + (A - 1) * cosW0 + sqrtA2Alpha;
+            a1 = -2 * ((A - 1) + (A + 1) * cosW0);
+            a2 = (A + 1) + (A - 1) * cosW0 - sqrtA2Alpha;
+            break;
+        case BiquadType::HighShelf:
+            b0 = A * ((A + 1) + (A - 1) * cosW0 + sqrtA2Alpha);
+            b1 = -2 * A * ((A - 1) + (A + 1) * cosW0);
+            b2 = A * ((A + 1) + (A - 1) * cosW0 - sqrtA2Alpha);
+            a0 = (A + 1) - (A - 1) * cosW0 + sqrtA2Alpha;
+            a1 = 2 * ((A - 1) - (A + 1) * cosW0);
+            a2 = (A + 1) - (A - 1) * cosW0 - sqrtA2Alpha;
+            break;
+    }
+
+    // Only coefficients change, the filter state carries on so sweeps don't click
+    biquad.b0 = (float)(b0 / a0);
+    biquad.b1 = (float)(b1 / a0);
+    biquad.b2 = (float)(b2 / a0);
+    biquad.a1 = (float)(a1 / a0);
+    biquad.a2 = (float)(a2 / a0);
+}
+
+void BiquadProcess(Biquad& biquad, float* left, float* right, int frameCount)
+{
+    // Transposed direct form II, left and right in lanes 0 and 1
+    __m128 b0 = _mm_set1_ps(biquad.b0);
+    __m128 b1 = _mm_set1_ps(biquad.b1);
+    __m128 b2 = _mm_set1_ps(biquad.b2);
+    __m128 a1 = _mm_set1_ps(biquad.a1);
+    __m128 a2 = _mm_set1_ps(biquad.a2);
+    __m128 z1 = _mm_loadu_ps(biquad.z1);
+    __m128 z2 = _mm_loadu_ps(biquad.z2);
+
+    for (int i = 0; i < frameCount; ++i)
+    {
+        __m128 x = _mm_unpacklo_ps(_mm_load_ss(left + i), _mm_load_ss(right + i));
+        __m128 y = _mm_add_ps(_mm_mul_ps(b0, x), z1);
+        z1 = _mm_add_ps(_mm_sub_ps(_mm_mul_ps(b1, x), _mm_mul_ps(a1, y)), z2);
+        z2 = _mm_sub_ps(_mm_mul_ps(b2, x), _mm_mul_ps(a2, y));
+        _mm_store_ss(left + i, y);
+        _mm_store_ss(right + i, _mm_shuffle_ps(y, y, _MM_SHUFFLE(1, 1, 1, 1)));
+    }
+
+    _mm_storeu_ps(biquad.z1, z1);
+    _mm_storeu_ps(biquad.z2, z2);
+}
+
+#pragma endregion Biquad
+
+#pragma region Dynamics
+
+void CompressorSet(Compressor& compressor, float samplesPerSecond, float thresholdDb, float ratio,
+                   float attackSeconds, float releaseSeconds, float makeupDb)
+{
+    compressor.threshold = DbToLinear(thresholdDb);
+    compressor.ratio = ratio < 1.0f ? 1.0f : ratio;
+    compressor.attack = SubBlockCoefficient(samplesPerSecond, attackSeconds);
+    compressor.release = SubBlockCoefficient(samplesPerSecond, releaseSeconds);
+    compressor.makeupGain = DbToLinear(makeupDb);
+    if (compressor.gain == 0.0f)
+    {
+        compressor.gain = compressor.makeupGain;
+    }
+}
+
+void CompressorProcess(Compressor& compressor, float* left, float* right, int frameCount)
+{
+    // Stereo linked peak compressor, gain is recomputed every sub block and ramped across it
+    for (int at = 0; at < frameCount; at += DSP_SUB_BLOCK)
+    {
+        float peak = PeakAbs(left + at, right + at, DSP_SUB_BLOCK);
+        float coefficient = peak > compressor.envelope ? compressor.attack : compressor.release;
+        compressor.envelope = coefficient * compressor.envelope + (1.0f - coefficient) * peak;
+
+        float target = compressor.makeupGain;
+        if (compressor.envelope > compressor.threshold)
+        {
+            // Above threshold the output level grows 1/ratio as fast as the input
+            float over = compressor.envelope / compressor.threshold;
+            target *= powf(over, 1.0f / compressor.ratio - 1.0f);
+        }
+
+        ApplyGainRamp(left + at, right + at, DSP_SUB_BLOCK, compressor.gain, target);
+        compressor.gain = target;
+    }
+}
+
+void LimiterSet(Limiter& limiter, float samplesPerSecond, float ceilingDb, float releaseSeconds)
+{
+    limiter.ceiling = DbToLinear(ceilingDb);
+    limiter.release = SubBlockCoefficient(samplesPerSecond, releaseSeconds);
+    if (limiter.gain == 0.0f)
+    {
+        limiter.gain = 1.0f;
+    }
+}
+
+void LimiterProcess(Limiter& limiter, float* left, float* right, int frameCount)
+{
+    for (int at = 0; at < frameCount; at += DSP_SUB_BLOCK)
+    {
+        // Recover towards unity, but never above what keeps this sub block under the ceiling.
+        // The gain is constant over the sub block so nothing can slip past it.
+        float gain = 1.0f - limiter.release * (1.0f - limiter.gain);
+        float peak = PeakAbs(left + at, right + at, DSP_SUB_BLOCK);
+        if (peak * gain > limiter.ceiling)
+        {
+            gain = limiter.ceiling / peak;
+        }
+
+        ApplyGainRamp(left + at, right + at, DSP_SUB_BLOCK, gain, gain);
+        limiter.gain = gain;
+    }
+}
+
+#pragma endregion Dynamics
+
+#pragma region Reverb
+
+// Freeverb tunings at 44.1kHz, the right channel is spread a little longer
+global const int reverbCombTuning[REVERB_COMB_COUNT] = {1116, 1188, 1277, 1356};
+global const int reverbAllpassTuning[REVERB_ALLPASS_COUNT] = {556, 441};
+#define REVERB_STEREO_SPREAD 23
+
+internal void InitializeDelayLine(DelayLine& line, MemoryArena& arena, int tuning, int samplesPerSecond)
+{
+    int length = (int)((int64_t)tuning * samplesPerSecond / 44100);
+    line.length = (length + 3) & ~3;
+    line.buffer = PushArray(arena, line.length, float);
+    line.index = 0;
+}
+
+void ReverbInitialize(Reverb& reverb, MemoryArena& arena, int samplesPerSecond, int maxFrameCount)
+{
+    for (int channel = 0; channel < 2; ++channel)
+    {
+        int spread = channel * REVERB_STEREO_SPREAD;
+        for (int i = 0; i < REVERB_COMB_COUNT; ++i)
+        {
+            InitializeDelayLine(reverb.combs[channel][i], arena, reverbCombTuning[i] + spread, samplesPerSecond);
+        }
+        for (int i = 0; i < REVERB_ALLPASS_COUNT; ++i)
+        {
+            InitializeDelayLine(reverb.allpasses[channel][i], arena, reverbAllpassTuning[i] + spread, samplesPerSecond);
+        }
+    }
+    for (float*& scratch : reverb.scratch)
+    {
+        scratch = PushArray(arena, maxFrameCount, float);
+    }
+    ReverbSet(reverb, 0.5f, 0.25f, 1.0f);
+}
+
+void ReverbSet(Reverb& reverb, float roomSize, float wet, float dry)
+{
+    reverb.feedback = 0.7f + 0.28f * roomSize;
+    reverb.wet = wet;
+    reverb.dry = dry;
+}
+
+/*
+    Feedback comb: out = line[n - D], line[n] = in + feedback * line[n - D].
+    Every line is at least 4 frames long and a multiple of 4, so four consecutive
+    frames never depend on each other and never wrap inside a group.
+*/
+internal void ProcessComb(DelayLine& line, const float* input, float* output, float feedback, int frameCount)
+{
+    __m128 g = _mm_set1_ps(feedback);
+    for (int i = 0; i < frameCount; i += 4)
+    {
+        float* at = line.buffer + line.index;
+        __m128 delayed = _mm_load_ps(at);
+        _mm_store_ps(output + i, _mm_add_ps(_mm_load_ps(output + i), delayed));
+        _mm_store_ps(at, _mm_add_ps(_mm_load_ps(input + i), _mm_mul_ps(g, delayed)));
+
+        line.index += 4;
+        if (line.index >= line.length)
+        {
+            line.index = 0;
+        }
+    }
+}
+
+// Schroeder allpass in place: out = line[n - D] - in, line[n] = in + 0.5 * line[n - D]
+internal void ProcessAllpass(DelayLine& line, float* samples, int frameCount)
+{
+    __m128 g = _mm_set1_ps(0.5f);
+    for (int i = 0; i < frameCount; i += 4)
+    {
+        float* at = line.buffer + line.index;
+        __m128 delayed = _mm_load_ps(at);
+        __m128 in = _mm_load_ps(samples + i);
+        _mm_store_ps(samples + i, _mm_sub_ps(delayed, in));
+        _mm_store_ps(at, _mm_add_ps(in, _mm_mul_ps(g, delayed)));
+
+        line.index += 4;
+        if (line.index >= line.length)
+        {
+            line.index = 0;
+        }
+    }
+}
+
+void ReverbProcess(Reverb& reverb, float* left, float* right, int frameCount)
+{
+    float* input = reverb.scratch[0];
+    float* wet[2] = {reverb.scratch[1], reverb.scratch[2]};
+
+    // Mono send into both banks, scaled down so the parallel combs don't blow up
+    __m128 inputGain = _mm_set1_ps(0.015f);
+    for (int i = 0; i < frameCount; i += 4)
+    {
+        __m128 sum = _mm_add_ps(_mm_load_ps(left + i), _mm_load_ps(right + i));
+        _mm_store_ps(input + i, _mm_mul_ps(sum, inputGain));
+        _mm_store_ps(wet[0] + i, _mm_setzero_ps());
+        _mm_store_ps(wet[1] + i, _mm_setzero_ps());
+    }
+
+    for (int channel = 0; channel < 2; ++channel)
+    {
+        for (DelayLine& comb : reverb.combs[channel])
+        {
+            ProcessComb(comb, input, wet[channel], reverb.feedback, frameCount);
+        }
+        for (DelayLine& allpass : reverb.allpasses[channel])
+        {
+            ProcessAllpass(allpass, wet[channel], frameCount);
+        }
+    }
+
+    __m128 dryGain = _mm_set1_ps(reverb.dry);
+    __m128 wetGain = _mm_set1_ps(reverb.wet);
+    for (int i = 0; i < frameCount; i += 4)
+    {
+        _mm_store_ps(left + i, _mm_add_ps(_mm_mul_ps(_mm_load_ps(left + i), dryGain), _mm_mul_ps(_mm_load_ps(wet[0] + i), wetGain)));
+        _mm_store_ps(right + i, _mm_add_ps(_mm_mul_ps(_mm_load_ps(right + i), dryGain), _mm_mul_ps(_mm_load_ps(wet[1] + i), wetGain)));
+    }
+}
+
+#pragma endregion Reverb
+
+#pragma region Chain
+
+internal auto AddEffect(EffectChain& chain, EffectType type, void* state) -> bool
+{
+    if (chain.count >= DSP_MAX_EFFECTS)
+    {
+        return false;
+    }
+    chain.effects[chain.count++] = {type, true, state};
+    return true;
+}
+
+auto EffectChainAddBiquad(EffectChain& chain, MemoryArena& arena) -> Biquad*
+{
+    Biquad* biquad = PushStruct(arena, Biquad);
+    *biquad = {};
+    biquad->b0 = 1.0f;
+    return AddEffect(chain, EffectType::Biquad, biquad) ? biquad : nullptr;
+}
+
+auto EffectChainAddCompressor(EffectChain& chain, MemoryArena& arena) -> Compressor*
+{
+    Compressor* compressor = PushStruct(arena, Compressor);
+    *compressor = {};
+    return AddEffect(chain, EffectType::Compressor, compressor) ? compressor : nullptr;
+}
+
+auto EffectChainAddLimiter(EffectChain& chain, MemoryArena& arena) -> Limiter*
+{
+    Limiter* limiter = PushStruct(arena, Limiter);
+    *limiter = {};
+    return AddEffect(chain, EffectType::Limiter, limiter) ? limiter : nullptr;
+}
+
+auto EffectChainAddReverb(EffectChain& chain, MemoryArena& arena, int samplesPerSecond, int maxFrameCount) -> Reverb*
+{
+    Reverb* reverb = PushStruct(arena, Reverb);
+    *reverb = {};
+    ReverbInitialize(*reverb, arena, samplesPerSecond, maxFrameCount);
+    return AddEffect(chain, EffectType::Reverb, reverb) ? reverb : nullptr;
+}
+
+void EffectChainProcess(EffectChain& chain, float* left, float* right, int frameCount)
+{
+    ASSERT(frameCount % DSP_SUB_BLOCK == 0);
+    for (int i = 0; i < chain.count; ++i)
+    {
+        Effect& effect = chain.effects[i];
+        if (!effect.enabled)
+        {
+            continue;
+        }
+
+        switch (effect.type)
+        {
+            case EffectType::Biquad:     BiquadProcess(*(Biquad*)effect.state, left, right, frameCount); break;
+            case EffectType::Compressor: CompressorProcess(*(Compressor*)effect.state, left, right, frameCount); break;
+            case EffectType::Limiter:    LimiterProcess(*(Limiter*)effect.state, left, right, frameCount); break;
+            case EffectType::Reverb:     ReverbProcess(*(Reverb*)effect.state, left, right, frameCount); break;
+        }
+    }
+}
+
+#pragma endregion Chain
@@ -0,0 +1,85 @@
+#include "entity.h"
+
+void InitializeEntityStore(EntityStore& store, MemoryArena& arena, uint32_t capacity)
+{
+    store.capacity = capacity;
+    store.count = 0;
+    store.chunkX = PushArray(arena, capacity, int32_t);
+    store.chunkY = PushArray(arena, capacity, int32_t);
+    store.offsetX = PushArray(arena, capacity, float);
+    store.offsetY = PushArray(arena, capacity, float);
+    store.velocityX = PushArray(arena, capacity, float);
+    store.velocityY = PushArray(arena, capacity, float);
+    store.radius = PushArray(arena, capacity, float);
+    store.flags = PushArray(arena, capacity, uint32_t);
+    store.slotOf = PushArray(arena, capacity, uint32_t);
+
+    store.slots = PushArray(arena, capacity, EntitySlot);
+    for (uint32_t i = 0; i < capacity; ++i)
+    {
+        store.slots[i].generation = 0;
+        store.slots[i].denseIndex = i + 1;
+    }
+    store.firstFreeSlot = 0;
+}
+
+auto AddEntity(EntityStore& store, World& world, WorldPosition position, v2 velocity, float radius, uint32_t flags)
+    -> EntityId
+{
+    if (store.count == store.capacity)
+    {
+        return {};
+    }
+
+    uint32_t slotIndex = store.firstFreeSlot;
+    EntitySlot& slot = store.slots[slotIndex];
+    store.firstFreeSlot = slot.denseIndex;
+    ++slot.generation;
+    slot.generation += slot.generation == 0;
+
+    uint32_t index = store.count++;
+    slot.denseIndex = index;
+    position = CanonicalizePosition(world, position);
+    store.chunkX[index] = position.chunkX;
+    store.chunkY[index] = position.chunkY;
+    store.offsetX[index] = position.offset.x;
+    store.offsetY[index] = position.offset.y;
+    store.velocityX[index] = velocity.x;
+    store.velocityY[index] = velocity.y;
+    store.radius[index] = radius;
+    store.flags[index] = flags;
+    store.slotOf[index] = slotIndex;
+    AddEntityToChunk(world, position.chunkX, position.chunkY, slotIndex);
+    return {slotIndex, slot.generation};
+}
+
+void RemoveEntity(EntityStore& store, World& world, EntityId id)
+{
+    uint32_t index = GetEntityIndex(store, id);
+    if (index == ENTITY_INVALID_INDEX)
+    {
+        return;
+    }
+    RemoveEntityFromChunk(world, store.chunkX[index], store.chunkY[index], id.slot);
+
+    uint32_t last = --store.count;
+    if (index != last)
+    {
+        store.chunkX[index] = store.chunkX[last];
+        store.chunkY[index] = store.chunkY[last];
+        store.offsetX[index] = store.offsetX[last];
+        store.offsetY[index] = store.offsetY[last];
+        store.velocityX[index] = store.velocityX[last];
+        store.velocityY[index] = store.velocityY[last];
+        store.radius[index] = store.radius[last];
+        store.flags[index] = store.flags[last];
+        store.slotOf[index] = store.slotOf[last];
+        store.slots[store.slotOf[index]].denseIndex = index;
+    }
+
+    EntitySlot& slot = store.slots[id.slot];
+    ++slot.generation;
+    slot.generation += slot.generation == 0;
+    slot.denseIndex = store.firstFreeSlot;
+    store.firstFreeSlot = id.slot;
+}
@@ -2,13 +2,19 @@
 #include <string>
 
 #include <xinput.h>
-#include <dsound.h>
 #include <math.h>
 #include "game.h"
+#include "audio.h"
+#include "audio_telemetry.h"
+#include "capture.h"
+#include "cmdline.h"
+#include "headless.h"
+#include "platform.h"
 #include <stdio.h>
 
 global bool running = true;
-global LPDIRECTSOUNDBUFFER secondaryBuffer;
+global bool showAudioTelemetry = false;   // F3
+global bool dumpAudioTelemetry = false;   // F4
 internal BITMAPINFO bitmapInfo = {}; // Global variable for bitmap info
 
 #pragma region XInput stubs new style
@@ -51,187 +57,19 @@ namespace Input
 } // namespace Input
 #pragma endregion XInput stubs new style\
 
-auto InitDSound(HWND hwnd, int sampleRate, int channels, int bufferSize) -> bool
-{
-    // Initialize DirectSound
-    HMODULE dsoundModule = LoadLibraryA("dsound.dll");
-    if (!dsoundModule) {
-        OutputDebugStringA("Failed to load dsound.dll\n");
-        return false;
-    }
-
-    typedef HRESULT(WINAPI* DirectSoundCreateFunc)(LPCGUID, LPDIRECTSOUND*, LPUNKNOWN);
-    DirectSoundCreateFunc DirectSoundCreate = (DirectSoundCreateFunc)GetProcAddress(dsoundModule, "DirectSoundCreate");
-
-    if (!DirectSoundCreate) {
-        OutputDebugStringA("Failed to get DirectSoundCreate function\n");
-        return false;
-    }
-
-    // Create DirectSound object
-    LPDIRECTSOUND directSound;
-    HRESULT hr = DirectSoundCreate(nullptr, &directSound, nullptr);
-    if (FAILED(hr)) {
-        OutputDebugStringA("Failed to create DirectSound object\n");
-        return false;
-    }
-
-    // Set the cooperative level
-    // DSSCL_DEFAULT would use the default cooperative level
-    // DSSCL_PRIORITY is often used for games to ensure low latency and high performance
-    // DSSCL_EXCLUSIVE is used for applications that need exclusive access to the sound device
-    // DSSCL_BACKGROUND is used for applications that do not need exclusive access to the sound device
-    // DSSCL_WRITEPRIMARY is used for applications that need to write to the primary buffer
-    // DSSCL_DEFAULT is used for applications that do not need to set a specific cooperative level
-    hr = directSound->SetCooperativeLevel(hwnd, DSSCL_PRIORITY);
-    if (FAILED(hr)) {
-        OutputDebugStringA("Failed to set cooperative level\n");
-        return false;
-    }
-
-    // Create a primary buffer
-    // The primary buffer is used to control the sound device and set the format
-    // It is not used for playing sound directly, but rather to set the format for secondary buffers
-    
-    DSBUFFERDESC bufferDesc = {};
-    bufferDesc.dwSize = sizeof(DSBUFFERDESC); // Size of the structure
-    //bufferDesc.dwFlags = DSBCAPS_CTRLVOLUME | DSBCAPS_CTRLFREQUENCY | DSBCAPS_CTRLPOSITIONNOTIFY; // Flags for the primary buffer
-    bufferDesc.dwFlags = DSBCAPS_PRIMARYBUFFER; 
-
-
-    LPDIRECTSOUNDBUFFER primaryBuffer;
-    hr = directSound->CreateSoundBuffer(&bufferDesc, &primaryBuffer, nullptr);
-    if (FAILED(hr)) {
-        OutputDebugStringA("Failed to create primary sound buffer\n");
-        return false;
-    }
-
-    // Set the format of the primary buffer
-    WAVEFORMATEX waveFormat = {};
-    waveFormat.wFormatTag = WAVE_FORMAT_PCM;
-    waveFormat.nChannels = channels;
-    waveFormat.nSamplesPerSec = sampleRate;
-    waveFormat.wBitsPerSample = 16; // 16-bit samples
-    waveFormat.nBlockAlign = (waveFormat.nChannels * waveFormat.wBitsPerSample) / 8;
-    waveFormat.nAvgBytesPerSec = waveFormat.nSamplesPerSec * waveFormat.nBlockAlign;
-
-    hr = primaryBuffer->SetFormat(&waveFormat);
-    if (FAILED(hr)) {
-        OutputDebugStringA("Failed to set format on primary sound buffer\n");
-        return false;
-    }
-
-    // Create a secondary buffer
-    // The secondary buffer is used for playing sound
-
-    // Secondary buffers are used to play sound
-    // The primary buffer can be created with different flags and formats
-    // DSBCAPS_PRIMARYBUFFER is used to indicate that this is a primary buffer
-    // DSBCAPS_CTRLVOLUME is used to indicate that the buffer can control volume
-    // DSBCAPS_CTRLFREQUENCY is used to indicate that the buffer can control frequency
-    // DSBCAPS_CTRLPOSITIONNOTIFY is used to indicate that the buffer can control position notifications
-    // DSBCAPS_GLOBALFOCUS is used to indicate that the buffer can be used when the application is not in focus
-    // DSBCAPS_GETCURRENTPOSITION2 is used to indicate that the buffer can get the current position
-    // DSBCAPS_CTRL3D is used to indicate that the buffer can control 3D sound
-    // DSBCAPS_CTRLFX is used to indicate that the buffer can control effects
-    // DSBCAPS_CTRLDEFAULT is used to indicate that the buffer can control default settings
-    // DSBCAPS_CTRLALL is used to indicate that the buffer can control all settings
-    DSBUFFERDESC secondaryBufferDesc = {};
-    secondaryBufferDesc.dwSize = sizeof(DSBUFFERDESC); // Size of the structure
-    secondaryBufferDesc.dwFlags = 0; // No special flags for the secondary buffer
-    secondaryBufferDesc.dwBufferBytes = bufferSize; // Size of the buffer in bytes
-    secondaryBufferDesc.lpwfxFormat = &waveFormat; // Format of the buffer
-
-    
-    hr = directSound->CreateSoundBuffer(&secondaryBufferDesc, &secondaryBuffer, nullptr);
-    if (FAILED(hr)) {
-        OutputDebugStringA("Failed to create secondary sound buffer\n");
-        return false;
-    }
-    return true;
-}
-
 struct SoundOutput{
 
     int samplesPerSecond = 48000; // Sample rate
     int toneHz = 256;             // Frequency of the sine wave
     int16_t toneVolume = 3800;        // Volume (amplitude)
-    uint32_t sampleIndex = 0;         // Current sample index;
     int WavePeriod = samplesPerSecond/toneHz;
     int bytesPerSample = sizeof(int16_t) * 2;
     int secondaryBufferSize = samplesPerSecond * bytesPerSample;
-    int latencySampleCount = samplesPerSecond / 15;
+    int latencySampleCount = samplesPerSecond / 15; // only used if calibration fails
+    float targetSecondsPerFrame = 1.0f / 30.0f;
 
 };
 
-internal void FillSoundBuffer(SoundOutput& soundOutput, DWORD ByteToLock, DWORD BytesToWrite,SoundOutputBuffer& source)
-{
-
-    if (!running || !secondaryBuffer || !source.samples) {
-        return;  // Don't fill buffer if shutting down
-    }
-
-    VOID* region1;
-    DWORD region1Size;
-    VOID* region2;
-    DWORD region2Size;
-    if(SUCCEEDED(secondaryBuffer->Lock(ByteToLock, BytesToWrite, &region1, &region1Size, &region2, &region2Size, 0)))
-    {
-        DWORD region1SampleCount = region1Size / soundOutput.bytesPerSample;
-        DWORD region2SampleCount = region2Size / soundOutput.bytesPerSample;
-        DWORD totalSampleCount = region1SampleCount + region2SampleCount;
-
-        int16_t* destSample = (int16_t*)region1;
-        int16_t* sourceSample = source.samples;
-
-        for(DWORD i = 0; i < totalSampleCount; ++i)
-        {
-            // Switch to region2 when we've filled region1
-            if(i == region1SampleCount)
-            {
-                destSample = (int16_t*)region2;
-            }
-            
-            *destSample++ = *sourceSample++; // Left channel
-            *destSample++ = *sourceSample++; // Right channel
-            soundOutput.sampleIndex++;
-        }
-
-        secondaryBuffer->Unlock(region1, region1Size, region2, region2Size);
-    }
- 
-}
-
-internal void ClearSoundBuffer(SoundOutput& soundOutput)
-{
-    VOID* region1;
-    DWORD region1Size;
-    VOID* region2;
-    DWORD region2Size;
-    if(SUCCEEDED(secondaryBuffer->Lock(0, soundOutput.secondaryBufferSize, &region1, &region1Size, &region2, &region2Size, 0)))
-    {
-        DWORD region1SampleCount = region1Size / soundOutput.bytesPerSample;
-        DWORD region2SampleCount = region2Size / soundOutput.bytesPerSample;
-        DWORD totalSampleCount = region1SampleCount + region2SampleCount;
-
-        int16_t* destSample = (int16_t*)region1;
-
-        for(DWORD i = 0; i < totalSampleCount; ++i)
-        {
-            // Switch to region2 when we've filled region1
-            if(i == region1SampleCount)
-            {
-                destSample = (int16_t*)region2;
-            }
-            
-            *destSample++ = 0; // Left channel
-            *destSample++ = 0; // Right channel
-        }
-
-        secondaryBuffer->Unlock(region1, region1Size, region2, region2Size);
-    }
-}
-
 struct Dimensions
 {
     int width;
@@ -318,6 +156,20 @@ internal void DrawBuffer(HDC hdc,int windowWidth,int windowHeight,OffscreenBuffe
   
 }
 
+// Maps a raw thumb stick axis to -1..1 with the dead zone cut out, so motion starts from zero at its edge
+internal float NormalizeStick(int16_t value, int16_t deadZone)
+{
+    if (value < -deadZone)
+    {
+        return (float)(value + deadZone) / (32768.0f - deadZone);
+    }
+    if (value > deadZone)
+    {
+        return (float)(value - deadZone) / (32767.0f - deadZone);
+    }
+    return 0.0f;
+}
+
 LRESULT CALLBACK Wndproc(HWND hwnd,UINT msg,WPARAM wParam,LPARAM lParam)
 {
      switch (msg)
@@ -355,6 +207,14 @@ LRESULT CALLBACK Wndproc(HWND hwnd,UINT msg,WPARAM wParam,LPARAM lParam)
                     // Handle escape key to close the application
                     running = false;
                 }
+                if (key == VK_F3 && !wasDown)
+                {
+                    showAudioTelemetry = !showAudioTelemetry;
+                }
+                if (key == VK_F4 && !wasDown)
+                {
+                    dumpAudioTelemetry = true;
+                }
                 
                 // Key is pressed
                 std::string keyName = "Key Pressed: " + std::to_string(key) + "\n";
@@ -404,6 +264,11 @@ LRESULT CALLBACK Wndproc(HWND hwnd,UINT msg,WPARAM wParam,LPARAM lParam)
 
 int CALLBACK WinMain(HINSTANCE hInstance, HINSTANCE hPrevInstance, LPSTR lpCmdLine, int nCmdShow)
 {
+    if (HasCommandLineFlag(lpCmdLine, "-headless"))
+    {
+        return RunHeadless(lpCmdLine);
+    }
+
      LARGE_INTEGER frequency;
     if (!QueryPerformanceFrequency(&frequency))
     {
@@ -455,25 +320,68 @@ int CALLBACK WinMain(HINSTANCE hInstance, HINSTANCE hPrevInstance, LPSTR lpCmdLi
     }
 
 
-    int xOffset = 0;
-    int yOffset = 0;
+    GameMemory gameMemory;
+    if (!PlatformAllocateGameMemory(gameMemory))
+    {
+        MessageBoxA(nullptr, "Failed to allocate game memory", "Error", MB_OK | MB_ICONERROR);
+        return -1;
+    }
+    // This thread works the queue too while it waits, so one worker per remaining core
+    uint32_t processorCount = PlatformGetProcessorCount();
+    gameMemory.workQueue = PlatformCreateWorkQueue(processorCount > 1 ? processorCount - 1 : 0);
+    // Background work is latency tolerant, a couple of threads keep it off the frame's cores
+    gameMemory.backgroundQueue = PlatformCreateWorkQueue(processorCount > 4 ? 2 : 1);
 
     SoundOutput soundOutput;
-    if(!InitDSound(hwnd, soundOutput.samplesPerSecond, 2, soundOutput.secondaryBufferSize)){
-        MessageBoxA(nullptr, "Failed to initialize DirectSound", "Error", MB_OK | MB_ICONERROR);
+    AudioDevice audioDevice;
+    char audioFilePath[MAX_PATH];
+    if (GetCommandLineArgument(lpCmdLine, "-audio-file", audioFilePath, sizeof(audioFilePath)))
+    {
+        AudioOpenWavFile(audioDevice, audioFilePath, soundOutput.samplesPerSecond, soundOutput.secondaryBufferSize);
+    }
+    else if (!HasCommandLineFlag(lpCmdLine, "-audio-null"))
+    {
+        if(!AudioOpenDirectSound(audioDevice, hwnd, soundOutput.samplesPerSecond, soundOutput.secondaryBufferSize)){
+            MessageBoxA(nullptr, "Failed to initialize DirectSound", "Error", MB_OK | MB_ICONERROR);
+        }
+    }
+
+    //Keep the loop running silently rather than special casing a missing device everywhere
+    if (!audioDevice.api)
+    {
+        AudioOpenNull(audioDevice, soundOutput.samplesPerSecond, soundOutput.secondaryBufferSize);
+    }
+    AudioClear(audioDevice);
+
+    char captureBasePath[MAX_PATH];
+    if (GetCommandLineArgument(lpCmdLine, "-capture", captureBasePath, sizeof(captureBasePath)))
+    {
+        CaptureStart(captureBasePath, backBuffer.width, backBuffer.height, soundOutput.samplesPerSecond);
+    }
+
+    AudioPlay(audioDevice); // Start playing the sound buffer
+
+    AudioCalibration audioCalibration;
+    if (!AudioCalibrate(audioDevice, soundOutput.targetSecondsPerFrame, 0.25f, audioCalibration))
+    {
+        OutputDebugStringA("Audio calibration failed, using fixed latency\n");
+    }
+
+    AudioTelemetry audioTelemetry = {};
+    char audioTracePath[MAX_PATH] = "audio_telemetry.csv";
+    bool traceOnExit = HasCommandLineFlag(lpCmdLine, "-audio-trace");
+    if (traceOnExit && !GetCommandLineArgument(lpCmdLine, "-audio-trace", audioTracePath, sizeof(audioTracePath)))
+    {
+        strcpy(audioTracePath, "audio_telemetry.csv");
     }
-    bool SoundIsPlaying = false;
-    ClearSoundBuffer(soundOutput);
-    
-    int16_t* samples = (int16_t*)VirtualAlloc(nullptr, soundOutput.secondaryBufferSize,
-                              MEM_COMMIT | MEM_RESERVE,
-                              PAGE_READWRITE);
 
-    secondaryBuffer->Play(0, 0, DSBPLAY_LOOPING); // Start playing the sound buffer
     MSG msg{};
     
     LARGE_INTEGER lastCounter;
     QueryPerformanceCounter(&lastCounter);
+    //The game steps by how long the last frame actually took, capped so a stall (debugger, window drag) doesn't become one huge step
+    const float maxSecondsPerFrame = 1.0f / 15.0f;
+    float lastFrameSeconds = soundOutput.targetSecondsPerFrame;
 
     //int64_t LastCycleCount = __rdtsc();
 
@@ -495,6 +403,8 @@ int CALLBACK WinMain(HINSTANCE hInstance, HINSTANCE hPrevInstance, LPSTR lpCmdLi
 
         //TODO: should we poll more friquently 
 #pragma region Input Handling
+        GameInput gameInput = {};
+        gameInput.secondsElapsed = lastFrameSeconds < maxSecondsPerFrame ? lastFrameSeconds : maxSecondsPerFrame;
         for (DWORD cIndex = 0; cIndex < XUSER_MAX_COUNT; ++cIndex)
         {
             XINPUT_STATE state;
@@ -512,8 +422,8 @@ int CALLBACK WinMain(HINSTANCE hInstance, HINSTANCE hPrevInstance, LPSTR lpCmdLi
                 int16_t StickX = gamepad.sThumbLX;
                 int16_t StickY = gamepad.sThumbLY;
 
-                xOffset += StickX / 4096;
-                yOffset += StickY / 4096;
+                gameInput.stickX = NormalizeStick(StickX, XINPUT_GAMEPAD_LEFT_THUMB_DEADZONE);
+                gameInput.stickY = NormalizeStick(StickY, XINPUT_GAMEPAD_LEFT_THUMB_DEADZONE);
 
                 soundOutput.toneHz = 512 + (int)(256.0f*(float)StickY / 30000.0f);
                 soundOutput.WavePeriod = soundOutput.samplesPerSecond/soundOutput.toneHz;
@@ -527,36 +437,46 @@ int CALLBACK WinMain(HINSTANCE hInstance, HINSTANCE hPrevInstance, LPSTR lpCmdLi
         }
 #pragma endregion
 
-        DWORD PlayCursor = 0;
-        DWORD WriteCursor = 0;
-        DWORD ByteToLock;
-        DWORD TargetCursor;
-        DWORD BytesToWrite;
-        bool SoundIsValid = false;
-        if(SUCCEEDED(secondaryBuffer->GetCurrentPosition(&PlayCursor, &WriteCursor)))
-        {
-            ByteToLock = (soundOutput.sampleIndex * soundOutput.bytesPerSample) % soundOutput.secondaryBufferSize;
-
-            TargetCursor = ((PlayCursor + (soundOutput.latencySampleCount*soundOutput.bytesPerSample)) % soundOutput.secondaryBufferSize);
-            
-            if (ByteToLock > TargetCursor)
-            {
-                BytesToWrite = (soundOutput.secondaryBufferSize - ByteToLock);
-                BytesToWrite += TargetCursor;
-            }
-            else
-            {
-                BytesToWrite = TargetCursor - ByteToLock;
-            }
+        // Telemetry sees the cursors before the write range logic can skip ahead on an underrun
+        uint32_t telemetryPlayCursor = 0;
+        uint32_t telemetryWriteCursor = 0;
+        AudioGetCursors(audioDevice, telemetryPlayCursor, telemetryWriteCursor);
+        uint32_t queuedEnd = (audioDevice.runningSampleIndex * audioDevice.bytesPerSample) % audioDevice.bufferSize;
 
-            SoundIsValid = true;
+        AudioWriteRange writeRange;
+        bool SoundIsValid;
+        if (audioCalibration.isCalibrated)
+        {
+            LARGE_INTEGER audioCounter;
+            QueryPerformanceCounter(&audioCounter);
+            float secondsSinceFlip = (float)(audioCounter.QuadPart - lastCounter.QuadPart) / (float)frequency.QuadPart;
+            SoundIsValid = AudioComputeCalibratedWriteRange(audioDevice, audioCalibration, secondsSinceFlip, writeRange);
+        }
+        else
+        {
+            SoundIsValid = AudioComputeWriteRange(audioDevice, soundOutput.latencySampleCount*soundOutput.bytesPerSample, writeRange);
         }
 
         
+        //Synthesize straight into the device ring
         SoundOutputBuffer soundBuffer;
-        soundBuffer.samplesPerSecond = soundOutput.samplesPerSecond;
-        soundBuffer.sampleCount = BytesToWrite/ soundOutput.bytesPerSample; //for 30 fps
-        soundBuffer.samples = samples;
+        AudioWriteSession audioSession;
+        uint32_t bytesWritten = 0;
+        float mixSeconds = 0.0f;
+        if(SoundIsValid && AudioBeginWrite(audioDevice, writeRange, soundBuffer, audioSession))
+        {
+            LARGE_INTEGER mixStart, mixEnd;
+            QueryPerformanceCounter(&mixStart);
+            GameGetSoundSamples(gameMemory, soundBuffer, soundOutput.toneHz);
+            QueryPerformanceCounter(&mixEnd);
+            mixSeconds = (float)(mixEnd.QuadPart - mixStart.QuadPart) / (float)frequency.QuadPart;
+
+            CaptureAudio(soundBuffer);
+            AudioEndWrite(audioDevice, soundBuffer, audioSession);
+            bytesWritten = soundBuffer.sampleCount * audioDevice.bytesPerSample;
+        }
+        AudioTelemetryRecord(audioTelemetry, audioDevice, telemetryPlayCursor, telemetryWriteCursor,
+                             queuedEnd, bytesWritten, mixSeconds);
 
 
         OffscreenBuffer buffer = {};
@@ -566,27 +486,23 @@ int CALLBACK WinMain(HINSTANCE hInstance, HINSTANCE hPrevInstance, LPSTR lpCmdLi
         buffer.pitch = backBuffer.pitch;
         buffer.bpp = backBuffer.bpp;
 
-        GameUpdateAndRender(buffer,soundBuffer,soundOutput.toneHz);
+        GameUpdateAndRender(gameMemory, gameInput, buffer);
 
-        if(SoundIsValid)
+        CaptureFrame(buffer);
+
+        // After capture so recordings stay clean
+        if (showAudioTelemetry)
         {
-            
-            FillSoundBuffer(soundOutput, ByteToLock, BytesToWrite, soundBuffer);
+            AudioTelemetryDraw(audioTelemetry, buffer, soundOutput.targetSecondsPerFrame);
         }
-        
-        if (!SoundIsPlaying)
+        if (dumpAudioTelemetry)
         {
-            HRESULT hr = secondaryBuffer->Play(0, 0, DSBPLAY_LOOPING);
-            if (SUCCEEDED(hr))
-            {
-                SoundIsPlaying = true;
-            }
-            else
-            {
-                OutputDebugStringA("Failed to play sound buffer\n");
-            }
+            AudioTelemetryWriteCsv(audioTelemetry, audioTracePath);
+            dumpAudioTelemetry = false;
         }
         
+        AudioPlay(audioDevice);
+        
 
        
 
@@ -602,15 +518,25 @@ int CALLBACK WinMain(HINSTANCE hInstance, HINSTANCE hPrevInstance, LPSTR lpCmdLi
         QueryPerformanceCounter(&endCounter);
 
         //int64_t cyclesElapsed = endCycleCount - LastCycleCount;
-        //int64_t elapsedCounter = endCounter.QuadPart - lastCounter.QuadPart;
+        int64_t elapsedCounter = endCounter.QuadPart - lastCounter.QuadPart;
+        lastFrameSeconds = (float)elapsedCounter / (float)frequency.QuadPart;
+        AudioCalibrationObserveFrame(audioDevice, audioCalibration, lastFrameSeconds);
         //double msPerFrame = (double)(elapsedCounter * 1000) / (double)frequency.QuadPart;
         //double fps = (double)frequency.QuadPart / (double)elapsedCounter;
 
        
 
-        //lastCounter = endCounter;
+        lastCounter = endCounter;
         //LastCycleCount = endCycleCount;
     }
 
+    if (traceOnExit)
+    {
+        AudioTelemetryWriteCsv(audioTelemetry, audioTracePath);
+    }
+    CaptureStop();
+    AudioClose(audioDevice);
+    PlatformFreeGameMemory(gameMemory);
+
     return 0;
 }
\ No newline at end of file
@@ -1,48 +1,330 @@
 #include "game.h"
+#include "game_state.h"
 #include <math.h>
 
 
 
-void GameOutputSound(SoundOutputBuffer& buffer,int toneHz)
+#define DEMO_AREA_CHUNKS 8     // side of the square the demo entities and paths stay in
+#define DEMO_WORLD_SEED 0x5EED1234
+#define WORLD_GEN_RADIUS 3      // chunks around the camera, a bit past the screen so they are ready before they show
+#define DEMO_ENTITY_COUNT 50000
+#define DEMO_PATH_COUNT 256
+#define DEMO_PATH_RANGE 48      // tiles either way from the start
+#define PATH_FRAME_BUDGET_SECONDS 0.001f
+#define DEMO_PARTICLE_CAPACITY 131072
+#define DEMO_PARTICLE_EMITTERS 4
+#define DEMO_PARTICLES_PER_SECOND 50000.0f  // at two seconds each that keeps about 100k alive
+
+// Drifting dots spread over the demo area, bouncing off each other and its edge
+internal void SpawnDemoEntities(GameState* gameState)
+{
+    World& world = gameState->world;
+    float areaSide = DEMO_AREA_CHUNKS * world.chunkSideInMeters;
+    WorldPosition minCorner = ChunkOrigin(-DEMO_AREA_CHUNKS / 2, -DEMO_AREA_CHUNKS / 2);
+    RandomSeries series = RandomSeed(DEMO_WORLD_SEED, RandomStream_Entities, 0);
+    for (uint32_t i = 0; i < DEMO_ENTITY_COUNT; ++i)
+    {
+        v2 offset = areaSide * V2(RandomUnilateral(series), RandomUnilateral(series));
+        v2 velocity = 0.5f * V2(RandomBilateral(series), RandomBilateral(series));
+        AddEntity(gameState->entities, world, OffsetPosition(world, minCorner, offset), 6.0f * velocity, 0.12f,
+                  EntityFlag_Moving | EntityFlag_Confined | EntityFlag_Collides);
+    }
+}
+
+internal int32_t RandomTile(RandomSeries& series, int32_t minTile, int32_t range)
+{
+    return minTile + (int32_t)RandomChoice(series, (uint32_t)range);
+}
+
+// Finished demo paths get a new random start and goal near the old goal, so the walkers keep wandering
+internal void QueueDemoPaths(GameState* gameState)
+{
+    const int32_t areaMinTile = -DEMO_AREA_CHUNKS / 2 * TILE_CHUNK_DIM;
+    const int32_t areaTileCount = DEMO_AREA_CHUNKS * TILE_CHUNK_DIM;
+    for (uint32_t i = 0; i < DEMO_PATH_COUNT; ++i)
+    {
+        PathRequest& request = gameState->demoPaths[i];
+        if (request.status == PathStatus_Pending)
+        {
+            continue;
+        }
+
+        if (request.status == PathStatus_Found)
+        {
+            request.startX = request.goalX;
+            request.startY = request.goalY;
+        }
+        else
+        {
+            request.startX = RandomTile(gameState->pathRandom, areaMinTile, areaTileCount);
+            request.startY = RandomTile(gameState->pathRandom, areaMinTile, areaTileCount);
+        }
+        request.goalX = RandomTile(gameState->pathRandom, request.startX - DEMO_PATH_RANGE, 2 * DEMO_PATH_RANGE);
+        request.goalY = RandomTile(gameState->pathRandom, request.startY - DEMO_PATH_RANGE, 2 * DEMO_PATH_RANGE);
+        QueuePathRequest(gameState->pathfinder, request);
+    }
+}
+
+// Four spark fountains around where the camera starts, each spraying its own color
+internal void SpawnDemoParticles(GameState* gameState, float seconds)
 {
-    local float tSine;
-    int16_t ToneVolume = 3000;
-    int WavePeriod = buffer.samplesPerSecond / toneHz;
+    const v3 colors[DEMO_PARTICLE_EMITTERS] = {V3(0.40f, 0.18f, 0.04f), V3(0.06f, 0.20f, 0.40f),
+                                               V3(0.10f, 0.36f, 0.08f), V3(0.34f, 0.06f, 0.30f)};
+    gameState->particleSpawnCarry += DEMO_PARTICLES_PER_SECOND / DEMO_PARTICLE_EMITTERS * seconds;
+    uint32_t count = (uint32_t)gameState->particleSpawnCarry & ~(uint32_t)(PARTICLE_LANES - 1);
+    gameState->particleSpawnCarry -= (float)count;
 
-    int16_t* SampleOut = buffer.samples;
-    for(int i = 0; i < buffer.sampleCount; ++i)
+    for (uint32_t i = 0; i < DEMO_PARTICLE_EMITTERS; ++i)
     {
-        float SineValue = sinf(tSine);
-        int16_t SampleValue = (int16_t)(SineValue * ToneVolume);
-        *SampleOut++ = SampleValue;
-        *SampleOut++ = SampleValue;
+        ParticleEmitter emitter = {};
+        emitter.position = V2(i & 1 ? 8.0f : -8.0f, i & 2 ? 6.0f : -6.0f);
+        emitter.positionSpread = 0.2f;
+        emitter.speedSpread = 7.0f;
+        emitter.lifetime = 2.0f;
+        emitter.lifetimeSpread = 0.5f;
+        emitter.color = colors[i];
+        SpawnParticles(gameState->particles, emitter, count);
+    }
+}
+
+internal GameState* GetGameState(GameMemory& memory)
+{
+    ASSERT(sizeof(GameState) <= memory.permanentStorageSize);
+    GameState* gameState = (GameState*)memory.permanentStorage;
+    if (!memory.isInitialized)
+    {
+        InitializeArena(gameState->permanentArena, memory.permanentStorageSize - sizeof(GameState),
+                        (uint8_t*)memory.permanentStorage + sizeof(GameState));
+        InitializeArena(gameState->transientArena, memory.transientStorageSize, memory.transientStorage);
+        InitializeWorld(gameState->world, gameState->permanentArena, 1.4f);
+        InitializeWorldGenerator(gameState->worldGenerator, DEMO_WORLD_SEED, memory.backgroundQueue);
+        gameState->cameraPosition = PositionFromTile(gameState->world, TILE_CHUNK_DIM / 2, TILE_CHUNK_DIM / 2);
+        InitializeEntityStore(gameState->entities, gameState->permanentArena, DEMO_ENTITY_COUNT);
+        gameState->pathRandom = RandomSeed(DEMO_WORLD_SEED, RandomStream_Paths, 0);
+        SpawnDemoEntities(gameState);
+        InitializePathfinder(gameState->pathfinder, gameState->transientArena,
+                             PlatformGetWorkerCount(memory.workQueue), DEMO_PATH_COUNT);
+        InitializeParticleSystem(gameState->particles, gameState->permanentArena, DEMO_PARTICLE_CAPACITY,
+                                 gameState->cameraPosition, 1.2f, DEMO_WORLD_SEED);
+        gameState->demoPaths = PushArray(gameState->permanentArena, DEMO_PATH_COUNT, PathRequest);
+        for (uint32_t i = 0; i < DEMO_PATH_COUNT; ++i)
+        {
+            gameState->demoPaths[i].status = PathStatus_NoPath;
+        }
+        memory.isInitialized = true;
+    }
+    return gameState;
+}
+
+// A short two channel loop so the sequencer has something to play
+internal auto CreateDemoSong(MemoryArena& arena) -> TrackerSong*
+{
+    TrackerSong* song = TrackerCreateSong(arena, 2, 1, 16, 1, 1);
+    song->beatsPerMinute = 110.0f;
+    song->instruments[0].type = InstrumentType::Sine;
+    song->instruments[0].bus = MixerBus::Music;
+    song->instruments[0].volume = 0.05f;
+
+    local const uint8_t arpeggio[8] = {60, 63, 67, 72, 67, 63, 60, 58};
+    for (int row = 0; row < 16; ++row)
+    {
+        TrackerGetCell(*song, 0, row, 0).note = arpeggio[row % 8];
+        TrackerGetCell(*song, 0, row, 1).note = (row % 4 == 0) ? (row < 8 ? 36 : 34) : NOTE_NONE;
+    }
+    TrackerGetCell(*song, 0, 15, 0).note = NOTE_OFF;
+    return song;
+}
+
+internal void GameOutputSound(GameState* gameState, SoundOutputBuffer& buffer, int toneHz)
+{
+    Mixer& mixer = gameState->mixer;
+    if (!mixer.isInitialized)
+    {
+        MixerInitialize(mixer, gameState->permanentArena, buffer.samplesPerSecond);
+        gameState->toneVoice = MixerPlaySine(mixer, (float)toneHz, 3000.0f / 32768.0f, MixerBus::Effects, MIXER_PRIORITY_HIGH);
+
+        // Optional background track, streamed from disk while it plays
+        if (WavStreamOpen(gameState->music, "data/music.wav"))
+        {
+            MixerPlayStream(mixer, &gameState->music, 0.5f, true);
+        }
 
-        tSine += 2.0f * M_PI * 1.0f / (float)WavePeriod;
+        gameState->song = CreateDemoSong(gameState->permanentArena);
+        SequencerPlay(gameState->sequencer, mixer, gameState->song);
     }
+
+    MixerSetTone(mixer, gameState->toneVoice, (float)toneHz);
+    MixerOutput(mixer, buffer);
 }
 
-internal void RenderGradiant(OffscreenBuffer& buffer,int xOffset,int yOffset)
+internal void DrawRectangle(OffscreenBuffer& buffer, rect2 rect, uint32_t color)
 {
-   
-    uint8_t* row = (uint8_t*)buffer.data;
-    for(int y = 0; y < buffer.height; ++y)
+    int minX = (int)lroundf(rect.min.x);
+    int minY = (int)lroundf(rect.min.y);
+    int maxX = (int)lroundf(rect.max.x);
+    int maxY = (int)lroundf(rect.max.y);
+    minX = minX < 0 ? 0 : minX;
+    minY = minY < 0 ? 0 : minY;
+    maxX = maxX > buffer.width ? buffer.width : maxX;
+    maxY = maxY > buffer.height ? buffer.height : maxY;
+
+    uint8_t* row = (uint8_t*)buffer.data + minY * buffer.pitch + minX * buffer.bpp;
+    for (int y = minY; y < maxY; ++y)
     {
         uint32_t* pixel = (uint32_t*)row;
-        for(int x = 0; x < buffer.width; ++x)
+        for (int x = minX; x < maxX; ++x)
         {
-            uint8_t red = (uint8_t)(x + xOffset);
-            uint8_t green = (uint8_t)(y + yOffset);
-            uint8_t blue = (uint8_t)(y + yOffset);
-            *pixel++ = (red << 16) | (green << 8) | blue;
+            *pixel++ = color;
         }
         row += buffer.pitch;
     }
 }
 
+// World y points up. Walks the visible chunks so each is looked up once, tiles are placed relative
+// to the camera so the floats stay small however far out it is.
+internal void RenderTileMap(OffscreenBuffer& buffer, World& world, WorldPosition camera)
+{
+    const float tileSideInPixels = 24.0f;
+    const float metersToPixels = tileSideInPixels / world.tileSideInMeters;
+    const uint32_t tileColors[] = {0x202020, 0x808080, 0xE0E0E0, 0x204080};
+
+    rect2 screen = RectMinMax(V2(0.0f, 0.0f), V2((float)buffer.width, (float)buffer.height));
+    DrawRectangle(buffer, screen, tileColors[TileValue_Empty]);
+
+    v2 screenCenter = GetCenter(screen);
+    v2 halfScreenInMeters = (1.0f / metersToPixels) * screenCenter;
+    WorldPosition minCorner = OffsetPosition(world, camera, -halfScreenInMeters);
+    WorldPosition maxCorner = OffsetPosition(world, camera, halfScreenInMeters);
+
+    for (int32_t chunkY = minCorner.chunkY; chunkY <= maxCorner.chunkY; ++chunkY)
+    {
+        for (int32_t chunkX = minCorner.chunkX; chunkX <= maxCorner.chunkX; ++chunkX)
+        {
+            TileChunk* chunk = GetReadableTileChunk(world.tileMap, chunkX, chunkY);
+            if (!chunk)
+            {
+                continue;
+            }
+
+            v2 chunkOffset = WorldSubtract(world, ChunkOrigin(chunkX, chunkY), camera);
+            float chunkMinX = screenCenter.x + chunkOffset.x * metersToPixels;
+            float chunkMaxY = screenCenter.y - chunkOffset.y * metersToPixels;
+            for (int32_t y = 0; y < TILE_CHUNK_DIM; ++y)
+            {
+                float minY = chunkMaxY - (float)(y + 1) * tileSideInPixels;
+                if (minY + tileSideInPixels < 0.0f || minY > screen.max.y)
+                {
+                    continue;
+                }
+                for (int32_t x = 0; x < TILE_CHUNK_DIM; ++x)
+                {
+                    uint8_t value = chunk->tiles[y * TILE_CHUNK_DIM + x];
+                    rect2 tile = RectMinDim(V2(chunkMinX + (float)x * tileSideInPixels, minY),
+                                            V2(tileSideInPixels, tileSideInPixels));
+                    if (value == TileValue_Empty || !RectanglesIntersect(tile, screen))
+                    {
+                        continue;
+                    }
+
+                    DrawRectangle(buffer, tile, tileColors[value]);
+                }
+            }
+        }
+    }
+}
+
+// Region positions are already relative to the camera, which is the region origin
+internal void RenderSimEntities(OffscreenBuffer& buffer, World& world, SimRegion& region)
+{
+    const float metersToPixels = 24.0f / world.tileSideInMeters;
+    const v2 halfDimInPixels = V2(2.0f, 2.0f);
+    rect2 screen = RectMinMax(V2(0.0f, 0.0f), V2((float)buffer.width, (float)buffer.height));
+    v2 screenCenter = GetCenter(screen);
+    for (uint32_t i = 0; i < region.count; ++i)
+    {
+        v2 center = screenCenter + metersToPixels * V2(region.positionX[i], -region.positionY[i]);
+        rect2 rect = RectCenterHalfDim(center, halfDimInPixels);
+        if (!RectanglesIntersect(rect, screen))
+        {
+            continue;
+        }
+        DrawRectangle(buffer, rect, 0xFF8020);
+    }
+}
 
-void GameUpdateAndRender(OffscreenBuffer& buffer,SoundOutputBuffer& soundBuffer, int toneHz)
+internal void RenderDemoPaths(OffscreenBuffer& buffer, World& world, WorldPosition camera, PathRequest* paths)
 {
-    //TODO: Allow sample offsets for more robust platform options
-    GameOutputSound(soundBuffer,toneHz);
-    RenderGradiant(buffer, 0, 0);
-}
\ No newline at end of file
+    const float metersToPixels = 24.0f / world.tileSideInMeters;
+    const v2 halfDimInPixels = V2(1.0f, 1.0f);
+    rect2 screen = RectMinMax(V2(0.0f, 0.0f), V2((float)buffer.width, (float)buffer.height));
+    v2 screenCenter = GetCenter(screen);
+    for (uint32_t pathIndex = 0; pathIndex < DEMO_PATH_COUNT; ++pathIndex)
+    {
+        PathRequest& path = paths[pathIndex];
+        if (path.status != PathStatus_Found)
+        {
+            continue;
+        }
+        for (uint32_t i = 0; i < path.length; ++i)
+        {
+            v2 offset = WorldSubtract(world, PositionFromTile(world, path.tileX[i], path.tileY[i]), camera);
+            rect2 rect = RectCenterHalfDim(screenCenter + metersToPixels * V2(offset.x, -offset.y), halfDimInPixels);
+            if (RectanglesIntersect(rect, screen))
+            {
+                DrawRectangle(buffer, rect, 0x40C0FF);
+            }
+        }
+    }
+}
+
+void GameUpdateAndRender(GameMemory& memory, GameInput& input, OffscreenBuffer& buffer)
+{
+    GameState* gameState = GetGameState(memory);
+    World& world = gameState->world;
+
+    const float cameraMetersPerSecond = 20.0f;
+    v2 cameraDelta = (cameraMetersPerSecond * input.secondsElapsed) * V2(input.stickX, input.stickY);
+    gameState->cameraPosition = OffsetPosition(world, gameState->cameraPosition, cameraDelta);
+    GenerateChunksAround(gameState->worldGenerator, world, gameState->cameraPosition.chunkX,
+                         gameState->cameraPosition.chunkY, WORLD_GEN_RADIUS);
+
+    // Two chunks either way comfortably covers the screen, everything past that sleeps
+    TemporaryMemory simMemory = BeginTemporaryMemory(gameState->transientArena);
+    v2 simHalfSize = V2(2.0f * world.chunkSideInMeters, 2.0f * world.chunkSideInMeters);
+    SimRegion* simRegion = BeginSimRegion(gameState->transientArena, world, gameState->entities,
+                                          gameState->cameraPosition, simHalfSize);
+
+    float areaSide = DEMO_AREA_CHUNKS * world.chunkSideInMeters;
+    v2 areaMin = WorldSubtract(world, ChunkOrigin(-DEMO_AREA_CHUNKS / 2, -DEMO_AREA_CHUNKS / 2),
+                                simRegion->origin);
+    ContactList contacts = FindSimContacts(gameState->transientArena, *simRegion, input.secondsElapsed);
+    ResolveSimContacts(*simRegion, contacts);
+    MoveSimEntities(*simRegion, input.secondsElapsed);
+    ConfineSimEntities(*simRegion, areaMin, areaMin + V2(areaSide, areaSide));
+
+    // Whatever doesn't fit in the budget stays queued for the next frame
+    QueueDemoPaths(gameState);
+    RunPathRequests(gameState->pathfinder, world.tileMap, memory.workQueue, PATH_FRAME_BUDGET_SECONDS);
+
+    SpawnDemoParticles(gameState, input.secondsElapsed);
+    ParticleCamera particleCamera = {};
+    particleCamera.offset = WorldSubtract(world, gameState->cameraPosition, gameState->particles.origin);
+    particleCamera.metersToPixels = 24.0f / world.tileSideInMeters;
+    particleCamera.width = buffer.width;
+    particleCamera.height = buffer.height;
+    UpdateParticles(gameState->particles, input.secondsElapsed, particleCamera, memory.workQueue);
+
+    RenderTileMap(buffer, world, gameState->cameraPosition);
+    RenderDemoPaths(buffer, world, gameState->cameraPosition, gameState->demoPaths);
+    RenderSimEntities(buffer, world, *simRegion);
+    RenderParticles(gameState->particles, buffer, memory.workQueue);
+
+    EndSimRegion(*simRegion, world, gameState->entities);
+    EndTemporaryMemory(simMemory);
+}
+
+void GameGetSoundSamples(GameMemory& memory, SoundOutputBuffer& soundBuffer, int toneHz)
+{
+    GameState* gameState = GetGameState(memory);
+    GameOutputSound(gameState, soundBuffer, toneHz);
+}
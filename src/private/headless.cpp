@@ -0,0 +1,1253 @@
+#include "headless.h"
+#include "game.h"
+#include "cmdline.h"
+#include "wav.h"
+#include "platform.h"
+#include "wav_stream.h"
+#include "adpcm.h"
+#include "ring.h"
+#include "sim_region.h"
+#include "collision.h"
+#include "pathfinding.h"
+#include "world_gen.h"
+#include "random.h"
+#include "particles.h"
+#include "resampler.h"
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+#include <queue>
+#include <vector>
+
+internal double SecondsElapsed(LARGE_INTEGER start, LARGE_INTEGER end, LARGE_INTEGER frequency)
+{
+    return (double)(end.QuadPart - start.QuadPart) / (double)frequency.QuadPart;
+}
+
+internal auto RunAudioBounce(const char* cmdLine, const char* path) -> int
+{
+    char value[MAX_PATH];
+    double seconds = 10.0;
+    int toneHz = 256;
+    int samplesPerSecond = 48000;
+    if (GetCommandLineArgument(cmdLine, "-seconds", value, sizeof(value)))
+    {
+        seconds = atof(value);
+    }
+    else if (HasCommandLineFlag(cmdLine, "-seconds"))
+    {
+        seconds = 0.0;
+    }
+    if (GetCommandLineArgument(cmdLine, "-tone", value, sizeof(value)))
+    {
+        toneHz = atoi(value);
+    }
+    else if (HasCommandLineFlag(cmdLine, "-tone"))
+    {
+        toneHz = 0;
+    }
+    if (seconds <= 0.0 || toneHz <= 0)
+    {
+        printf("bounce: -seconds and -tone must be positive\n");
+        return -1;
+    }
+
+    WavWriter wav;
+    if (!WavOpen(wav, path, samplesPerSecond, 2, 16))
+    {
+        printf("bounce: could not create %s\n", path);
+        return -1;
+    }
+
+    // Pull in 30hz frame sized chunks, the same granularity the game loop asks for
+    int chunkSampleCount = samplesPerSecond / 30;
+    int16_t* samples = (int16_t*)VirtualAlloc(nullptr, chunkSampleCount * 2 * sizeof(int16_t),
+                                              MEM_COMMIT | MEM_RESERVE, PAGE_READWRITE);
+    if (!samples)
+    {
+        WavClose(wav);
+        return -1;
+    }
+
+    GameMemory gameMemory;
+    if (!PlatformAllocateGameMemory(gameMemory))
+    {
+        WavClose(wav);
+        VirtualFree(samples, 0, MEM_RELEASE);
+        return -1;
+    }
+
+    LARGE_INTEGER frequency;
+    QueryPerformanceFrequency(&frequency);
+
+    int64_t totalSampleCount = (int64_t)(seconds * samplesPerSecond);
+    int64_t samplesDone = 0;
+    double mixSeconds = 0.0;
+
+    LARGE_INTEGER runStart;
+    QueryPerformanceCounter(&runStart);
+    while (samplesDone < totalSampleCount)
+    {
+        SoundOutputBuffer soundBuffer;
+        soundBuffer.samplesPerSecond = samplesPerSecond;
+        SetContiguousSamples(soundBuffer, samples, (int)(totalSampleCount - samplesDone < chunkSampleCount ?
+                                                         totalSampleCount - samplesDone : chunkSampleCount));
+
+        LARGE_INTEGER mixStart, mixEnd;
+        QueryPerformanceCounter(&mixStart);
+        GameGetSoundSamples(gameMemory, soundBuffer, toneHz);
+        QueryPerformanceCounter(&mixEnd);
+        mixSeconds += SecondsElapsed(mixStart, mixEnd, frequency);
+
+        WavWrite(wav, samples, soundBuffer.sampleCount * 2 * sizeof(int16_t));
+        samplesDone += soundBuffer.sampleCount;
+    }
+    LARGE_INTEGER runEnd;
+    QueryPerformanceCounter(&runEnd);
+    double totalSeconds = SecondsElapsed(runStart, runEnd, frequency);
+
+    WavClose(wav);
+    VirtualFree(samples, 0, MEM_RELEASE);
+    PlatformFreeGameMemory(gameMemory);
+
+    printf("bounce: %lld samples (%.2fs of audio) -> %s\n", (long long)samplesDone, seconds, path);
+    printf("  mix only : %.3f ms, %.0f samples/s (%.1fx realtime)\n",
+           mixSeconds * 1000.0, samplesDone / mixSeconds, (samplesDone / mixSeconds) / samplesPerSecond);
+    printf("  with disk: %.3f ms, %.0f samples/s (%.1fx realtime)\n",
+           totalSeconds * 1000.0, samplesDone / totalSeconds, (samplesDone / totalSeconds) / samplesPerSecond);
+    return 0;
+}
+
+// Encodes a wav into an .adp sound at the game's rate (or -rate), then decodes it back to report quality and decode speed
+internal auto RunAdpcmEncode(const char* cmdLine, const char* inPath) -> int
+{
+    char outPath[MAX_PATH];
+    if (!GetCommandLineArgument(cmdLine, "-out", outPath, sizeof(outPath)))
+    {
+        printf("adpcm: missing -out <file.adp>\n");
+        return -1;
+    }
+    int samplesPerSecond = 48000;
+    char value[MAX_PATH];
+    if (GetCommandLineArgument(cmdLine, "-rate", value, sizeof(value)))
+    {
+        samplesPerSecond = atoi(value);
+    }
+    else if (HasCommandLineFlag(cmdLine, "-rate"))
+    {
+        samplesPerSecond = 0;
+    }
+    if (samplesPerSecond <= 0)
+    {
+        printf("adpcm: -rate must be positive\n");
+        return -1;
+    }
+
+    WavStream stream;
+    if (!WavStreamOpen(stream, inPath))
+    {
+        printf("adpcm: could not read %s\n", inPath);
+        return -1;
+    }
+    uint32_t sourceFrameCount = (uint32_t)stream.frameCount;
+    int channels = stream.channels;
+    int sourceSamplesPerSecond = stream.samplesPerSecond;
+    // Converting here once means the mixer never has to resample this sound at runtime
+    bool resample = sourceSamplesPerSecond != samplesPerSecond;
+    uint32_t frameCount = resample ? (uint32_t)((uint64_t)sourceFrameCount * samplesPerSecond / sourceSamplesPerSecond)
+                                   : sourceFrameCount;
+    if (frameCount == 0)
+    {
+        printf("adpcm: %s has no audio\n", inPath);
+        WavStreamClose(stream);
+        return -1;
+    }
+
+    size_t encodedSize = AdpcmEncodedSize(channels, frameCount);
+    size_t floatBytes = (size_t)frameCount * sizeof(float);
+    size_t sourceBytes = resample ? (size_t)sourceFrameCount * sizeof(float) : 0;
+    size_t pcmBytes = (size_t)frameCount * sizeof(int16_t);
+    size_t scratchSize = 2 * floatBytes + 2 * sourceBytes + 2 * pcmBytes + sizeof(AdpcmFileHeader) + encodedSize +
+                         Megabytes(1);
+    uint8_t* scratch = (uint8_t*)VirtualAlloc(nullptr, scratchSize, MEM_COMMIT | MEM_RESERVE, PAGE_READWRITE);
+    if (!scratch)
+    {
+        WavStreamClose(stream);
+        return -1;
+    }
+    MemoryArena arena;
+    InitializeArena(arena, scratchSize, scratch);
+
+    float* left = PushArray(arena, frameCount, float);
+    float* right = PushArray(arena, frameCount, float);
+    int16_t* pcmLeft = PushArray(arena, frameCount, int16_t);
+    int16_t* pcmRight = PushArray(arena, frameCount, int16_t);
+    if (resample)
+    {
+        TemporaryMemory temp = BeginTemporaryMemory(arena);
+        float* sourceLeft = PushArray(arena, sourceFrameCount, float);
+        float* sourceRight = PushArray(arena, sourceFrameCount, float);
+        memset(sourceLeft, 0, sourceBytes);
+        memset(sourceRight, 0, sourceBytes);
+        uint64_t position = 0;
+        WavStreamMix(stream, position, sourceLeft, sourceRight, (int)sourceFrameCount, 1.0f);
+        frameCount = (uint32_t)ResampleBuffer(arena, ResampleQuality::High, sourceLeft, sourceRight, (int)sourceFrameCount,
+                                              sourceSamplesPerSecond, left, right, (int)frameCount, samplesPerSecond);
+        EndTemporaryMemory(temp);
+    }
+    else
+    {
+        uint64_t position = 0;
+        WavStreamMix(stream, position, left, right, (int)frameCount, 1.0f);
+    }
+    WavStreamClose(stream);
+    for (uint32_t i = 0; i < frameCount; ++i)
+    {
+        float l = left[i] * 32768.0f;
+        float r = right[i] * 32768.0f;
+        pcmLeft[i] = (int16_t)(l > 32767.0f ? 32767.0f : (l < -32768.0f ? -32768.0f : l));
+        pcmRight[i] = (int16_t)(r > 32767.0f ? 32767.0f : (r < -32768.0f ? -32768.0f : r));
+    }
+
+    encodedSize = AdpcmEncodedSize(channels, frameCount);
+    size_t fileSize = sizeof(AdpcmFileHeader) + encodedSize;
+    uint8_t* file = (uint8_t*)PushSize(arena, fileSize);
+    AdpcmFileHeader* header = (AdpcmFileHeader*)file;
+    memcpy(header->magic, "ADPC", 4);
+    header->version = 1;
+    header->samplesPerSecond = (uint32_t)samplesPerSecond;
+    header->channels = (uint16_t)channels;
+    header->blockFrames = ADPCM_BLOCK_FRAMES;
+    header->frameCount = frameCount;
+    uint32_t blockCount = AdpcmEncode(pcmLeft, pcmRight, channels, frameCount, file + sizeof(AdpcmFileHeader));
+    header->blockCount = blockCount;
+
+    HANDLE out = CreateFileA(outPath, GENERIC_WRITE, 0, nullptr, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
+    DWORD written = 0;
+    bool wrote = out != INVALID_HANDLE_VALUE && WriteFile(out, file, (DWORD)fileSize, &written, nullptr) && written == fileSize;
+    if (out != INVALID_HANDLE_VALUE)
+    {
+        CloseHandle(out);
+    }
+    if (!wrote)
+    {
+        printf("adpcm: could not write %s\n", outPath);
+        VirtualFree(scratch, 0, MEM_RELEASE);
+        return -1;
+    }
+
+    // Decode it back through the same path the mixer uses
+    AdpcmSound sound;
+    AdpcmDecoder decoder;
+    AdpcmLoad(sound, arena, file, fileSize);
+    AdpcmDecoderInitialize(decoder, arena);
+    memset(left, 0, floatBytes);
+    memset(right, 0, floatBytes);
+
+    LARGE_INTEGER frequency, decodeStart, decodeEnd;
+    QueryPerformanceFrequency(&frequency);
+    QueryPerformanceCounter(&decodeStart);
+    uint32_t position = 0;
+    AdpcmMix(sound, decoder, position, left, right, (int)frameCount, 1.0f);
+    QueryPerformanceCounter(&decodeEnd);
+    double decodeSeconds = SecondsElapsed(decodeStart, decodeEnd, frequency);
+
+    double signal = 0.0;
+    double noise = 0.0;
+    for (uint32_t i = 0; i < frameCount; ++i)
+    {
+        for (int channel = 0; channel < channels; ++channel)
+        {
+            double original = (channel == 0 ? pcmLeft[i] : pcmRight[i]) / 32768.0;
+            double error = (channel == 0 ? left[i] : right[i]) - original;
+            signal += original * original;
+            noise += error * error;
+        }
+    }
+    VirtualFree(scratch, 0, MEM_RELEASE);
+
+    uint64_t samples = (uint64_t)frameCount * channels;
+    printf("adpcm: %s -> %s\n", inPath, outPath);
+    printf("  %u frames, %d channel(s), %d hz (from %d hz), %u blocks\n", frameCount, channels, samplesPerSecond,
+           sourceSamplesPerSecond, blockCount);
+    printf("  %zu bytes from %llu (%.2f:1)\n", fileSize, (unsigned long long)(samples * 2),
+           (double)(samples * 2) / (double)fileSize);
+    printf("  snr %.1f dB, decode %.2f ns/sample (%.0fx realtime)\n",
+           noise > 0.0 ? 10.0 * log10(signal / noise) : 999.0,
+           decodeSeconds * 1e9 / (double)samples,
+           ((double)frameCount / decodeSeconds) / samplesPerSecond);
+    return 0;
+}
+
+#pragma region Ring benchmark
+
+// The per sample two region walk AudioWrite and AudioClear used before the span helpers
+internal void LegacyRegionWrite(const RingSpan& span, const int16_t* samples)
+{
+    uint32_t region1SampleCount = span.firstSize / 4;
+    uint32_t totalSampleCount = region1SampleCount + span.secondSize / 4;
+    int16_t* destSample = (int16_t*)span.first;
+    const int16_t* sourceSample = samples;
+    for (uint32_t i = 0; i < totalSampleCount; ++i)
+    {
+        if (i == region1SampleCount)
+        {
+            destSample = (int16_t*)span.second;
+        }
+        *destSample++ = samples ? *sourceSample++ : 0;
+        *destSample++ = samples ? *sourceSample++ : 0;
+    }
+}
+
+template <typename Op>
+internal double TimeRepeated(int repeats, LARGE_INTEGER frequency, Op op)
+{
+    LARGE_INTEGER start, end;
+    QueryPerformanceCounter(&start);
+    for (int i = 0; i < repeats; ++i)
+    {
+        op(i);
+    }
+    QueryPerformanceCounter(&end);
+    return SecondsElapsed(start, end, frequency) / repeats;
+}
+
+internal void ReportRing(const char* name, uint32_t bytes, double legacySeconds, double spanSeconds)
+{
+    printf("  %-22s %7u bytes: legacy %8.2f us (%5.2f GB/s), spans %8.2f us (%5.2f GB/s), %.1fx\n",
+           name, bytes, legacySeconds * 1e6, bytes / legacySeconds / 1e9, spanSeconds * 1e6,
+           bytes / spanSeconds / 1e9, legacySeconds / spanSeconds);
+}
+
+// Times a frame sized wrapping write and a whole buffer clear, the old walk against the span helpers
+internal auto RunRingBenchmark() -> int
+{
+    uint32_t bufferSize = 48000 * 4;                // the one second ring WinMain opens
+    uint32_t frameBytes = 48000 / 30 * 4;           // one 30hz frame of audio
+    uint8_t* ring = (uint8_t*)VirtualAlloc(nullptr, bufferSize + frameBytes, MEM_COMMIT | MEM_RESERVE, PAGE_READWRITE);
+    if (!ring)
+    {
+        return -1;
+    }
+    int16_t* samples = (int16_t*)(ring + bufferSize);
+    for (uint32_t i = 0; i < frameBytes / 2; ++i)
+    {
+        samples[i] = (int16_t)i;
+    }
+
+    LARGE_INTEGER frequency;
+    QueryPerformanceFrequency(&frequency);
+
+    // Walk the write position around the ring like the game loop does, so half the writes wrap
+    auto frameSpan = [&](int i)
+    {
+        uint32_t offset = (uint32_t)(((uint64_t)i * (frameBytes + 1000)) % bufferSize) & ~3u;
+        return RingSplit(ring, bufferSize, offset, frameBytes);
+    };
+    int frameRepeats = 20000;
+    double legacyWrite = TimeRepeated(frameRepeats, frequency, [&](int i) { LegacyRegionWrite(frameSpan(i), samples); });
+    double spanWrite = TimeRepeated(frameRepeats, frequency, [&](int i) { RingSpanCopyIn(frameSpan(i), samples); });
+
+    int clearRepeats = 2000;
+    RingSpan whole = RingSplit(ring, bufferSize, 0, bufferSize);
+    double legacyClear = TimeRepeated(clearRepeats, frequency, [&](int) { LegacyRegionWrite(whole, nullptr); });
+    double spanClear = TimeRepeated(clearRepeats, frequency, [&](int) { RingSpanZero(whole); });
+
+    // Make sure the last write actually landed where RingRead expects it
+    int16_t check[4];
+    RingSpanCopyIn(RingSplit(ring, bufferSize, bufferSize - 4, 8), samples);
+    RingRead(ring, bufferSize, bufferSize - 4, check, 8);
+    bool valid = check[0] == samples[0] && check[3] == samples[3];
+    VirtualFree(ring, 0, MEM_RELEASE);
+
+    printf("ring: %u byte ring%s\n", bufferSize, valid ? "" : " (WRAP CHECK FAILED)");
+    ReportRing("frame write (wrapping)", frameBytes, legacyWrite, spanWrite);
+    ReportRing("whole buffer clear", bufferSize, legacyClear, spanClear);
+    return valid ? 0 : -1;
+}
+
+#pragma endregion
+
+#pragma region Entity benchmark
+
+// One entity at a time through the scalar world position helpers over the whole store, what the sim region replaces
+internal void ReferenceEntityUpdate(EntityStore& store, World& world, float seconds, WorldPosition minCorner, v2 size)
+{
+    for (uint32_t i = 0; i < store.count; ++i)
+    {
+        v2 velocity = V2(store.velocityX[i], store.velocityY[i]);
+        WorldPosition oldPosition = GetEntityPosition(store, i);
+        WorldPosition position = OffsetPosition(world, oldPosition, seconds * velocity);
+        v2 relative = WorldSubtract(world, position, minCorner);
+        if ((relative.x < 0.0f && velocity.x < 0.0f) || (relative.x > size.x && velocity.x > 0.0f))
+        {
+            velocity.x = -velocity.x;
+        }
+        if ((relative.y < 0.0f && velocity.y < 0.0f) || (relative.y > size.y && velocity.y > 0.0f))
+        {
+            velocity.y = -velocity.y;
+        }
+        ChangeEntityChunk(world, store.slotOf[i], oldPosition, position);
+        store.chunkX[i] = position.chunkX;
+        store.chunkY[i] = position.chunkY;
+        store.offsetX[i] = position.offset.x;
+        store.offsetY[i] = position.offset.y;
+        store.velocityX[i] = velocity.x;
+        store.velocityY[i] = velocity.y;
+    }
+}
+
+// The frame the game runs: pull what is near center, move, bounce, write back
+internal auto SimRegionUpdate(MemoryArena& simArena, EntityStore& store, World& world, float seconds,
+                              WorldPosition center, v2 halfSize, WorldPosition minCorner, v2 size) -> uint32_t
+{
+    TemporaryMemory simMemory = BeginTemporaryMemory(simArena);
+    SimRegion* region = BeginSimRegion(simArena, world, store, center, halfSize);
+    v2 regionMin = WorldSubtract(world, minCorner, region->origin);
+    MoveSimEntities(*region, seconds);
+    ConfineSimEntities(*region, regionMin, regionMin + size);
+    EndSimRegion(*region, world, store);
+    uint32_t simulated = region->count;
+    EndTemporaryMemory(simMemory);
+    return simulated;
+}
+
+internal void SpawnBenchmarkEntities(EntityStore& store, MemoryArena& arena, World& world, uint32_t count,
+                                     WorldPosition minCorner, float side)
+{
+    InitializeWorld(world, arena, 1.4f);
+    InitializeEntityStore(store, arena, count);
+    RandomSeries series = RandomSeed(12345, RandomStream_Benchmark, 0);
+    for (uint32_t i = 0; i < count; ++i)
+    {
+        v2 offset = side * V2(RandomUnilateral(series), RandomUnilateral(series));
+        v2 velocity = 4.0f * V2(RandomBilateral(series), RandomBilateral(series));
+        AddEntity(store, world, OffsetPosition(world, minCorner, offset), velocity, 0.0f,
+                  EntityFlag_Moving | EntityFlag_Confined);
+    }
+    // Churn the ids so the columns and chunk lists have been swap-removed into, like a running game
+    for (uint32_t i = 0; i < count / 4; ++i)
+    {
+        RemoveEntity(store, world, {i * 3 % count, 1});
+    }
+    while (store.count < count)
+    {
+        AddEntity(store, world, OffsetPosition(world, minCorner, V2(0.5f * side, 0.5f * side)),
+                  0.5f * V2(RandomBilateral(series), RandomBilateral(series)), 0.0f, EntityFlag_Moving | EntityFlag_Confined);
+    }
+}
+
+// Every entity is filed under the chunk its position is in, exactly once
+internal auto ChunkListsMatch(EntityStore& store, World& world) -> bool
+{
+    uint32_t filed = 0;
+    for (uint32_t i = 0; i < world.tileMap.slotCount; ++i)
+    {
+        TileChunk* chunk = world.tileMap.slots[i].chunk;
+        for (WorldEntityBlock* block = chunk ? chunk->firstEntityBlock : nullptr; block; block = block->next)
+        {
+            for (uint32_t j = 0; j < block->count; ++j)
+            {
+                uint32_t index = store.slots[block->entitySlots[j]].denseIndex;
+                if (store.chunkX[index] != chunk->chunkX || store.chunkY[index] != chunk->chunkY)
+                {
+                    return false;
+                }
+                ++filed;
+            }
+        }
+    }
+    return filed == store.count;
+}
+
+// 50k confined movers far from the origin: the naive whole world update, a sim region over all of
+// them, and the region the game uses (two chunks either way of the camera)
+internal auto RunEntityBenchmark() -> int
+{
+    const uint32_t entityCount = 50000;
+    const float secondsPerFrame = 1.0f / 60.0f;
+    const int frames = 600;
+
+    size_t arenaSize = Megabytes(64);
+    void* memory = VirtualAlloc(nullptr, arenaSize, MEM_COMMIT | MEM_RESERVE, PAGE_READWRITE);
+    if (!memory)
+    {
+        return -1;
+    }
+    MemoryArena arena;
+    InitializeArena(arena, arenaSize / 2, memory);
+    MemoryArena simArena;
+    InitializeArena(simArena, arenaSize / 2, (uint8_t*)memory + arenaSize / 2);
+
+    // Far out so the chunk part is large and the offsets still only span a few chunks
+    WorldPosition minCorner = ChunkOrigin(100000000, -100000000);
+    World referenceWorld, world, cameraWorld;
+    float side = 8.0f * 1.4f * TILE_CHUNK_DIM;
+    v2 size = V2(side, side);
+    EntityStore reference, soa, cameraStore;
+    SpawnBenchmarkEntities(reference, arena, referenceWorld, entityCount, minCorner, side);
+    SpawnBenchmarkEntities(soa, arena, world, entityCount, minCorner, side);
+    SpawnBenchmarkEntities(cameraStore, arena, cameraWorld, entityCount, minCorner, side);
+    WorldPosition center = OffsetPosition(world, minCorner, 0.5f * size);
+    v2 cameraHalfSize = V2(2.0f * world.chunkSideInMeters, 2.0f * world.chunkSideInMeters);
+
+    // Check one frame against the reference before timing, over hundreds of frames rounding
+    // differences move bounces by a frame and the two drift apart legitimately
+    ReferenceEntityUpdate(reference, referenceWorld, secondsPerFrame, minCorner, size);
+    SimRegionUpdate(simArena, soa, world, secondsPerFrame, center, size, minCorner, size);
+    float worstError = 0.0f;
+    for (uint32_t i = 0; i < entityCount; ++i)
+    {
+        // Matched by slot, the sim region reorders the dense columns
+        uint32_t soaIndex = soa.slots[reference.slotOf[i]].denseIndex;
+        v2 delta = WorldSubtract(world, GetEntityPosition(soa, soaIndex), GetEntityPosition(reference, i));
+        worstError = fmaxf(worstError, fmaxf(fabsf(delta.x), fabsf(delta.y)));
+    }
+
+    LARGE_INTEGER frequency;
+    QueryPerformanceFrequency(&frequency);
+    double referenceSeconds = TimeRepeated(frames, frequency, [&](int)
+    {
+        ReferenceEntityUpdate(reference, referenceWorld, secondsPerFrame, minCorner, size);
+    });
+    uint32_t simulated = 0;
+    double soaSeconds = TimeRepeated(frames, frequency, [&](int)
+    {
+        simulated = SimRegionUpdate(simArena, soa, world, secondsPerFrame, center, size, minCorner, size);
+    });
+    uint32_t cameraSimulated = 0;
+    double cameraSeconds = TimeRepeated(frames, frequency, [&](int)
+    {
+        cameraSimulated = SimRegionUpdate(simArena, cameraStore, cameraWorld, secondsPerFrame, center, cameraHalfSize,
+                                          minCorner, size);
+    });
+
+    bool listsValid = ChunkListsMatch(reference, referenceWorld) && ChunkListsMatch(soa, world) &&
+                      ChunkListsMatch(cameraStore, cameraWorld);
+    VirtualFree(memory, 0, MEM_RELEASE);
+
+    bool valid = worstError < 1e-4f && listsValid;
+    printf("entities: %u movers, %d frames at 60hz%s%s\n", entityCount, frames, worstError < 1e-4f ? "" : " (MISMATCH)",
+           listsValid ? "" : " (CHUNK LISTS BROKEN)");
+    printf("  whole world reference %8.1f us/frame\n", referenceSeconds * 1e6);
+    printf("  sim region, all       %8.1f us/frame, %5u simulated (%.1fx), first frame error %g m\n",
+           soaSeconds * 1e6, simulated, referenceSeconds / soaSeconds, worstError);
+    printf("  sim region, camera    %8.1f us/frame, %5u simulated, %.2f%% of a 60hz frame\n",
+           cameraSeconds * 1e6, cameraSimulated, cameraSeconds * 100.0 / secondsPerFrame);
+    return valid ? 0 : -1;
+}
+
+#pragma endregion
+
+#pragma region Collision benchmark
+
+// Every pair through the narrow phase, the O(n^2) the broad phase exists to avoid. Returns the contact
+// count and an order independent checksum of the pairs so the broad phase can be checked against it.
+internal auto BruteForceContacts(SimRegion& region, float seconds, uint64_t& pairChecksum) -> uint32_t
+{
+    uint32_t contactCount = 0;
+    pairChecksum = 0;
+    for (uint32_t a = 0; a < region.count; ++a)
+    {
+        for (uint32_t b = a + 1; b < region.count; ++b)
+        {
+            v2 offset = V2(region.positionX[a] - region.positionX[b], region.positionY[a] - region.positionY[b]);
+            v2 move = seconds * V2(region.velocityX[a] - region.velocityX[b], region.velocityY[a] - region.velocityY[b]);
+            float t;
+            v2 normal;
+            if (SweptAabb(offset, move, region.radius[a] + region.radius[b], t, normal))
+            {
+                ++contactCount;
+                pairChecksum += ((uint64_t)a << 32 | b) * 0x9E3779B97F4A7C15ull;
+            }
+        }
+    }
+    return contactCount;
+}
+
+internal auto ContactChecksum(ContactList& contacts) -> uint64_t
+{
+    uint64_t checksum = 0;
+    for (uint32_t i = 0; i < contacts.count; ++i)
+    {
+        uint32_t a = contacts.contacts[i].a < contacts.contacts[i].b ? contacts.contacts[i].a : contacts.contacts[i].b;
+        uint32_t b = contacts.contacts[i].a < contacts.contacts[i].b ? contacts.contacts[i].b : contacts.contacts[i].a;
+        checksum += ((uint64_t)a << 32 | b) * 0x9E3779B97F4A7C15ull;
+    }
+    return checksum;
+}
+
+// 10k colliders at the demo's density, simulated in one sim region with collisions on
+internal auto RunCollisionBenchmark() -> int
+{
+    const uint32_t colliderCount = 10000;
+    const float secondsPerFrame = 1.0f / 60.0f;
+    const int frames = 300;
+
+    size_t arenaSize = Megabytes(64);
+    void* memory = VirtualAlloc(nullptr, arenaSize, MEM_COMMIT | MEM_RESERVE, PAGE_READWRITE);
+    if (!memory)
+    {
+        return -1;
+    }
+    MemoryArena arena;
+    InitializeArena(arena, arenaSize / 2, memory);
+    MemoryArena simArena;
+    InitializeArena(simArena, arenaSize / 2, (uint8_t*)memory + arenaSize / 2);
+
+    World world;
+    InitializeWorld(world, arena, 1.4f);
+    EntityStore store;
+    InitializeEntityStore(store, arena, colliderCount);
+    const float side = 80.0f;
+    WorldPosition minCorner = ChunkOrigin(-2, -2);
+    RandomSeries series = RandomSeed(777, RandomStream_Benchmark, 0);
+    for (uint32_t i = 0; i < colliderCount; ++i)
+    {
+        v2 offset = side * V2(RandomUnilateral(series), RandomUnilateral(series));
+        v2 velocity = 4.0f * V2(RandomBilateral(series), RandomBilateral(series));
+        AddEntity(store, world, OffsetPosition(world, minCorner, offset), velocity, 0.12f,
+                  EntityFlag_Moving | EntityFlag_Confined | EntityFlag_Collides);
+    }
+    WorldPosition center = OffsetPosition(world, minCorner, V2(0.5f * side, 0.5f * side));
+    v2 halfSize = V2(side, side);
+
+    LARGE_INTEGER frequency;
+    QueryPerformanceFrequency(&frequency);
+    double collideSeconds = 0.0;
+    double worstSeconds = 0.0;
+    uint64_t contactTotal = 0;
+    uint64_t candidateTotal = 0;
+    uint32_t dropped = 0;
+    bool valid = true;
+    for (int frame = 0; frame < frames; ++frame)
+    {
+        TemporaryMemory simMemory = BeginTemporaryMemory(simArena);
+        SimRegion* region = BeginSimRegion(simArena, world, store, center, halfSize);
+
+        LARGE_INTEGER start, end;
+        QueryPerformanceCounter(&start);
+        ContactList contacts = FindSimContacts(simArena, *region, secondsPerFrame);
+        QueryPerformanceCounter(&end);
+        if (frame == 0)
+        {
+            uint64_t bruteChecksum;
+            uint32_t bruteCount = BruteForceContacts(*region, secondsPerFrame, bruteChecksum);
+            valid = bruteCount == contacts.count && bruteChecksum == ContactChecksum(contacts);
+            printf("collide: %u colliders, first frame %u contacts, brute force %u%s\n", region->count,
+                   contacts.count, bruteCount, valid ? "" : " (MISMATCH)");
+        }
+        LARGE_INTEGER resolveStart;
+        QueryPerformanceCounter(&resolveStart);
+        ResolveSimContacts(*region, contacts);
+        LARGE_INTEGER resolveEnd;
+        QueryPerformanceCounter(&resolveEnd);
+
+        double seconds = SecondsElapsed(start, end, frequency) + SecondsElapsed(resolveStart, resolveEnd, frequency);
+        collideSeconds += seconds;
+        worstSeconds = seconds > worstSeconds ? seconds : worstSeconds;
+        contactTotal += contacts.count;
+        candidateTotal += contacts.candidateCount;
+        dropped += contacts.droppedCount;
+
+        v2 regionMin = WorldSubtract(world, minCorner, region->origin);
+        MoveSimEntities(*region, secondsPerFrame);
+        ConfineSimEntities(*region, regionMin, regionMin + V2(side, side));
+        EndSimRegion(*region, world, store);
+        EndTemporaryMemory(simMemory);
+    }
+    VirtualFree(memory, 0, MEM_RELEASE);
+
+    printf("  %d frames: %.1f us/frame average, %.1f us worst, %.1f candidates and %.1f contacts per frame%s\n",
+           frames, collideSeconds * 1e6 / frames, worstSeconds * 1e6, (double)candidateTotal / frames,
+           (double)contactTotal / frames, dropped ? " (CONTACTS DROPPED)" : "");
+    return valid ? 0 : -1;
+}
+
+#pragma endregion
+
+#pragma region Path benchmark
+
+#define PATH_BENCH_MAP_DIM 512
+
+// Plain Dijkstra with the same moves and costs, over the whole map rather than a window. The
+// windowed search can only match it or miss a detour, never beat it. Returns 0 for no path.
+internal auto ReferencePathCost(const uint8_t* walkable, int32_t startX, int32_t startY, int32_t goalX,
+                                int32_t goalY) -> uint32_t
+{
+    const int32_t dim = PATH_BENCH_MAP_DIM;
+    const int32_t stepX[8] = {1, -1, 0, 0, 1, -1, 1, -1};
+    const int32_t stepY[8] = {0, 0, 1, -1, 1, 1, -1, -1};
+    std::vector<uint32_t> cost(dim * dim, 0xFFFFFFFF);
+    typedef std::pair<uint32_t, int32_t> Entry;
+    std::priority_queue<Entry, std::vector<Entry>, std::greater<Entry>> open;
+    cost[startY * dim + startX] = 0;
+    open.push({0, startY * dim + startX});
+    while (!open.empty())
+    {
+        Entry entry = open.top();
+        open.pop();
+        int32_t x = entry.second % dim;
+        int32_t y = entry.second / dim;
+        if (entry.first != cost[entry.second])
+        {
+            continue;
+        }
+        if (x == goalX && y == goalY)
+        {
+            return entry.first;
+        }
+        for (int direction = 0; direction < 8; ++direction)
+        {
+            int32_t nx = x + stepX[direction];
+            int32_t ny = y + stepY[direction];
+            if (nx < 0 || ny < 0 || nx >= dim || ny >= dim || !walkable[ny * dim + nx])
+            {
+                continue;
+            }
+            if (direction >= 4 && (!walkable[y * dim + nx] || !walkable[ny * dim + x]))
+            {
+                continue;
+            }
+            uint32_t newCost = entry.first + (direction >= 4 ? 14 : 10);
+            if (newCost < cost[ny * dim + nx])
+            {
+                cost[ny * dim + nx] = newCost;
+                open.push({newCost, ny * dim + nx});
+            }
+        }
+    }
+    return 0;
+}
+
+// Steps are single tiles onto floor, diagonals don't clip corners, and they add up to the cost
+internal auto PathIsValid(const uint8_t* walkable, PathRequest& request) -> bool
+{
+    const int32_t dim = PATH_BENCH_MAP_DIM;
+    if (request.tileX[0] != request.startX || request.tileY[0] != request.startY)
+    {
+        return false;
+    }
+    uint32_t cost = 0;
+    for (uint32_t i = 1; i < request.length; ++i)
+    {
+        int32_t x = request.tileX[i];
+        int32_t y = request.tileY[i];
+        int32_t deltaX = x - request.tileX[i - 1];
+        int32_t deltaY = y - request.tileY[i - 1];
+        if (deltaX < -1 || deltaX > 1 || deltaY < -1 || deltaY > 1 || (deltaX == 0 && deltaY == 0) ||
+            !walkable[y * dim + x] || !walkable[y * dim + x - deltaX] || !walkable[(y - deltaY) * dim + x])
+        {
+            return false;
+        }
+        cost += deltaX && deltaY ? 14 : 10;
+    }
+    bool isComplete = request.length == request.totalLength;
+    return !isComplete || (cost == request.cost && request.tileX[request.length - 1] == request.goalX &&
+                           request.tileY[request.length - 1] == request.goalY);
+}
+
+internal auto PathResultChecksum(PathRequest* requests, uint32_t count) -> uint64_t
+{
+    uint64_t checksum = 0;
+    for (uint32_t i = 0; i < count; ++i)
+    {
+        checksum = checksum * 31 + requests[i].status;
+        checksum = checksum * 31 + requests[i].cost;
+        for (uint32_t tile = 0; tile < requests[i].length; ++tile)
+        {
+            checksum = checksum * 31 + (uint32_t)(requests[i].tileX[tile] * 65536 + requests[i].tileY[tile]);
+        }
+    }
+    return checksum;
+}
+
+// Random queries up to 60 tiles apart on a map with a sixth of the tiles walled off. Runs them
+// on one thread, then across the worker queue, then again in 1ms frames.
+internal auto RunPathBenchmark() -> int
+{
+    const uint32_t requestCount = 4096;
+    const uint32_t referenceCount = 512;
+    const int32_t range = 60;
+
+    size_t arenaSize = Megabytes(64);
+    void* memory = VirtualAlloc(nullptr, arenaSize, MEM_COMMIT | MEM_RESERVE, PAGE_READWRITE);
+    if (!memory)
+    {
+        return -1;
+    }
+    MemoryArena arena;
+    InitializeArena(arena, arenaSize, memory);
+
+    uint32_t processorCount = PlatformGetProcessorCount();
+    PlatformWorkQueue* workQueue = PlatformCreateWorkQueue(processorCount > 1 ? processorCount - 1 : 0);
+    Pathfinder pathfinder;
+    InitializePathfinder(pathfinder, arena, PlatformGetWorkerCount(workQueue), requestCount);
+
+    TileMap tileMap;
+    InitializeTileMap(tileMap, arena, 1.4f);
+    uint8_t* walkable = PushArray(arena, PATH_BENCH_MAP_DIM * PATH_BENCH_MAP_DIM, uint8_t);
+    RandomSeries series = RandomSeed(4242, RandomStream_Benchmark, 0);
+    for (int32_t y = 0; y < PATH_BENCH_MAP_DIM; ++y)
+    {
+        for (int32_t x = 0; x < PATH_BENCH_MAP_DIM; ++x)
+        {
+            bool isFloor = RandomChoice(series, 6) != 0;
+            SetTileValue(tileMap, x, y, isFloor ? TileValue_Floor : TileValue_Wall);
+            walkable[y * PATH_BENCH_MAP_DIM + x] = isFloor;
+        }
+    }
+
+    PathRequest* requests = PushArray(arena, requestCount, PathRequest);
+    for (uint32_t i = 0; i < requestCount; ++i)
+    {
+        PathRequest& request = requests[i];
+        do
+        {
+            request.startX = range + (int32_t)RandomChoice(series, PATH_BENCH_MAP_DIM - 2 * range);
+            request.startY = range + (int32_t)RandomChoice(series, PATH_BENCH_MAP_DIM - 2 * range);
+            request.goalX = request.startX - range + (int32_t)RandomChoice(series, 2 * range + 1);
+            request.goalY = request.startY - range + (int32_t)RandomChoice(series, 2 * range + 1);
+        } while (!walkable[request.startY * PATH_BENCH_MAP_DIM + request.startX] ||
+                 !walkable[request.goalY * PATH_BENCH_MAP_DIM + request.goalX]);
+    }
+
+    LARGE_INTEGER frequency;
+    QueryPerformanceFrequency(&frequency);
+    auto runAll = [&](PlatformWorkQueue* queue, float budgetSeconds, uint32_t& frames, double& worstSeconds) -> double
+    {
+        for (uint32_t i = 0; i < requestCount; ++i)
+        {
+            QueuePathRequest(pathfinder, requests[i]);
+        }
+        frames = 0;
+        worstSeconds = 0.0;
+        LARGE_INTEGER start, end;
+        QueryPerformanceCounter(&start);
+        while (pathfinder.queueCount > 0 || pathfinder.suspendedCount > 0)
+        {
+            LARGE_INTEGER frameStart, frameEnd;
+            QueryPerformanceCounter(&frameStart);
+            RunPathRequests(pathfinder, tileMap, queue, budgetSeconds);
+            QueryPerformanceCounter(&frameEnd);
+            double seconds = SecondsElapsed(frameStart, frameEnd, frequency);
+            worstSeconds = seconds > worstSeconds ? seconds : worstSeconds;
+            ++frames;
+        }
+        QueryPerformanceCounter(&end);
+        return SecondsElapsed(start, end, frequency);
+    };
+
+    uint32_t frames;
+    double worstSeconds;
+    double singleSeconds = runAll(nullptr, 1000.0f, frames, worstSeconds);
+    uint64_t singleChecksum = PathResultChecksum(requests, requestCount);
+
+    uint32_t found = 0;
+    uint32_t invalid = 0;
+    uint32_t windowMisses = 0;
+    uint64_t expanded = pathfinder.contexts[0].expandedNodes;
+    for (uint32_t i = 0; i < requestCount; ++i)
+    {
+        PathRequest& request = requests[i];
+        if (request.status == PathStatus_Found)
+        {
+            ++found;
+            invalid += !PathIsValid(walkable, request);
+        }
+        if (i < referenceCount)
+        {
+            uint32_t referenceCost =
+                ReferencePathCost(walkable, request.startX, request.startY, request.goalX, request.goalY);
+            uint32_t cost = request.status == PathStatus_Found ? request.cost : 0;
+            if (cost != referenceCost)
+            {
+                // Only a detour outside the window may make the windowed search worse, never better
+                bool isWindowMiss = referenceCost && (cost == 0 || cost > referenceCost);
+                windowMisses += isWindowMiss;
+                invalid += !isWindowMiss;
+            }
+        }
+    }
+
+    double parallelSeconds = runAll(workQueue, 1000.0f, frames, worstSeconds);
+    bool deterministic = PathResultChecksum(requests, requestCount) == singleChecksum;
+    runAll(workQueue, 0.001f, frames, worstSeconds);
+    deterministic = deterministic && PathResultChecksum(requests, requestCount) == singleChecksum;
+    VirtualFree(memory, 0, MEM_RELEASE);
+
+    printf("path: %u queries, %u found, %.0f nodes expanded per query, %u invalid, %u of %u missed a detour "
+           "outside the window\n",
+           requestCount, found, (double)expanded / requestCount, invalid, windowMisses, referenceCount);
+    printf("  one thread      %.1f us/query\n", singleSeconds * 1e6 / requestCount);
+    printf("  %2u threads      %.1f us/query, %.1fx%s\n", PlatformGetWorkerCount(workQueue),
+           parallelSeconds * 1e6 / requestCount, singleSeconds / parallelSeconds,
+           deterministic ? "" : " (RESULTS DIFFER)");
+    printf("  1ms budget      %u frames, %.1f queries per frame, %.2f ms worst frame\n", frames,
+           (double)requestCount / frames, worstSeconds * 1e3);
+    return invalid == 0 && deterministic ? 0 : -1;
+}
+
+#pragma endregion
+
+#pragma region World generation benchmark
+
+internal auto ChunkTilesChecksum(World& world, int32_t radius) -> uint64_t
+{
+    uint64_t checksum = 0;
+    for (int32_t chunkY = -radius; chunkY <= radius; ++chunkY)
+    {
+        for (int32_t chunkX = -radius; chunkX <= radius; ++chunkX)
+        {
+            TileChunk* chunk = GetReadableTileChunk(world.tileMap, chunkX, chunkY);
+            for (uint32_t i = 0; i < TILE_CHUNK_DIM * TILE_CHUNK_DIM; ++i)
+            {
+                checksum = checksum * 31 + (chunk ? chunk->tiles[i] : 0xFF);
+            }
+        }
+    }
+    return checksum;
+}
+
+// Fills the same square of chunks inline, on the background workers, and directly in reverse
+// order; every way has to give the same tiles
+internal auto RunWorldGenBenchmark() -> int
+{
+    const uint32_t seed = 0x5EED1234;
+    const int32_t radius = 20;
+    const uint32_t chunkCount = (2 * radius + 1) * (2 * radius + 1);
+
+    size_t arenaSize = Megabytes(64);
+    void* memory = VirtualAlloc(nullptr, arenaSize, MEM_COMMIT | MEM_RESERVE, PAGE_READWRITE);
+    if (!memory)
+    {
+        return -1;
+    }
+    MemoryArena arena;
+    InitializeArena(arena, arenaSize, memory);
+
+    LARGE_INTEGER frequency;
+    QueryPerformanceFrequency(&frequency);
+
+    World inlineWorld;
+    InitializeWorld(inlineWorld, arena, 1.4f);
+    WorldGenerator* generator = PushStruct(arena, WorldGenerator);
+    InitializeWorldGenerator(*generator, seed, nullptr);
+    LARGE_INTEGER start, end;
+    QueryPerformanceCounter(&start);
+    GenerateChunksAround(*generator, inlineWorld, 0, 0, radius);
+    QueryPerformanceCounter(&end);
+    double inlineSeconds = SecondsElapsed(start, end, frequency);
+    uint64_t inlineChecksum = ChunkTilesChecksum(inlineWorld, radius);
+
+    // Queued a frame's worth at a time, the way the game calls it, until every chunk is out
+    uint32_t processorCount = PlatformGetProcessorCount();
+    PlatformWorkQueue* backgroundQueue = PlatformCreateWorkQueue(processorCount > 4 ? 2 : 1);
+    World queuedWorld;
+    InitializeWorld(queuedWorld, arena, 1.4f);
+    InitializeWorldGenerator(*generator, seed, backgroundQueue);
+    double worstCallSeconds = 0.0;
+    double callSeconds = 0.0;
+    uint32_t calls = 0;
+    QueryPerformanceCounter(&start);
+    while (generator->chunksGenerated < chunkCount)
+    {
+        LARGE_INTEGER callStart, callEnd;
+        QueryPerformanceCounter(&callStart);
+        GenerateChunksAround(*generator, queuedWorld, 0, 0, radius);
+        QueryPerformanceCounter(&callEnd);
+        double seconds = SecondsElapsed(callStart, callEnd, frequency);
+        worstCallSeconds = seconds > worstCallSeconds ? seconds : worstCallSeconds;
+        callSeconds += seconds;
+        ++calls;
+    }
+    WaitForWorldGenerator(*generator);
+    QueryPerformanceCounter(&end);
+    double queuedSeconds = SecondsElapsed(start, end, frequency);
+    uint64_t queuedChecksum = ChunkTilesChecksum(queuedWorld, radius);
+
+    World reverseWorld;
+    InitializeWorld(reverseWorld, arena, 1.4f);
+    for (int32_t chunkY = radius; chunkY >= -radius; --chunkY)
+    {
+        for (int32_t chunkX = radius; chunkX >= -radius; --chunkX)
+        {
+            TileChunk* chunk = GetOrCreateTileChunk(reverseWorld.tileMap, chunkX, chunkY);
+            GenerateChunkTiles(seed, chunkX, chunkY, chunk->tiles);
+            chunk->state = TileChunkState_Ready;
+        }
+    }
+    uint64_t reverseChecksum = ChunkTilesChecksum(reverseWorld, radius);
+    VirtualFree(memory, 0, MEM_RELEASE);
+
+    bool valid = inlineChecksum == queuedChecksum && inlineChecksum == reverseChecksum;
+    printf("worldgen: %u chunks%s\n", chunkCount, valid ? "" : " (WORLDS DIFFER)");
+    printf("  inline          %.1f us/chunk\n", inlineSeconds * 1e6 / chunkCount);
+    printf("  background      %.1f us/chunk over %u calls, main thread %.1f us average and %.1f us worst call\n",
+           queuedSeconds * 1e6 / chunkCount, calls, callSeconds * 1e6 / calls, worstCallSeconds * 1e6);
+    return valid ? 0 : -1;
+}
+
+#pragma endregion
+
+#pragma region Random benchmark
+
+#define RANDOM_BENCH_COUNT (1 << 20)
+
+internal void FillScalar(RandomSeries* lanes, uint32_t* dest, uint32_t count)
+{
+    for (uint32_t i = 0; i < count; i += LANE8_WIDTH)
+    {
+        for (uint32_t lane = 0; lane < LANE8_WIDTH; ++lane)
+        {
+            dest[i + lane] = RandomNext(lanes[lane]);
+        }
+    }
+}
+
+internal void FillSSE(RandomSeries8& series, uint32_t* dest, uint32_t count)
+{
+    for (uint32_t i = 0; i < count; i += LANE8_WIDTH)
+    {
+        Store(dest + i, RandomNext4(series, 0));
+        Store(dest + i + LANE_WIDTH, RandomNext4(series, 1));
+    }
+}
+
+SIMD_TARGET_AVX2 internal void FillAVX2(RandomSeries8& series, uint32_t* dest, uint32_t count)
+{
+    for (uint32_t i = 0; i < count; i += LANE8_WIDTH)
+    {
+        Store(dest + i, RandomNext8(series));
+    }
+}
+
+// Eight scalar series, the SSE halves and the AVX2 lanes have to give the very same values,
+// and the unilateral floats have to fill [0, 1) evenly
+internal auto RunRandomBenchmark() -> int
+{
+    const uint64_t seed = 0x5EED1234;
+    const uint64_t index = 3;
+    const uint32_t count = RANDOM_BENCH_COUNT;
+
+    size_t bufferSize = 4 * count * sizeof(uint32_t);
+    uint32_t* scalar = (uint32_t*)VirtualAlloc(nullptr, bufferSize, MEM_COMMIT | MEM_RESERVE, PAGE_READWRITE);
+    if (!scalar)
+    {
+        return -1;
+    }
+    uint32_t* sse = scalar + count;
+    uint32_t* avx2 = sse + count;
+    float* unilateral = (float*)(avx2 + count);
+
+    LARGE_INTEGER frequency;
+    QueryPerformanceFrequency(&frequency);
+    const int repeats = 20;
+
+    RandomSeries lanes[LANE8_WIDTH];
+    for (uint32_t lane = 0; lane < LANE8_WIDTH; ++lane)
+    {
+        lanes[lane] = RandomSeed(seed, RandomStream_Benchmark, index * LANE8_WIDTH + lane);
+    }
+    RandomSeries8 series = RandomSeed8(seed, RandomStream_Benchmark, index);
+    double scalarSeconds = TimeRepeated(repeats, frequency, [&](int) { FillScalar(lanes, scalar, count); });
+    double sseSeconds = TimeRepeated(repeats, frequency, [&](int) { FillSSE(series, sse, count); });
+    bool valid = memcmp(scalar, sse, count * sizeof(uint32_t)) == 0;
+
+    bool hasAvx2 = CpuHasAvx2();
+    double avx2Seconds = 0.0;
+    if (hasAvx2)
+    {
+        series = RandomSeed8(seed, RandomStream_Benchmark, index);
+        avx2Seconds = TimeRepeated(repeats, frequency, [&](int) { FillAVX2(series, avx2, count); });
+        valid = valid && memcmp(scalar, avx2, count * sizeof(uint32_t)) == 0;
+    }
+
+    // 64 buckets, a fair generator stays well under the chi-squared 0.1% tail of ~104
+    uint32_t buckets[64] = {};
+    series = RandomSeed8(seed, RandomStream_Particles, 0);
+    FillRandomUnilateral(series, unilateral, count);
+    bool inRange = true;
+    for (uint32_t i = 0; i < count; ++i)
+    {
+        inRange = inRange && unilateral[i] >= 0.0f && unilateral[i] < 1.0f;
+        ++buckets[(uint32_t)(unilateral[i] * 64.0f) & 63];
+    }
+    double expected = (double)count / 64.0;
+    double chiSquared = 0.0;
+    for (uint32_t i = 0; i < 64; ++i)
+    {
+        double difference = buckets[i] - expected;
+        chiSquared += difference * difference / expected;
+    }
+    VirtualFree(scalar, 0, MEM_RELEASE);
+
+    bool uniform = inRange && chiSquared < 104.0;
+    printf("random: %u values per fill%s%s\n", count, valid ? "" : " (LANES DIFFER)",
+           uniform ? "" : " (NOT UNIFORM)");
+    printf("  scalar x8       %.2f ns/value\n", scalarSeconds * 1e9 / count);
+    printf("  sse 2x4         %.2f ns/value\n", sseSeconds * 1e9 / count);
+    if (hasAvx2)
+    {
+        printf("  avx2 8          %.2f ns/value\n", avx2Seconds * 1e9 / count);
+    }
+    printf("  unilateral chi-squared over 64 buckets %.1f\n", chiSquared);
+    return valid && uniform ? 0 : -1;
+}
+
+#pragma endregion
+
+#pragma region Particle benchmark
+
+#define PARTICLE_BENCH_WIDTH 960
+#define PARTICLE_BENCH_HEIGHT 540
+
+struct ParticleBenchResult
+{
+    uint32_t liveCount;
+    uint64_t imageChecksum;
+    double updateSeconds;   // per frame, averaged over the frames after the pool filled up
+    double renderSeconds;
+};
+
+// Four fountains feeding 100k live particles, the last frame rendered over black
+internal auto RunParticleFrames(MemoryArena& arena, uint32_t* pixels, PlatformWorkQueue* workQueue)
+    -> ParticleBenchResult
+{
+    const float seconds = 1.0f / 60.0f;
+    const uint32_t frameCount = 360;
+    const uint32_t warmupFrames = 180;
+    TemporaryMemory particleMemory = BeginTemporaryMemory(arena);
+    ParticleSystem* system = PushStruct(arena, ParticleSystem);
+    InitializeParticleSystem(*system, arena, 131072, ChunkOrigin(0, 0), 1.2f, 0x5EED1234);
+
+    ParticleCamera camera = {};
+    camera.metersToPixels = 24.0f / 1.4f;
+    camera.width = PARTICLE_BENCH_WIDTH;
+    camera.height = PARTICLE_BENCH_HEIGHT;
+    OffscreenBuffer buffer = {pixels, PARTICLE_BENCH_WIDTH, PARTICLE_BENCH_HEIGHT, 4, PARTICLE_BENCH_WIDTH * 4};
+
+    LARGE_INTEGER frequency;
+    QueryPerformanceFrequency(&frequency);
+    ParticleBenchResult result = {};
+    for (uint32_t frame = 0; frame < frameCount; ++frame)
+    {
+        for (uint32_t i = 0; i < 4; ++i)
+        {
+            ParticleEmitter emitter = {};
+            emitter.position = V2(i & 1 ? 12.0f : -12.0f, i & 2 ? 6.0f : -6.0f);
+            emitter.speedSpread = 7.0f;
+            emitter.lifetime = 2.0f;
+            emitter.lifetimeSpread = 0.5f;
+            emitter.color = V3(0.1f * (float)(i + 1), 0.2f, 0.4f - 0.1f * (float)i);
+            SpawnParticles(*system, emitter, 208);
+        }
+        memset(pixels, 0, PARTICLE_BENCH_WIDTH * PARTICLE_BENCH_HEIGHT * sizeof(uint32_t));
+
+        LARGE_INTEGER start, updated, rendered;
+        QueryPerformanceCounter(&start);
+        UpdateParticles(*system, seconds, camera, workQueue);
+        QueryPerformanceCounter(&updated);
+        RenderParticles(*system, buffer, workQueue);
+        QueryPerformanceCounter(&rendered);
+        if (frame >= warmupFrames)
+        {
+            result.updateSeconds += SecondsElapsed(start, updated, frequency);
+            result.renderSeconds += SecondsElapsed(updated, rendered, frequency);
+        }
+    }
+    result.updateSeconds /= frameCount - warmupFrames;
+    result.renderSeconds /= frameCount - warmupFrames;
+    result.liveCount = system->liveCount;
+    for (uint32_t i = 0; i < PARTICLE_BENCH_WIDTH * PARTICLE_BENCH_HEIGHT; ++i)
+    {
+        result.imageChecksum = result.imageChecksum * 31 + pixels[i];
+    }
+    EndTemporaryMemory(particleMemory);
+    return result;
+}
+
+// The same frames on one thread and on the whole pool have to give the same image
+internal auto RunParticleBenchmark() -> int
+{
+    size_t arenaSize = Megabytes(32);
+    void* memory = VirtualAlloc(nullptr, arenaSize, MEM_COMMIT | MEM_RESERVE, PAGE_READWRITE);
+    if (!memory)
+    {
+        return -1;
+    }
+    MemoryArena arena;
+    InitializeArena(arena, arenaSize, memory);
+    uint32_t* pixels = PushArray(arena, PARTICLE_BENCH_WIDTH * PARTICLE_BENCH_HEIGHT, uint32_t);
+
+    ParticleBenchResult single = RunParticleFrames(arena, pixels, nullptr);
+    uint32_t processorCount = PlatformGetProcessorCount();
+    PlatformWorkQueue* workQueue = PlatformCreateWorkQueue(processorCount > 1 ? processorCount - 1 : 0);
+    ParticleBenchResult pooled = RunParticleFrames(arena, pixels, workQueue);
+    VirtualFree(memory, 0, MEM_RELEASE);
+
+    bool valid = single.liveCount == pooled.liveCount && single.imageChecksum == pooled.imageChecksum;
+    double frameSeconds = 1.0 / 60.0;
+    printf("particles: %u live, %ux%u%s%s\n", pooled.liveCount, PARTICLE_BENCH_WIDTH, PARTICLE_BENCH_HEIGHT,
+           CpuHasAvx2() ? ", avx2" : ", sse2", valid ? "" : " (IMAGES DIFFER)");
+    printf("  one thread      update %.1f us, render %.1f us, %.2f%% of a 60hz frame\n", single.updateSeconds * 1e6,
+           single.renderSeconds * 1e6, (single.updateSeconds + single.renderSeconds) * 100.0 / frameSeconds);
+    printf("  %2u threads      update %.1f us, render %.1f us, %.2f%% of a 60hz frame\n",
+           PlatformGetWorkerCount(workQueue), pooled.updateSeconds * 1e6, pooled.renderSeconds * 1e6,
+           (pooled.updateSeconds + pooled.renderSeconds) * 100.0 / frameSeconds);
+    return valid ? 0 : -1;
+}
+
+#pragma endregion
+
+auto RunHeadless(const char* cmdLine) -> int
+{
+    char path[MAX_PATH];
+    if (GetCommandLineArgument(cmdLine, "-bounce", path, sizeof(path)))
+    {
+        return RunAudioBounce(cmdLine, path);
+    }
+    if (HasCommandLineFlag(cmdLine, "-bench-ring"))
+    {
+        return RunRingBenchmark();
+    }
+    if (HasCommandLineFlag(cmdLine, "-bench-entities"))
+    {
+        return RunEntityBenchmark();
+    }
+    if (HasCommandLineFlag(cmdLine, "-bench-collide"))
+    {
+        return RunCollisionBenchmark();
+    }
+    if (HasCommandLineFlag(cmdLine, "-bench-path"))
+    {
+        return RunPathBenchmark();
+    }
+    if (HasCommandLineFlag(cmdLine, "-bench-worldgen"))
+    {
+        return RunWorldGenBenchmark();
+    }
+    if (HasCommandLineFlag(cmdLine, "-bench-random"))
+    {
+        return RunRandomBenchmark();
+    }
+    if (HasCommandLineFlag(cmdLine, "-bench-particles"))
+    {
+        return RunParticleBenchmark();
+    }
+    if (GetCommandLineArgument(cmdLine, "-adpcm-encode", path, sizeof(path)))
+    {
+        return RunAdpcmEncode(cmdLine, path);
+    }
+
+    printf("usage: game -headless -bounce <out.wav> [-seconds N] [-tone Hz]\n"
+           "       game -headless -adpcm-encode <in.wav> -out <out.adp> [-rate Hz]\n"
+           "       game -headless -bench-ring\n"
+           "       game -headless -bench-entities\n"
+           "       game -headless -bench-collide\n"
+           "       game -headless -bench-path\n"
+           "       game -headless -bench-worldgen\n"
+           "       game -headless -bench-random\n"
+           "       game -headless -bench-particles\n");
+    return -1;
+}
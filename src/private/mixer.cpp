@@ -0,0 +1,578 @@
+#include "mixer.h"
+#include "simd.h"
+#include <math.h>
+#include <string.h>
+
+void MixerInitialize(Mixer& mixer, MemoryArena& arena, int samplesPerSecond, ResampleQuality quality,
+                     uint32_t voiceCapacity)
+{
+    mixer.samplesPerSecond = samplesPerSecond;
+    for (MixerBusState& bus : mixer.buses)
+    {
+        bus.left = PushArray(arena, MIXER_BLOCK_FRAMES, float);
+        bus.right = PushArray(arena, MIXER_BLOCK_FRAMES, float);
+        bus.volume = 1.0f;
+    }
+
+    // Several voices summing past full scale get squeezed here instead of wrapping in the int16 cast
+    mixer.masterLimiter = EffectChainAddLimiter(MixerGetEffects(mixer, MixerBus::Master), arena);
+    LimiterSet(*mixer.masterLimiter, (float)samplesPerSecond, -0.3f, 0.25f);
+
+    mixer.voiceLeft = PushArray(arena, MIXER_BLOCK_FRAMES, float);
+    mixer.voiceRight = PushArray(arena, MIXER_BLOCK_FRAMES, float);
+
+    DitherInitialize(mixer.dither, 0x1234567u);
+
+    mixer.blockPosition = MIXER_BLOCK_FRAMES;
+    float cutoff = 0.45f;
+    for (ResamplerKernel& kernel : mixer.kernels)
+    {
+        ResamplerBuildKernel(kernel, arena, quality, cutoff);
+        cutoff *= 0.5f;
+    }
+
+    // Every voice the game will ever get is allocated here, buffers included
+    ASSERT(voiceCapacity > 0);
+    mixer.voiceCapacity = voiceCapacity;
+    mixer.voices = PushArray(arena, voiceCapacity, MixerVoice);
+    mixer.activeVoices = PushArray(arena, voiceCapacity, uint32_t);
+    mixer.activeVoiceCount = 0;
+    for (uint32_t i = 0; i < voiceCapacity; ++i)
+    {
+        MixerVoice& voice = mixer.voices[i];
+        voice = {};
+        voice.generation = 1;
+        voice.nextFree = i + 1;
+        ResamplerInitialize(voice.resampler, arena);
+        AdpcmDecoderInitialize(voice.decoder, arena);
+    }
+    mixer.firstFreeVoice = 0;
+    mixer.isInitialized = true;
+}
+
+#pragma region Voice pool
+
+internal auto KernelForStep(Mixer& mixer, double step) -> const ResamplerKernel*
+{
+    int index = 0;
+    double maxStep = 1.0;
+    while (step > maxStep && index + 1 < MIXER_KERNEL_COUNT)
+    {
+        maxStep *= 2.0;
+        ++index;
+    }
+    return &mixer.kernels[index];
+}
+
+internal void ResetVoiceResampler(Mixer& mixer, MixerVoice& voice, int sourceSamplesPerSecond, float pitch)
+{
+    double step = ((double)sourceSamplesPerSecond / (double)mixer.samplesPerSecond) * pitch;
+    ResamplerReset(voice.resampler, KernelForStep(mixer, step), sourceSamplesPerSecond, mixer.samplesPerSecond, pitch);
+}
+
+internal void FreeVoice(Mixer& mixer, uint32_t index)
+{
+    MixerVoice& voice = mixer.voices[index];
+    voice.source = VoiceSource::None;
+    // Outstanding handles stop resolving, skip 0 so it stays the never valid generation
+    if (++voice.generation == 0)
+    {
+        voice.generation = 1;
+    }
+
+    uint32_t last = mixer.activeVoices[--mixer.activeVoiceCount];
+    mixer.activeVoices[voice.activeSlot] = last;
+    mixer.voices[last].activeSlot = voice.activeSlot;
+
+    voice.nextFree = mixer.firstFreeVoice;
+    mixer.firstFreeVoice = index;
+}
+
+// Lowest priority loses, then virtual before audible, then the oldest
+internal auto FindVoiceToSteal(Mixer& mixer, uint8_t priority) -> uint32_t
+{
+    uint32_t victim = mixer.voiceCapacity;
+    for (uint32_t slot = 0; slot < mixer.activeVoiceCount; ++slot)
+    {
+        uint32_t index = mixer.activeVoices[slot];
+        MixerVoice& voice = mixer.voices[index];
+        if (voice.priority > priority)
+        {
+            continue;
+        }
+        if (victim == mixer.voiceCapacity)
+        {
+            victim = index;
+            continue;
+        }
+
+        MixerVoice& best = mixer.voices[victim];
+        if (voice.priority != best.priority)
+        {
+            victim = voice.priority < best.priority ? index : victim;
+        }
+        else if (voice.isVirtual != best.isVirtual)
+        {
+            victim = voice.isVirtual ? index : victim;
+        }
+        else if (voice.playSerial < best.playSerial)
+        {
+            victim = index;
+        }
+    }
+    return victim;
+}
+
+internal auto AllocateVoice(Mixer& mixer, uint8_t priority, VoiceHandle& handle) -> MixerVoice*
+{
+    handle = {};
+    if (mixer.firstFreeVoice >= mixer.voiceCapacity)
+    {
+        uint32_t victim = FindVoiceToSteal(mixer, priority);
+        if (victim == mixer.voiceCapacity)
+        {
+            return nullptr;
+        }
+        FreeVoice(mixer, victim);
+    }
+
+    uint32_t index = mixer.firstFreeVoice;
+    MixerVoice& voice = mixer.voices[index];
+    mixer.firstFreeVoice = voice.nextFree;
+
+    // The resampler and decoder buffers belong to the slot, keep them
+    uint32_t generation = voice.generation;
+    ResamplerState resampler = voice.resampler;
+    AdpcmDecoder decoder = voice.decoder;
+    voice = {};
+    voice.generation = generation;
+    voice.resampler = resampler;
+    voice.decoder = decoder;
+    voice.decoder.frameCount = 0;
+    voice.priority = priority;
+    voice.playSerial = mixer.playCount++;
+    voice.pitch = 1.0f;
+    voice.minDistance = 1.0f;
+    voice.maxDistance = 40.0f;
+
+    voice.activeSlot = mixer.activeVoiceCount;
+    mixer.activeVoices[mixer.activeVoiceCount++] = index;
+
+    handle.index = index;
+    handle.generation = generation;
+    return &voice;
+}
+
+#pragma endregion
+
+auto MixerPlaySine(Mixer& mixer, float toneHz, float volume, MixerBus bus, uint8_t priority) -> VoiceHandle
+{
+    VoiceHandle handle;
+    MixerVoice* voice = AllocateVoice(mixer, priority, handle);
+    if (voice)
+    {
+        voice->source = VoiceSource::Sine;
+        voice->bus = bus;
+        voice->toneHz = toneHz;
+        voice->volume = volume;
+    }
+    return handle;
+}
+
+auto MixerPlayStream(Mixer& mixer, WavStream* stream, float volume, bool loop, MixerBus bus, uint8_t priority) -> VoiceHandle
+{
+    VoiceHandle handle;
+    MixerVoice* voice = AllocateVoice(mixer, priority, handle);
+    if (voice)
+    {
+        voice->bus = bus;
+        ResetVoiceResampler(mixer, *voice, stream->samplesPerSecond, 1.0f);
+        voice->source = VoiceSource::Stream;
+        voice->resampling = stream->samplesPerSecond != mixer.samplesPerSecond;
+        voice->stream = stream;
+        voice->streamPosition = 0;
+        voice->sourceSamplesPerSecond = stream->samplesPerSecond;
+        voice->volume = volume;
+        voice->loop = loop;
+    }
+    return handle;
+}
+
+auto MixerPlaySound(Mixer& mixer, AdpcmSound* sound, float volume, bool loop, MixerBus bus, uint8_t priority) -> VoiceHandle
+{
+    VoiceHandle handle;
+    MixerVoice* voice = AllocateVoice(mixer, priority, handle);
+    if (voice)
+    {
+        voice->bus = bus;
+        ResetVoiceResampler(mixer, *voice, sound->samplesPerSecond, 1.0f);
+        voice->source = VoiceSource::Adpcm;
+        voice->resampling = sound->samplesPerSecond != mixer.samplesPerSecond;
+        voice->sound = sound;
+        voice->sourceSamplesPerSecond = sound->samplesPerSecond;
+        voice->volume = volume;
+        voice->loop = loop;
+    }
+    return handle;
+}
+
+void MixerStop(Mixer& mixer, VoiceHandle handle)
+{
+    if (MixerGetVoice(mixer, handle))
+    {
+        FreeVoice(mixer, handle.index);
+    }
+}
+
+void MixerSetVolume(Mixer& mixer, VoiceHandle handle, float volume)
+{
+    if (MixerVoice* voice = MixerGetVoice(mixer, handle))
+    {
+        voice->volume = volume;
+    }
+}
+
+void MixerSetTone(Mixer& mixer, VoiceHandle handle, float toneHz)
+{
+    MixerVoice* voice = MixerGetVoice(mixer, handle);
+    if (voice && voice->source == VoiceSource::Sine)
+    {
+        voice->toneHz = toneHz;
+    }
+}
+
+void MixerSetPitch(Mixer& mixer, VoiceHandle handle, float pitch)
+{
+    MixerVoice* voice = MixerGetVoice(mixer, handle);
+    if (voice && (voice->source == VoiceSource::Stream || voice->source == VoiceSource::Adpcm))
+    {
+        voice->pitch = pitch;
+        voice->resampling = voice->resampling || pitch != 1.0f;
+        ResamplerSetRatio(voice->resampler, voice->sourceSamplesPerSecond, mixer.samplesPerSecond, pitch);
+        // Every kernel has the same taps, so the buffered input stays valid across the switch
+        voice->resampler.kernel = KernelForStep(mixer, voice->resampler.step);
+    }
+}
+
+void MixerSetPosition(Mixer& mixer, VoiceHandle handle, float x, float y)
+{
+    if (MixerVoice* voice = MixerGetVoice(mixer, handle))
+    {
+        voice->isPositional = true;
+        voice->x = x;
+        voice->y = y;
+    }
+}
+
+void MixerSetDistance(Mixer& mixer, VoiceHandle handle, float minDistance, float maxDistance)
+{
+    ASSERT(minDistance > 0.0f && maxDistance > minDistance);
+    if (MixerVoice* voice = MixerGetVoice(mixer, handle))
+    {
+        voice->minDistance = minDistance;
+        voice->maxDistance = maxDistance;
+    }
+}
+
+internal void MixSine(Mixer& mixer, MixerVoice& voice, float* left, float* right, int frameCount, float volume)
+{
+    float phaseStep = 2.0f * (float)M_PI * voice.toneHz / (float)mixer.samplesPerSecond;
+    for (int i = 0; i < frameCount; ++i)
+    {
+        float sample = sinf(voice.phase) * volume;
+        left[i] += sample;
+        right[i] += sample;
+
+        voice.phase += phaseStep;
+    }
+    // Keep the phase small so float precision doesn't drift the pitch over time
+    voice.phase = fmodf(voice.phase, 2.0f * (float)M_PI);
+}
+
+// Reads from the voice's stream or sound, wrapping around for looping voices
+internal int PullSampled(MixerVoice& voice, float* left, float* right, int frameCount, float volume)
+{
+    int framesMixed = 0;
+    while (framesMixed < frameCount)
+    {
+        bool empty;
+        if (voice.source == VoiceSource::Stream)
+        {
+            framesMixed += WavStreamMix(*voice.stream, voice.streamPosition, left + framesMixed, right + framesMixed,
+                                        frameCount - framesMixed, volume);
+            empty = voice.stream->frameCount == 0;
+        }
+        else
+        {
+            framesMixed += AdpcmMix(*voice.sound, voice.decoder, voice.framePosition, left + framesMixed,
+                                    right + framesMixed, frameCount - framesMixed, volume);
+            empty = voice.sound->frameCount == 0;
+        }
+
+        if (framesMixed < frameCount)
+        {
+            if (!voice.loop || empty)
+            {
+                break;
+            }
+            if (voice.source == VoiceSource::Stream)
+            {
+                voice.streamPosition = 0;
+            }
+            else
+            {
+                voice.framePosition = 0;
+            }
+        }
+    }
+    return framesMixed;
+}
+
+internal int PullSampledForResampler(void* user, float* left, float* right, int frameCount)
+{
+    return PullSampled(*(MixerVoice*)user, left, right, frameCount, 1.0f);
+}
+
+internal void MixSampled(MixerVoice& voice, float* left, float* right, int frameCount, float volume)
+{
+    int framesMixed;
+    if (!voice.resampling)
+    {
+        framesMixed = PullSampled(voice, left, right, frameCount, volume);
+    }
+    else
+    {
+        framesMixed = ResamplerMix(voice.resampler, PullSampledForResampler, &voice,
+                                   left, right, frameCount, volume);
+    }
+
+    if (framesMixed < frameCount)
+    {
+        voice.source = VoiceSource::None;
+    }
+}
+
+#pragma region Spatial
+
+// Pan gains with volume and distance rolloff folded in
+internal void ComputeSpatialGains(Mixer& mixer, MixerVoice& voice, float& gainLeft, float& gainRight)
+{
+    float dx = voice.x - mixer.listenerX;
+    float dy = voice.y - mixer.listenerY;
+    float distance = sqrtf(dx * dx + dy * dy);
+
+    float attenuation = 0.0f;
+    if (distance <= voice.minDistance)
+    {
+        attenuation = 1.0f;
+    }
+    else if (distance < voice.maxDistance)
+    {
+        // Inverse distance, faded out over the range so crossing maxDistance doesn't pop
+        float fade = 1.0f - (distance - voice.minDistance) / (voice.maxDistance - voice.minDistance);
+        attenuation = (voice.minDistance / distance) * fade;
+    }
+
+    float pan = dx / (distance > voice.minDistance ? distance : voice.minDistance);
+    float angle = (pan + 1.0f) * 0.25f * (float)M_PI;
+    gainLeft = cosf(angle) * attenuation * voice.volume;
+    gainRight = sinf(angle) * attenuation * voice.volume;
+}
+
+// Advances an inaudible voice as if it had been mixed
+internal void SkipVoice(Mixer& mixer, MixerVoice& voice, int frameCount)
+{
+    if (voice.source == VoiceSource::Sine)
+    {
+        float phaseStep = 2.0f * (float)M_PI * voice.toneHz / (float)mixer.samplesPerSecond;
+        voice.phase = fmodf(voice.phase + phaseStep * frameCount, 2.0f * (float)M_PI);
+        return;
+    }
+
+    uint64_t sourceFrames = frameCount;
+    if (voice.resampling)
+    {
+        voice.skipRemainder += frameCount * voice.resampler.step;
+        sourceFrames = (uint64_t)voice.skipRemainder;
+        voice.skipRemainder -= (double)sourceFrames;
+    }
+
+    uint64_t length = voice.source == VoiceSource::Stream ? voice.stream->frameCount : voice.sound->frameCount;
+    uint64_t position = voice.source == VoiceSource::Stream ? voice.streamPosition : voice.framePosition;
+    position += sourceFrames;
+    if (position >= length)
+    {
+        if (!voice.loop || length == 0)
+        {
+            voice.source = VoiceSource::None;
+            return;
+        }
+        position %= length;
+    }
+
+    if (voice.source == VoiceSource::Stream)
+    {
+        voice.streamPosition = position;
+    }
+    else
+    {
+        voice.framePosition = (uint32_t)position;
+    }
+}
+
+// Folds the voice to mono and pans it into the bus, ramping from the last gains
+internal void AddPanned(const float* inLeft, const float* inRight, float* outLeft, float* outRight, int frameCount,
+                        float fromLeft, float fromRight, float toLeft, float toRight)
+{
+    float stepLeft = (toLeft - fromLeft) / (float)frameCount;
+    float stepRight = (toRight - fromRight) / (float)frameCount;
+    for (int i = 0; i < frameCount; ++i)
+    {
+        float mono = 0.5f * (inLeft[i] + inRight[i]);
+        fromLeft += stepLeft;
+        fromRight += stepRight;
+        outLeft[i] += mono * fromLeft;
+        outRight[i] += mono * fromRight;
+    }
+}
+
+#pragma endregion
+
+internal void MixVoice(Mixer& mixer, MixerVoice& voice, float* left, float* right, int frameCount, float volume)
+{
+    switch (voice.source)
+    {
+        case VoiceSource::Sine:   MixSine(mixer, voice, left, right, frameCount, volume); break;
+        case VoiceSource::Stream:
+        case VoiceSource::Adpcm:  MixSampled(voice, left, right, frameCount, volume); break;
+        case VoiceSource::None:   break;
+    }
+}
+
+internal void RenderSpan(Mixer& mixer, MixerVoice& voice, int offset, int frameCount)
+{
+    MixerBusState& bus = mixer.buses[(int)voice.bus];
+    if (!voice.isPositional)
+    {
+        MixVoice(mixer, voice, bus.left + offset, bus.right + offset, frameCount, voice.volume);
+        return;
+    }
+
+    float gainLeft, gainRight;
+    ComputeSpatialGains(mixer, voice, gainLeft, gainRight);
+    if (gainLeft < MIXER_VIRTUAL_GAIN && gainRight < MIXER_VIRTUAL_GAIN)
+    {
+        SkipVoice(mixer, voice, frameCount);
+        voice.isVirtual = true;
+        return;
+    }
+
+    if (voice.isVirtual)
+    {
+        // Buffered resampler input is stale after skipping, and fade in from silence
+        if (voice.resampling)
+        {
+            ResetVoiceResampler(mixer, voice, voice.sourceSamplesPerSecond, voice.pitch);
+        }
+        voice.gainLeft = 0.0f;
+        voice.gainRight = 0.0f;
+        voice.isVirtual = false;
+    }
+
+    memset(mixer.voiceLeft, 0, frameCount * sizeof(float));
+    memset(mixer.voiceRight, 0, frameCount * sizeof(float));
+    MixVoice(mixer, voice, mixer.voiceLeft, mixer.voiceRight, frameCount, 1.0f);
+    AddPanned(mixer.voiceLeft, mixer.voiceRight, bus.left + offset, bus.right + offset, frameCount,
+              voice.gainLeft, voice.gainRight, gainLeft, gainRight);
+    voice.gainLeft = gainLeft;
+    voice.gainRight = gainRight;
+}
+
+internal void RenderBlock(Mixer& mixer)
+{
+    for (MixerBusState& bus : mixer.buses)
+    {
+        memset(bus.left, 0, MIXER_BLOCK_FRAMES * sizeof(float));
+        memset(bus.right, 0, MIXER_BLOCK_FRAMES * sizeof(float));
+    }
+
+    // Voices render in spans between scheduled events, effects still see the whole block
+    int framesDone = 0;
+    while (framesDone < MIXER_BLOCK_FRAMES)
+    {
+        int frameCount = MIXER_BLOCK_FRAMES - framesDone;
+        if (mixer.scheduler)
+        {
+            frameCount = mixer.scheduler(mixer.schedulerUser, mixer, mixer.sampleClock + framesDone, frameCount);
+            ASSERT(frameCount > 0 && frameCount <= MIXER_BLOCK_FRAMES - framesDone);
+        }
+
+        uint32_t slot = 0;
+        while (slot < mixer.activeVoiceCount)
+        {
+            uint32_t index = mixer.activeVoices[slot];
+            RenderSpan(mixer, mixer.voices[index], framesDone, frameCount);
+            if (mixer.voices[index].source == VoiceSource::None)
+            {
+                // Ran out, the last active voice moves into this slot and still needs its span
+                FreeVoice(mixer, index);
+            }
+            else
+            {
+                ++slot;
+            }
+        }
+        framesDone += frameCount;
+    }
+    mixer.sampleClock += MIXER_BLOCK_FRAMES;
+
+    mixer.virtualVoiceCount = 0;
+    for (uint32_t slot = 0; slot < mixer.activeVoiceCount; ++slot)
+    {
+        mixer.virtualVoiceCount += mixer.voices[mixer.activeVoices[slot]].isVirtual;
+    }
+
+    MixerBusState& master = mixer.buses[(int)MixerBus::Master];
+    for (int i = (int)MixerBus::Master + 1; i < (int)MixerBus::Count; ++i)
+    {
+        MixerBusState& bus = mixer.buses[i];
+        EffectChainProcess(bus.effects, bus.left, bus.right, MIXER_BLOCK_FRAMES);
+        MixAddScaled(master.left, master.right, bus.left, bus.right, bus.volume, MIXER_BLOCK_FRAMES);
+    }
+    EffectChainProcess(master.effects, master.left, master.right, MIXER_BLOCK_FRAMES);
+}
+
+void MixerOutput(Mixer& mixer, SoundOutputBuffer& soundBuffer)
+{
+    // Flush denormals to zero while we process, decaying filter and reverb tails otherwise crawl
+    unsigned int savedCsr = _mm_getcsr();
+    _mm_setcsr(savedCsr | 0x8040);
+
+    MixerBusState& master = mixer.buses[(int)MixerBus::Master];
+    for (SoundRegion& region : soundBuffer.regions)
+    {
+        int16_t* out = region.samples;
+        int framesLeft = region.sampleCount;
+        while (framesLeft > 0)
+        {
+            if (mixer.blockPosition == MIXER_BLOCK_FRAMES)
+            {
+                RenderBlock(mixer);
+                mixer.blockPosition = 0;
+            }
+
+            int frameCount = MIXER_BLOCK_FRAMES - mixer.blockPosition;
+            if (frameCount > framesLeft)
+            {
+                frameCount = framesLeft;
+            }
+            ConvertToInt16Interleaved(master.left + mixer.blockPosition, master.right + mixer.blockPosition,
+                                      out, frameCount, master.volume, mixer.ditherEnabled ? &mixer.dither : nullptr);
+            mixer.blockPosition += frameCount;
+            out += frameCount * 2;
+            framesLeft -= frameCount;
+        }
+    }
+
+    _mm_setcsr(savedCsr);
+}
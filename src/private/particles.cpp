@@ -0,0 +1,422 @@
+#include "particles.h"
+#include "lane.h"
+
+void InitializeParticleSystem(ParticleSystem& system, MemoryArena& arena, uint32_t capacity, WorldPosition origin,
+                              float drag, uint64_t seed)
+{
+    capacity = (capacity + PARTICLE_BATCH_SIZE - 1) / PARTICLE_BATCH_SIZE * PARTICLE_BATCH_SIZE;
+    system.origin = origin;
+    system.drag = drag;
+    system.capacity = capacity;
+    system.count = 0;
+    system.nextSpawn = 0;
+    system.random = RandomSeed8(seed, RandomStream_Particles, 0);
+
+    // The AVX2 update uses aligned 32 byte loads and stores on every column
+    system.positionX = PushArrayAligned(arena, capacity, float, 32);
+    system.positionY = PushArrayAligned(arena, capacity, float, 32);
+    system.velocityX = PushArrayAligned(arena, capacity, float, 32);
+    system.velocityY = PushArrayAligned(arena, capacity, float, 32);
+    system.life = PushArrayAligned(arena, capacity, float, 32);
+    system.lifeRate = PushArrayAligned(arena, capacity, float, 32);
+    system.color = PushArrayAligned(arena, capacity, uint32_t, 32);
+    ASSERT((((size_t)system.positionX | (size_t)system.positionY | (size_t)system.velocityX |
+             (size_t)system.velocityY | (size_t)system.life | (size_t)system.lifeRate | (size_t)system.color) & 31) == 0);
+    for (uint32_t i = 0; i < capacity; ++i)
+    {
+        system.life[i] = 0.0f;
+    }
+
+    system.commands = PushArray(arena, capacity, ParticleRenderCommand);
+    system.unsortedCommands = PushArray(arena, capacity, ParticleRenderCommand);
+    system.bandEnds = PushArray(arena, capacity / PARTICLE_BATCH_SIZE * PARTICLE_RENDER_BANDS, uint32_t);
+    for (uint32_t i = 0; i < capacity / PARTICLE_BATCH_SIZE * PARTICLE_RENDER_BANDS; ++i)
+    {
+        system.bandEnds[i] = 0;
+    }
+    system.bandShift = 0;
+    system.bandCount = 0;
+    system.liveCount = 0;
+}
+
+// 0 to 1 per channel into 0x00RRGGBB
+internal uint32_t PackColor(v3 color)
+{
+    uint32_t red = (uint32_t)(255.0f * Clamp01(color.x) + 0.5f);
+    uint32_t green = (uint32_t)(255.0f * Clamp01(color.y) + 0.5f);
+    uint32_t blue = (uint32_t)(255.0f * Clamp01(color.z) + 0.5f);
+    return (red << 16) | (green << 8) | blue;
+}
+
+void SpawnParticles(ParticleSystem& system, const ParticleEmitter& emitter, uint32_t count)
+{
+    count = (count + PARTICLE_LANES - 1) & ~(uint32_t)(PARTICLE_LANES - 1);
+    count = count < system.capacity ? count : system.capacity;
+
+    lane_f32 positionSpread = LaneF32(emitter.positionSpread);
+    lane_f32 speedSpread = LaneF32(emitter.speedSpread);
+    lane_f32 lifetimeSpread = LaneF32(emitter.lifetimeSpread);
+    lane_f32 minLifetime = LaneF32(1.0f / 1000.0f);
+    lane_f32 minLength = LaneF32(1.0f / 1024.0f);
+    lane_u32 color = LaneU32(PackColor(emitter.color));
+    for (uint32_t spawned = 0; spawned < count; spawned += PARTICLE_LANES)
+    {
+        uint32_t base = system.nextSpawn;
+        for (uint32_t half = 0; half < 2; ++half)
+        {
+            uint32_t i = base + half * LANE_WIDTH;
+            lane_f32 positionX = LaneF32(emitter.position.x) + positionSpread * RandomBilateral4(system.random, half);
+            lane_f32 positionY = LaneF32(emitter.position.y) + positionSpread * RandomBilateral4(system.random, half);
+            // Any direction, at up to speedSpread on top of the emitter's own velocity
+            lane_f32 directionX = RandomBilateral4(system.random, half);
+            lane_f32 directionY = RandomBilateral4(system.random, half);
+            lane_f32 length = SquareRoot(directionX * directionX + directionY * directionY);
+            lane_f32 speed = speedSpread * RandomUnilateral4(system.random, half) / Maximum(length, minLength);
+            lane_f32 velocityX = LaneF32(emitter.velocity.x) + speed * directionX;
+            lane_f32 velocityY = LaneF32(emitter.velocity.y) + speed * directionY;
+            lane_f32 lifetime = LaneF32(emitter.lifetime) + lifetimeSpread * RandomBilateral4(system.random, half);
+            Store(system.positionX + i, positionX);
+            Store(system.positionY + i, positionY);
+            Store(system.velocityX + i, velocityX);
+            Store(system.velocityY + i, velocityY);
+            Store(system.life + i, LaneF32(1.0f));
+            Store(system.lifeRate + i, LaneF32(1.0f) / Maximum(lifetime, minLifetime));
+            Store(system.color + i, color);
+        }
+
+        system.count = base + PARTICLE_LANES > system.count ? base + PARTICLE_LANES : system.count;
+        system.nextSpawn = (base + PARTICLE_LANES) % system.capacity;
+    }
+}
+
+#pragma region Update
+
+// What every batch of one update shares, the camera already folded into a scale and bias per axis
+struct ParticleUpdate
+{
+    ParticleSystem* system;
+    float seconds;
+    float dragScale;        // velocity kept over this step
+    float screenScaleX;     // screen = bias + scale * position, y flipped
+    float screenScaleY;
+    float screenBiasX;
+    float screenBiasY;
+    float maxScreenX;       // quads starting below these are fully on screen
+    float maxScreenY;
+    bool useAvx2;
+
+    uint32_t batchCount;
+    LONG volatile nextBatch;
+    LONG volatile liveCount;
+};
+
+// Counting sort of one batch's commands by band, so each render job only reads its own bands.
+// The update counted the commands per band as it wrote them.
+internal void SortCommandsIntoBands(ParticleSystem& system, uint32_t batchIndex, uint32_t commandCount,
+                                    const uint32_t* counts)
+{
+    const ParticleRenderCommand* unsorted = system.unsortedCommands + batchIndex * PARTICLE_BATCH_SIZE;
+    ParticleRenderCommand* commands = system.commands + batchIndex * PARTICLE_BATCH_SIZE;
+    uint32_t* bandEnds = system.bandEnds + batchIndex * PARTICLE_RENDER_BANDS;
+    uint32_t shift = 16 + system.bandShift;
+
+    uint32_t offsets[PARTICLE_RENDER_BANDS];
+    uint32_t end = 0;
+    for (uint32_t band = 0; band < PARTICLE_RENDER_BANDS; ++band)
+    {
+        offsets[band] = end;
+        end += counts[band];
+        bandEnds[band] = end;
+    }
+
+    for (uint32_t i = 0; i < commandCount; ++i)
+    {
+        ParticleRenderCommand command = unsorted[i];
+        commands[offsets[command.pixel >> shift]++] = command;
+    }
+}
+
+// Returns how many particles in the batch are still alive
+SIMD_TARGET_AVX2 internal auto UpdateParticleBatchAVX2(ParticleUpdate& update, uint32_t batchIndex) -> uint32_t
+{
+    ParticleSystem& system = *update.system;
+    uint32_t first = batchIndex * PARTICLE_BATCH_SIZE;
+    uint32_t end = first + PARTICLE_BATCH_SIZE < system.count ? first + PARTICLE_BATCH_SIZE : system.count;
+    ParticleRenderCommand* commands = system.unsortedCommands + first;
+    uint32_t commandCount = 0;
+    uint32_t bandCounts[PARTICLE_RENDER_BANDS] = {};
+    uint32_t bandShift = 16 + system.bandShift;
+    uint32_t liveCount = 0;
+
+    alignas(32) uint32_t pixel[LANE8_WIDTH];
+    alignas(32) uint32_t color[LANE8_WIDTH];
+    lane8_f32 zero = Lane8F32(0.0f);
+    lane8_f32 dt = Lane8F32(update.seconds);
+    lane8_f32 dragScale = Lane8F32(update.dragScale);
+    for (uint32_t i = first; i < end; i += LANE8_WIDTH)
+    {
+        lane8_f32 life = Load8F32(system.life + i);
+        lane8_u32 alive = life > zero;
+        if (!AnyTrue(alive))
+        {
+            continue;
+        }
+
+        // Dead lanes step by zero so they stay where they died
+        lane8_f32 step = alive & dt;
+        lane8_f32 velocityX = Load8F32(system.velocityX + i);
+        lane8_f32 velocityY = Load8F32(system.velocityY + i);
+        ConditionalAssign(velocityX, alive, velocityX * dragScale);
+        ConditionalAssign(velocityY, alive, velocityY * dragScale);
+        lane8_f32 positionX = Load8F32(system.positionX + i) + velocityX * step;
+        lane8_f32 positionY = Load8F32(system.positionY + i) + velocityY * step;
+        life -= Load8F32(system.lifeRate + i) * step;
+        Store(system.velocityX + i, velocityX);
+        Store(system.velocityY + i, velocityY);
+        Store(system.positionX + i, positionX);
+        Store(system.positionY + i, positionY);
+        Store(system.life + i, life);
+
+        alive = life > zero;
+        liveCount += (uint32_t)__builtin_popcount(LaneMask(alive));
+        lane8_f32 screenX = Lane8F32(update.screenBiasX) + Lane8F32(update.screenScaleX) * positionX;
+        lane8_f32 screenY = Lane8F32(update.screenBiasY) + Lane8F32(update.screenScaleY) * positionY;
+        lane8_u32 visible = alive & (screenX >= zero) & (screenX < Lane8F32(update.maxScreenX)) &
+                            (screenY >= zero) & (screenY < Lane8F32(update.maxScreenY));
+        uint32_t mask = LaneMask(visible);
+        if (!mask)
+        {
+            continue;
+        }
+
+        // Brightness follows the life left
+        lane8_u32 packed = Load8U32(system.color + i);
+        lane8_u32 channel = Lane8U32(0xFF);
+        lane8_u32 red = FloorToI32(ConvertToF32((packed >> 16) & channel) * life);
+        lane8_u32 green = FloorToI32(ConvertToF32((packed >> 8) & channel) * life);
+        lane8_u32 blue = FloorToI32(ConvertToF32(packed & channel) * life);
+        Store(color, (red << 16) | (green << 8) | blue);
+        Store(pixel, (FloorToI32(screenY) << 16) | FloorToI32(screenX));
+        for (uint32_t lane = 0; lane < LANE8_WIDTH; ++lane)
+        {
+            uint32_t isVisible = (mask >> lane) & 1;
+            commands[commandCount] = {pixel[lane], color[lane]};
+            commandCount += isVisible;
+            // Off screen lanes hold any pixel, keep their band in range even though they add nothing
+            bandCounts[(pixel[lane] >> bandShift) & (PARTICLE_RENDER_BANDS - 1)] += isVisible;
+        }
+    }
+
+    SortCommandsIntoBands(system, batchIndex, commandCount, bandCounts);
+    return liveCount;
+}
+
+// The same steps as the AVX2 version, four lanes at a time
+internal auto UpdateParticleBatchSSE(ParticleUpdate& update, uint32_t batchIndex) -> uint32_t
+{
+    ParticleSystem& system = *update.system;
+    uint32_t first = batchIndex * PARTICLE_BATCH_SIZE;
+    uint32_t end = first + PARTICLE_BATCH_SIZE < system.count ? first + PARTICLE_BATCH_SIZE : system.count;
+    ParticleRenderCommand* commands = system.unsortedCommands + first;
+    uint32_t commandCount = 0;
+    uint32_t bandCounts[PARTICLE_RENDER_BANDS] = {};
+    uint32_t bandShift = 16 + system.bandShift;
+    uint32_t liveCount = 0;
+
+    alignas(16) uint32_t pixel[LANE_WIDTH];
+    alignas(16) uint32_t color[LANE_WIDTH];
+    lane_f32 zero = LaneF32(0.0f);
+    lane_f32 dt = LaneF32(update.seconds);
+    lane_f32 dragScale = LaneF32(update.dragScale);
+    for (uint32_t i = first; i < end; i += LANE_WIDTH)
+    {
+        lane_f32 life = LoadF32(system.life + i);
+        lane_u32 alive = life > zero;
+        if (!AnyTrue(alive))
+        {
+            continue;
+        }
+
+        lane_f32 step = alive & dt;
+        lane_f32 velocityX = LoadF32(system.velocityX + i);
+        lane_f32 velocityY = LoadF32(system.velocityY + i);
+        ConditionalAssign(velocityX, alive, velocityX * dragScale);
+        ConditionalAssign(velocityY, alive, velocityY * dragScale);
+        lane_f32 positionX = LoadF32(system.positionX + i) + velocityX * step;
+        lane_f32 positionY = LoadF32(system.positionY + i) + velocityY * step;
+        life -= LoadF32(system.lifeRate + i) * step;
+        Store(system.velocityX + i, velocityX);
+        Store(system.velocityY + i, velocityY);
+        Store(system.positionX + i, positionX);
+        Store(system.positionY + i, positionY);
+        Store(system.life + i, life);
+
+        alive = life > zero;
+        liveCount += (uint32_t)__builtin_popcount(LaneMask(alive));
+        lane_f32 screenX = LaneF32(update.screenBiasX) + LaneF32(update.screenScaleX) * positionX;
+        lane_f32 screenY = LaneF32(update.screenBiasY) + LaneF32(update.screenScaleY) * positionY;
+        lane_u32 visible = alive & (screenX >= zero) & (screenX < LaneF32(update.maxScreenX)) &
+                           (screenY >= zero) & (screenY < LaneF32(update.maxScreenY));
+        uint32_t mask = LaneMask(visible);
+        if (!mask)
+        {
+            continue;
+        }
+
+        lane_u32 packed = LoadU32(system.color + i);
+        lane_u32 channel = LaneU32(0xFF);
+        lane_u32 red = FloorToI32(ConvertToF32((packed >> 16) & channel) * life);
+        lane_u32 green = FloorToI32(ConvertToF32((packed >> 8) & channel) * life);
+        lane_u32 blue = FloorToI32(ConvertToF32(packed & channel) * life);
+        Store(color, (red << 16) | (green << 8) | blue);
+        Store(pixel, (FloorToI32(screenY) << 16) | FloorToI32(screenX));
+        for (uint32_t lane = 0; lane < LANE_WIDTH; ++lane)
+        {
+            uint32_t isVisible = (mask >> lane) & 1;
+            commands[commandCount] = {pixel[lane], color[lane]};
+            commandCount += isVisible;
+            // Off screen lanes hold any pixel, keep their band in range even though they add nothing
+            bandCounts[(pixel[lane] >> bandShift) & (PARTICLE_RENDER_BANDS - 1)] += isVisible;
+        }
+    }
+
+    SortCommandsIntoBands(system, batchIndex, commandCount, bandCounts);
+    return liveCount;
+}
+
+internal void UpdateParticleJob(void* data)
+{
+    ParticleUpdate* update = (ParticleUpdate*)data;
+    uint32_t liveCount = 0;
+    for (;;)
+    {
+        uint32_t batchIndex = (uint32_t)InterlockedIncrement(&update->nextBatch) - 1;
+        if (batchIndex >= update->batchCount)
+        {
+            break;
+        }
+        liveCount += update->useAvx2 ? UpdateParticleBatchAVX2(*update, batchIndex)
+                                     : UpdateParticleBatchSSE(*update, batchIndex);
+    }
+    InterlockedExchangeAdd(&update->liveCount, (LONG)liveCount);
+}
+
+void UpdateParticles(ParticleSystem& system, float seconds, const ParticleCamera& camera,
+                     PlatformWorkQueue* workQueue)
+{
+    ParticleUpdate update = {};
+    update.system = &system;
+    update.seconds = seconds;
+    update.dragScale = 1.0f - system.drag * seconds;
+    update.dragScale = update.dragScale > 0.0f ? update.dragScale : 0.0f;
+    update.screenScaleX = camera.metersToPixels;
+    update.screenScaleY = -camera.metersToPixels;
+    update.screenBiasX = 0.5f * (float)camera.width - camera.offset.x * camera.metersToPixels;
+    update.screenBiasY = 0.5f * (float)camera.height + camera.offset.y * camera.metersToPixels;
+    update.maxScreenX = (float)(camera.width - PARTICLE_SIDE_IN_PIXELS + 1);
+    update.maxScreenY = (float)(camera.height - PARTICLE_SIDE_IN_PIXELS + 1);
+    update.useAvx2 = CpuHasAvx2();
+    // Smallest power of two run of rows that covers the camera in PARTICLE_RENDER_BANDS bands
+    uint32_t lastRow = camera.height > 0 ? (uint32_t)camera.height - 1 : 0;
+    system.bandShift = 0;
+    while ((lastRow >> system.bandShift) >= PARTICLE_RENDER_BANDS)
+    {
+        ++system.bandShift;
+    }
+    system.bandCount = (lastRow >> system.bandShift) + 1;
+    update.batchCount = (system.count + PARTICLE_BATCH_SIZE - 1) / PARTICLE_BATCH_SIZE;
+    update.nextBatch = 0;
+    update.liveCount = 0;
+
+    // Every job claims batches until none are left, so the jobs can all share the one update
+    uint32_t jobCount = PlatformGetWorkerCount(workQueue);
+    jobCount = jobCount < update.batchCount ? jobCount : update.batchCount;
+    jobCount = jobCount < PARTICLE_MAX_JOBS ? jobCount : PARTICLE_MAX_JOBS;
+    for (uint32_t i = 0; i < jobCount; ++i)
+    {
+        PlatformAddWorkEntry(workQueue, UpdateParticleJob, &update);
+    }
+    PlatformCompleteAllWork(workQueue);
+    system.liveCount = (uint32_t)update.liveCount;
+}
+
+#pragma endregion Update
+
+#pragma region Render
+
+struct ParticleRenderJob
+{
+    ParticleSystem* system;
+    OffscreenBuffer* buffer;
+    uint32_t firstBand;
+    uint32_t endBand;
+};
+
+// Reads only its own bands' commands, and the band above for quads that reach into its first row
+internal void RenderParticleBands(void* data)
+{
+    ParticleRenderJob* job = (ParticleRenderJob*)data;
+    ParticleSystem& system = *job->system;
+    OffscreenBuffer& buffer = *job->buffer;
+    int32_t bandMinY = (int32_t)(job->firstBand << system.bandShift);
+    int32_t bandMaxY = (int32_t)(job->endBand << system.bandShift);
+    bandMaxY = bandMaxY < buffer.height ? bandMaxY : buffer.height;
+    uint32_t firstBand = job->firstBand > 0 ? job->firstBand - 1 : 0;
+
+    uint32_t batchCount = (system.count + PARTICLE_BATCH_SIZE - 1) / PARTICLE_BATCH_SIZE;
+    for (uint32_t batchIndex = 0; batchIndex < batchCount; ++batchIndex)
+    {
+        ParticleRenderCommand* commands = system.commands + batchIndex * PARTICLE_BATCH_SIZE;
+        const uint32_t* bandEnds = system.bandEnds + batchIndex * PARTICLE_RENDER_BANDS;
+        uint32_t first = firstBand > 0 ? bandEnds[firstBand - 1] : 0;
+        uint32_t end = bandEnds[job->endBand - 1];
+        for (uint32_t i = first; i < end; ++i)
+        {
+            ParticleRenderCommand command = commands[i];
+            int32_t x = (int32_t)(command.pixel & 0xFFFF);
+            int32_t y = (int32_t)(command.pixel >> 16);
+            int32_t minY = y > bandMinY ? y : bandMinY;
+            int32_t maxY = y + PARTICLE_SIDE_IN_PIXELS;
+            maxY = maxY < bandMaxY ? maxY : bandMaxY;
+            if (minY >= maxY)
+            {
+                continue;
+            }
+
+            // One quad row is two pixels, a single 64 bit load and store
+            __m128i color = _mm_set1_epi32((int)command.color);
+            uint8_t* row = (uint8_t*)buffer.data + minY * buffer.pitch + x * buffer.bpp;
+            for (int32_t y = minY; y < maxY; ++y)
+            {
+                __m128i pixels = _mm_loadl_epi64((__m128i*)row);
+                _mm_storel_epi64((__m128i*)row, _mm_adds_epu8(pixels, color));
+                row += buffer.pitch;
+            }
+        }
+    }
+}
+
+void RenderParticles(ParticleSystem& system, OffscreenBuffer& buffer, PlatformWorkQueue* workQueue)
+{
+    if (system.bandCount == 0)
+    {
+        return;     // nothing updated yet
+    }
+    ASSERT((uint32_t)(buffer.height - 1) >> system.bandShift < system.bandCount);
+    uint32_t jobCount = PlatformGetWorkerCount(workQueue);
+    jobCount = jobCount < PARTICLE_MAX_JOBS ? jobCount : PARTICLE_MAX_JOBS;
+    jobCount = jobCount < system.bandCount ? jobCount : system.bandCount;
+
+    ParticleRenderJob jobs[PARTICLE_MAX_JOBS];
+    for (uint32_t i = 0; i < jobCount; ++i)
+    {
+        jobs[i].system = &system;
+        jobs[i].buffer = &buffer;
+        jobs[i].firstBand = system.bandCount * i / jobCount;
+        jobs[i].endBand = system.bandCount * (i + 1) / jobCount;
+        PlatformAddWorkEntry(workQueue, RenderParticleBands, &jobs[i]);
+    }
+    PlatformCompleteAllWork(workQueue);
+}
+
+#pragma endregion Render
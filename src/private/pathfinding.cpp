@@ -0,0 +1,477 @@
+#include "pathfinding.h"
+#include "simd.h"
+#include <string.h>
+
+#define PATH_NODE_CLOSED 0xFFFFFFFF
+#define PATH_STRAIGHT_COST 10
+#define PATH_DIAGONAL_COST 14
+#define PATH_MAX_JOBS 64
+
+void InitializePathfinder(Pathfinder& pathfinder, MemoryArena& arena, uint32_t contextCount, uint32_t queueCapacity)
+{
+    const uint32_t maxNodeCount = PATH_MAX_WINDOW_DIM * PATH_MAX_WINDOW_DIM;
+    pathfinder.contextCount = contextCount;
+    pathfinder.contexts = PushArray(arena, contextCount, PathSearchContext);
+    for (uint32_t i = 0; i < contextCount; ++i)
+    {
+        PathSearchContext& context = pathfinder.contexts[i];
+        context = {};
+        context.nodeStamp = PushArray(arena, maxNodeCount, uint32_t);
+        context.costSoFar = PushArray(arena, maxNodeCount, uint32_t);
+        context.parent = PushArray(arena, maxNodeCount, uint32_t);
+        context.heapIndex = PushArray(arena, maxNodeCount, uint32_t);
+        context.walkable = PushArray(arena, maxNodeCount, uint8_t);
+        context.heap = PushArray(arena, maxNodeCount, PathHeapEntry);
+        memset(context.nodeStamp, 0, maxNodeCount * sizeof(uint32_t));
+    }
+
+    pathfinder.queue = PushArray(arena, queueCapacity, PathRequest*);
+    pathfinder.queueCapacity = queueCapacity;
+    pathfinder.queueFirst = 0;
+    pathfinder.queueCount = 0;
+    pathfinder.suspendedCount = 0;
+}
+
+auto QueuePathRequest(Pathfinder& pathfinder, PathRequest& request) -> bool
+{
+    if (pathfinder.queueCount == pathfinder.queueCapacity)
+    {
+        return false;
+    }
+
+    request.status = PathStatus_Pending;
+    request.length = 0;
+    uint32_t slot = (pathfinder.queueFirst + pathfinder.queueCount) % pathfinder.queueCapacity;
+    pathfinder.queue[slot] = &request;
+    ++pathfinder.queueCount;
+    return true;
+}
+
+#pragma region Search
+
+// Centers the start/goal box in a window up to PATH_WINDOW_MARGIN bigger on each side
+internal auto GetPathWindow(int32_t fromTile, int32_t toTile, int32_t& windowMin, uint32_t& windowDim) -> bool
+{
+    int32_t minTile = fromTile < toTile ? fromTile : toTile;
+    int64_t extent = (int64_t)(fromTile < toTile ? toTile : fromTile) - minTile + 1;
+    if (extent > PATH_MAX_WINDOW_DIM)
+    {
+        return false;
+    }
+
+    int64_t dim = extent + 2 * PATH_WINDOW_MARGIN;
+    windowDim = (uint32_t)(dim < PATH_MAX_WINDOW_DIM ? dim : PATH_MAX_WINDOW_DIM);
+    windowMin = (int32_t)(minTile - ((int64_t)windowDim - extent) / 2);
+    return true;
+}
+
+// One chunk lookup per chunk the window touches, missing or unfinished chunks are all empty so not walkable
+internal void GatherWalkable(TileMap& tileMap, PathWindow window, uint8_t* walkable)
+{
+    static_assert(TILE_CHUNK_DIM == 16, "a chunk row is gathered as one SSE register");
+    const __m128i floor = _mm_set1_epi8(TileValue_Floor);
+    const __m128i one = _mm_set1_epi8(1);
+    int32_t maxX = window.minX + (int32_t)window.width - 1;
+    int32_t maxY = window.minY + (int32_t)window.height - 1;
+    for (int32_t chunkY = TileToChunk(window.minY); chunkY <= TileToChunk(maxY); ++chunkY)
+    {
+        int32_t chunkMinY = chunkY * TILE_CHUNK_DIM;
+        int32_t fromY = window.minY > chunkMinY ? window.minY : chunkMinY;
+        int32_t toY = maxY < chunkMinY + TILE_CHUNK_MASK ? maxY : chunkMinY + TILE_CHUNK_MASK;
+        for (int32_t chunkX = TileToChunk(window.minX); chunkX <= TileToChunk(maxX); ++chunkX)
+        {
+            int32_t chunkMinX = chunkX * TILE_CHUNK_DIM;
+            int32_t fromX = window.minX > chunkMinX ? window.minX : chunkMinX;
+            int32_t toX = maxX < chunkMinX + TILE_CHUNK_MASK ? maxX : chunkMinX + TILE_CHUNK_MASK;
+            TileChunk* chunk = GetReadableTileChunk(tileMap, chunkX, chunkY);
+            uint32_t runLength = (uint32_t)(toX - fromX + 1);
+            for (int32_t y = fromY; y <= toY; ++y)
+            {
+                uint8_t* row = walkable + (uint32_t)(y - window.minY) * window.width + (uint32_t)(fromX - window.minX);
+                if (!chunk)
+                {
+                    memset(row, 0, runLength);
+                    continue;
+                }
+
+                const uint8_t* tiles = chunk->tiles + (y - chunkMinY) * TILE_CHUNK_DIM + (fromX - chunkMinX);
+                if (runLength == TILE_CHUNK_DIM)
+                {
+                    // A whole chunk row is one register
+                    __m128i isFloor = _mm_cmpeq_epi8(_mm_loadu_si128((const __m128i*)tiles), floor);
+                    _mm_storeu_si128((__m128i*)row, _mm_and_si128(isFloor, one));
+                    continue;
+                }
+                for (uint32_t x = 0; x < runLength; ++x)
+                {
+                    row[x] = tiles[x] == TileValue_Floor;
+                }
+            }
+        }
+    }
+}
+
+internal inline uint32_t OctileDistance(int32_t deltaX, int32_t deltaY)
+{
+    uint32_t x = (uint32_t)(deltaX < 0 ? -deltaX : deltaX);
+    uint32_t y = (uint32_t)(deltaY < 0 ? -deltaY : deltaY);
+    uint32_t diagonal = x < y ? x : y;
+    return PATH_STRAIGHT_COST * (x + y) + (PATH_DIAGONAL_COST - 2 * PATH_STRAIGHT_COST) * diagonal;
+}
+
+// Lower estimate first, on ties the one further along, which keeps open grids from flooding
+internal inline uint64_t HeapKey(uint32_t costSoFar, uint32_t heuristic)
+{
+    return (uint64_t)(costSoFar + heuristic) << 32 | (0xFFFFFFFF - costSoFar);
+}
+
+internal void HeapSiftUp(PathSearchContext& context, uint32_t index)
+{
+    PathHeapEntry entry = context.heap[index];
+    while (index > 0)
+    {
+        uint32_t parentIndex = (index - 1) / 2;
+        PathHeapEntry parent = context.heap[parentIndex];
+        if (entry.key >= parent.key)
+        {
+            break;
+        }
+        context.heap[index] = parent;
+        context.heapIndex[parent.node] = index;
+        index = parentIndex;
+    }
+    context.heap[index] = entry;
+    context.heapIndex[entry.node] = index;
+}
+
+internal void HeapSiftDown(PathSearchContext& context, uint32_t index)
+{
+    PathHeapEntry entry = context.heap[index];
+    for (;;)
+    {
+        uint32_t child = 2 * index + 1;
+        if (child >= context.heapCount)
+        {
+            break;
+        }
+        if (child + 1 < context.heapCount && context.heap[child + 1].key < context.heap[child].key)
+        {
+            ++child;
+        }
+        if (context.heap[child].key >= entry.key)
+        {
+            break;
+        }
+        context.heap[index] = context.heap[child];
+        context.heapIndex[context.heap[index].node] = index;
+        index = child;
+    }
+    context.heap[index] = entry;
+    context.heapIndex[entry.node] = index;
+}
+
+internal void HeapPush(PathSearchContext& context, uint32_t node, uint64_t key)
+{
+    context.heap[context.heapCount] = {key, node};
+    HeapSiftUp(context, context.heapCount++);
+}
+
+internal uint32_t HeapPop(PathSearchContext& context)
+{
+    uint32_t node = context.heap[0].node;
+    if (--context.heapCount > 0)
+    {
+        context.heap[0] = context.heap[context.heapCount];
+        HeapSiftDown(context, 0);
+    }
+    return node;
+}
+
+// Walks the parents back from the goal, storing the first PATH_MAX_LENGTH tiles from the start
+internal void StorePath(PathSearchContext& context, PathWindow window, uint32_t startNode, uint32_t goalNode,
+                        PathRequest& request)
+{
+    uint32_t totalLength = 1;
+    for (uint32_t node = goalNode; node != startNode; node = context.parent[node])
+    {
+        ++totalLength;
+    }
+
+    uint32_t length = totalLength < PATH_MAX_LENGTH ? totalLength : PATH_MAX_LENGTH;
+    uint32_t index = totalLength;
+    for (uint32_t node = goalNode;; node = context.parent[node])
+    {
+        if (--index < length)
+        {
+            request.tileX[index] = window.minX + (int32_t)(node % window.width);
+            request.tileY[index] = window.minY + (int32_t)(node / window.width);
+        }
+        if (node == startNode)
+        {
+            break;
+        }
+    }
+
+    request.totalLength = totalLength;
+    request.length = length;
+}
+
+// Copies the window out and opens the start node, false when the request is already decided
+internal auto BeginSearch(PathSearchContext& context, TileMap& tileMap, PathRequest& request) -> bool
+{
+    request.cost = 0;
+    request.totalLength = 0;
+    request.length = 0;
+
+    PathWindow& window = context.window;
+    if (!GetPathWindow(request.startX, request.goalX, window.minX, window.width) ||
+        !GetPathWindow(request.startY, request.goalY, window.minY, window.height))
+    {
+        request.status = PathStatus_TooFar;
+        return false;
+    }
+
+    GatherWalkable(tileMap, window, context.walkable);
+    context.startNode = (uint32_t)(request.startY - window.minY) * window.width + (uint32_t)(request.startX - window.minX);
+    context.goalNode = (uint32_t)(request.goalY - window.minY) * window.width + (uint32_t)(request.goalX - window.minX);
+    if (!context.walkable[context.startNode] || !context.walkable[context.goalNode])
+    {
+        request.status = PathStatus_NoPath;
+        return false;
+    }
+
+    // Stamps only have to differ from every earlier search, reset them all once they wrap
+    if (++context.stamp == 0)
+    {
+        memset(context.nodeStamp, 0, PATH_MAX_WINDOW_DIM * PATH_MAX_WINDOW_DIM * sizeof(uint32_t));
+        context.stamp = 1;
+    }
+    ++context.searches;
+
+    uint32_t startNode = context.startNode;
+    context.heapCount = 0;
+    context.nodeStamp[startNode] = context.stamp;
+    context.costSoFar[startNode] = 0;
+    context.parent[startNode] = startNode;
+    HeapPush(context, startNode, HeapKey(0, OctileDistance(request.startX - request.goalX, request.startY - request.goalY)));
+    return true;
+}
+
+struct PathBudget
+{
+    uint64_t start;
+    float seconds;
+};
+
+// Expands until the search is decided or, with a budget, the clock runs out. True once the request has its status.
+internal auto ContinueSearch(PathSearchContext& context, PathRequest& request, const PathBudget* budget) -> bool
+{
+    const int32_t stepX[8] = {1, -1, 0, 0, 1, -1, 1, -1};
+    const int32_t stepY[8] = {0, 0, 1, -1, 1, 1, -1, -1};
+    const PathWindow& window = context.window;
+    uint32_t stamp = context.stamp;
+    uint32_t goalNode = context.goalNode;
+    int32_t goalX = request.goalX - window.minX;
+    int32_t goalY = request.goalY - window.minY;
+    int32_t width = (int32_t)window.width;
+    int32_t height = (int32_t)window.height;
+
+    uint32_t untilCheck = PATH_EXPANSIONS_PER_CHECK;
+    while (context.heapCount > 0)
+    {
+        if (budget && --untilCheck == 0)
+        {
+            if (PlatformGetSecondsElapsed(budget->start, PlatformGetWallClock()) >= budget->seconds)
+            {
+                return false;
+            }
+            untilCheck = PATH_EXPANSIONS_PER_CHECK;
+        }
+
+        uint32_t node = HeapPop(context);
+        context.heapIndex[node] = PATH_NODE_CLOSED;
+        ++context.expandedNodes;
+        if (node == goalNode)
+        {
+            request.cost = context.costSoFar[node];
+            StorePath(context, window, context.startNode, goalNode, request);
+            request.status = PathStatus_Found;
+            return true;
+        }
+
+        int32_t x = (int32_t)(node % window.width);
+        int32_t y = (int32_t)(node / window.width);
+        uint32_t cost = context.costSoFar[node];
+        bool open[4] = {};
+        for (uint32_t direction = 0; direction < 8; ++direction)
+        {
+            int32_t neighborX = x + stepX[direction];
+            int32_t neighborY = y + stepY[direction];
+            if (neighborX < 0 || neighborY < 0 || neighborX >= width || neighborY >= height)
+            {
+                continue;
+            }
+
+            uint32_t neighbor = (uint32_t)(neighborY * width + neighborX);
+            bool isDiagonal = direction >= 4;
+            if (!isDiagonal)
+            {
+                open[direction] = context.walkable[neighbor];
+            }
+            // Both tiles beside a diagonal step have to be open too, or it would clip the wall corner
+            else if (!open[stepX[direction] > 0 ? 0 : 1] || !open[stepY[direction] > 0 ? 2 : 3])
+            {
+                continue;
+            }
+            if (!context.walkable[neighbor])
+            {
+                continue;
+            }
+
+            uint32_t newCost = cost + (isDiagonal ? PATH_DIAGONAL_COST : PATH_STRAIGHT_COST);
+            if (context.nodeStamp[neighbor] != stamp)
+            {
+                context.nodeStamp[neighbor] = stamp;
+                context.costSoFar[neighbor] = newCost;
+                context.parent[neighbor] = node;
+                HeapPush(context, neighbor, HeapKey(newCost, OctileDistance(neighborX - goalX, neighborY - goalY)));
+            }
+            // The heuristic is consistent, so closed nodes already have their best cost
+            else if (context.heapIndex[neighbor] != PATH_NODE_CLOSED && newCost < context.costSoFar[neighbor])
+            {
+                context.costSoFar[neighbor] = newCost;
+                context.parent[neighbor] = node;
+                uint32_t index = context.heapIndex[neighbor];
+                context.heap[index].key = HeapKey(newCost, OctileDistance(neighborX - goalX, neighborY - goalY));
+                HeapSiftUp(context, index);
+            }
+        }
+    }
+
+    request.status = PathStatus_NoPath;
+    return true;
+}
+
+void FindPath(PathSearchContext& context, TileMap& tileMap, PathRequest& request)
+{
+    ASSERT(!context.suspended);
+    if (BeginSearch(context, tileMap, request))
+    {
+        ContinueSearch(context, request, nullptr);
+    }
+}
+
+#pragma endregion Search
+
+#pragma region Batching
+
+struct PathBatch
+{
+    Pathfinder* pathfinder;
+    TileMap* tileMap;
+    PathBudget budget;
+    uint32_t requestCount;
+    LONG volatile nextRequest;    // requests below it have been claimed by a job
+    LONG volatile finished;
+};
+
+struct PathBatchJob
+{
+    PathBatch* batch;
+    PathSearchContext* context;
+};
+
+// Resumes the context's parked search, then claims queued requests one at a time until the budget is gone.
+// The first claim always happens and every search gets at least one slice, so every call makes progress.
+internal void RunPathBatchJob(void* data)
+{
+    PathBatchJob* job = (PathBatchJob*)data;
+    PathBatch* batch = job->batch;
+    PathSearchContext& context = *job->context;
+    Pathfinder* pathfinder = batch->pathfinder;
+    if (context.suspended)
+    {
+        if (!ContinueSearch(context, *context.suspended, &batch->budget))
+        {
+            return;
+        }
+        context.suspended = nullptr;
+        InterlockedIncrement(&batch->finished);
+    }
+
+    for (;;)
+    {
+        if (batch->nextRequest > 0 &&
+            PlatformGetSecondsElapsed(batch->budget.start, PlatformGetWallClock()) >= batch->budget.seconds)
+        {
+            break;
+        }
+
+        uint32_t index = (uint32_t)InterlockedIncrement(&batch->nextRequest) - 1;
+        if (index >= batch->requestCount)
+        {
+            break;
+        }
+
+        PathRequest* request = pathfinder->queue[(pathfinder->queueFirst + index) % pathfinder->queueCapacity];
+        if (BeginSearch(context, *batch->tileMap, *request) && !ContinueSearch(context, *request, &batch->budget))
+        {
+            // Out of the queue, this context owns it until it finishes
+            context.suspended = request;
+            break;
+        }
+        InterlockedIncrement(&batch->finished);
+    }
+}
+
+auto RunPathRequests(Pathfinder& pathfinder, TileMap& tileMap, PlatformWorkQueue* workQueue, float budgetSeconds)
+    -> uint32_t
+{
+    if (pathfinder.queueCount == 0 && pathfinder.suspendedCount == 0)
+    {
+        return 0;
+    }
+
+    PathBatch batch = {};
+    batch.pathfinder = &pathfinder;
+    batch.tileMap = &tileMap;
+    batch.budget = {PlatformGetWallClock(), budgetSeconds};
+    batch.requestCount = pathfinder.queueCount;
+    batch.nextRequest = 0;
+    batch.finished = 0;
+
+    // One job per context, each thread searching needs its own. Every context with a parked search gets a job.
+    uint32_t jobLimit = PlatformGetWorkerCount(workQueue);
+    jobLimit = jobLimit < pathfinder.contextCount ? jobLimit : pathfinder.contextCount;
+    jobLimit = jobLimit < PATH_MAX_JOBS ? jobLimit : PATH_MAX_JOBS;
+    uint32_t jobCount = jobLimit < batch.requestCount ? jobLimit : batch.requestCount;
+    for (uint32_t i = jobCount; i < jobLimit; ++i)
+    {
+        if (pathfinder.contexts[i].suspended)
+        {
+            jobCount = i + 1;
+        }
+    }
+    PathBatchJob jobs[PATH_MAX_JOBS];
+    for (uint32_t i = 0; i < jobCount; ++i)
+    {
+        jobs[i] = {&batch, &pathfinder.contexts[i]};
+        PlatformAddWorkEntry(workQueue, RunPathBatchJob, &jobs[i]);
+    }
+    PlatformCompleteAllWork(workQueue);
+
+    // Jobs can claim past the end before noticing it, everything claimed below requestCount left the queue
+    uint32_t claimed = (uint32_t)batch.nextRequest < batch.requestCount ? (uint32_t)batch.nextRequest
+                                                                         : batch.requestCount;
+    pathfinder.queueFirst = (pathfinder.queueFirst + claimed) % pathfinder.queueCapacity;
+    pathfinder.queueCount -= claimed;
+
+    pathfinder.suspendedCount = 0;
+    for (uint32_t i = 0; i < pathfinder.contextCount; ++i)
+    {
+        pathfinder.suspendedCount += pathfinder.contexts[i].suspended != nullptr;
+    }
+    return (uint32_t)batch.finished;
+}
+
+#pragma endregion Batching
@@ -0,0 +1,270 @@
+#include "platform.h"
+
+auto PlatformAllocateGameMemory(GameMemory& memory) -> bool
+{
+    memory = {};
+    memory.permanentStorageSize = Megabytes(64);
+    memory.transientStorageSize = Megabytes(128);
+
+    // One allocation so the whole game state is contiguous (and easy to snapshot later)
+    uint64_t totalSize = memory.permanentStorageSize + memory.transientStorageSize;
+    memory.permanentStorage = VirtualAlloc(nullptr, (SIZE_T)totalSize, MEM_COMMIT | MEM_RESERVE, PAGE_READWRITE);
+    if (!memory.permanentStorage)
+    {
+        OutputDebugStringA("Failed to allocate game memory\n");
+        return false;
+    }
+    memory.transientStorage = (uint8_t*)memory.permanentStorage + memory.permanentStorageSize;
+    return true;
+}
+
+void PlatformFreeGameMemory(GameMemory& memory)
+{
+    if (memory.permanentStorage)
+    {
+        VirtualFree(memory.permanentStorage, 0, MEM_RELEASE);
+    }
+    memory = {};
+}
+
+#pragma region Mapped files
+
+auto PlatformOpenMappedFile(const char* path, PlatformMappedFile& file) -> bool
+{
+    file = {};
+    HANDLE fileHandle = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (fileHandle == INVALID_HANDLE_VALUE)
+    {
+        return false;
+    }
+
+    LARGE_INTEGER fileSize;
+    if (!GetFileSizeEx(fileHandle, &fileSize) || fileSize.QuadPart == 0)
+    {
+        CloseHandle(fileHandle);
+        return false;
+    }
+
+    HANDLE mappingHandle = CreateFileMappingA(fileHandle, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (!mappingHandle)
+    {
+        OutputDebugStringA("Failed to create file mapping\n");
+        CloseHandle(fileHandle);
+        return false;
+    }
+
+    file.fileHandle = fileHandle;
+    file.mappingHandle = mappingHandle;
+    file.size = (uint64_t)fileSize.QuadPart;
+    return true;
+}
+
+void PlatformCloseMappedFile(PlatformMappedFile& file)
+{
+    if (file.mappingHandle)
+    {
+        CloseHandle(file.mappingHandle);
+    }
+    if (file.fileHandle)
+    {
+        CloseHandle(file.fileHandle);
+    }
+    file = {};
+}
+
+auto PlatformMapView(PlatformMappedFile& file, uint64_t offset, uint32_t size) -> void*
+{
+    if (offset >= file.size)
+    {
+        return nullptr;
+    }
+    if (offset + size > file.size)
+    {
+        size = (uint32_t)(file.size - offset);
+    }
+    return MapViewOfFile(file.mappingHandle, FILE_MAP_READ, (DWORD)(offset >> 32), (DWORD)(offset & 0xFFFFFFFF), size);
+}
+
+void PlatformUnmapView(void* view)
+{
+    if (view)
+    {
+        UnmapViewOfFile(view);
+    }
+}
+
+auto PlatformGetMapGranularity() -> uint32_t
+{
+    local uint32_t granularity = 0;
+    if (!granularity)
+    {
+        SYSTEM_INFO info;
+        GetSystemInfo(&info);
+        granularity = info.dwAllocationGranularity;
+    }
+    return granularity;
+}
+
+#pragma endregion Mapped files
+
+#pragma region Work queue
+
+#define WORK_QUEUE_ENTRY_COUNT 256
+
+struct PlatformWorkQueueEntry
+{
+    PlatformWorkQueueCallback* callback;
+    void* data;
+};
+
+/*
+    NOTE: Single producer ring. The producer publishes an entry by moving nextEntryToWrite
+    past it, workers claim entries by compare-exchanging nextEntryToRead and count them
+    done in completionCount. The semaphore only wakes sleeping workers.
+*/
+struct PlatformWorkQueue
+{
+    LONG volatile completionGoal;
+    LONG volatile completionCount;
+    LONG volatile nextEntryToWrite;
+    LONG volatile nextEntryToRead;
+    HANDLE semaphore;
+    uint32_t threadCount;
+    PlatformWorkQueueEntry entries[WORK_QUEUE_ENTRY_COUNT];
+};
+
+// Runs one entry if there is one, false when the queue looked empty
+internal bool DoNextWorkEntry(PlatformWorkQueue* queue)
+{
+    LONG originalNextEntryToRead = queue->nextEntryToRead;
+    if (originalNextEntryToRead == queue->nextEntryToWrite)
+    {
+        return false;
+    }
+
+    LONG newNextEntryToRead = (originalNextEntryToRead + 1) % WORK_QUEUE_ENTRY_COUNT;
+    if (InterlockedCompareExchange(&queue->nextEntryToRead, newNextEntryToRead, originalNextEntryToRead) ==
+        originalNextEntryToRead)
+    {
+        PlatformWorkQueueEntry entry = queue->entries[originalNextEntryToRead];
+        entry.callback(entry.data);
+        InterlockedIncrement(&queue->completionCount);
+    }
+    return true;
+}
+
+internal DWORD WINAPI WorkerThreadProc(LPVOID parameter)
+{
+    PlatformWorkQueue* queue = (PlatformWorkQueue*)parameter;
+    for (;;)
+    {
+        if (!DoNextWorkEntry(queue))
+        {
+            WaitForSingleObjectEx(queue->semaphore, INFINITE, FALSE);
+        }
+    }
+}
+
+auto PlatformCreateWorkQueue(uint32_t threadCount) -> PlatformWorkQueue*
+{
+    PlatformWorkQueue* queue = (PlatformWorkQueue*)VirtualAlloc(nullptr, sizeof(PlatformWorkQueue),
+                                                                MEM_COMMIT | MEM_RESERVE, PAGE_READWRITE);
+    if (!queue)
+    {
+        OutputDebugStringA("Failed to allocate work queue\n");
+        return nullptr;
+    }
+
+    queue->semaphore = CreateSemaphoreExA(nullptr, 0, (LONG)(threadCount + 1), nullptr, 0, SEMAPHORE_ALL_ACCESS);
+    for (uint32_t i = 0; i < threadCount; ++i)
+    {
+        HANDLE thread = CreateThread(nullptr, 0, WorkerThreadProc, queue, 0, nullptr);
+        if (!thread)
+        {
+            OutputDebugStringA("Failed to start worker thread\n");
+            break;
+        }
+        CloseHandle(thread);
+        ++queue->threadCount;
+    }
+    return queue;
+}
+
+auto PlatformGetProcessorCount() -> uint32_t
+{
+    SYSTEM_INFO info;
+    GetSystemInfo(&info);
+    return (uint32_t)info.dwNumberOfProcessors;
+}
+
+void PlatformAddWorkEntry(PlatformWorkQueue* queue, PlatformWorkQueueCallback* callback, void* data)
+{
+    // Nobody else would ever pick it up from a queue without threads
+    if (!queue || queue->threadCount == 0)
+    {
+        callback(data);
+        return;
+    }
+
+    // A full ring would overwrite an entry nobody has claimed yet, so the producer helps drain it.
+    // Claimed entries are copied out before they run, their slots are free to reuse.
+    LONG newNextEntryToWrite = (queue->nextEntryToWrite + 1) % WORK_QUEUE_ENTRY_COUNT;
+    while (newNextEntryToWrite == queue->nextEntryToRead)
+    {
+        DoNextWorkEntry(queue);
+    }
+    PlatformWorkQueueEntry& entry = queue->entries[queue->nextEntryToWrite];
+    entry.callback = callback;
+    entry.data = data;
+    queue->completionGoal = queue->completionGoal + 1;   // only the producer writes it
+    // The entry has to be visible before the index that publishes it
+    _ReadWriteBarrier();
+    MemoryBarrier();
+    queue->nextEntryToWrite = newNextEntryToWrite;
+    ReleaseSemaphore(queue->semaphore, 1, nullptr);
+}
+
+void PlatformCompleteAllWork(PlatformWorkQueue* queue)
+{
+    if (!queue)
+    {
+        return;
+    }
+
+    while (queue->completionCount != queue->completionGoal)
+    {
+        DoNextWorkEntry(queue);
+    }
+    queue->completionGoal = 0;
+    queue->completionCount = 0;
+}
+
+auto PlatformGetWorkerCount(PlatformWorkQueue* queue) -> uint32_t
+{
+    return queue ? queue->threadCount + 1 : 1;
+}
+
+#pragma endregion Work queue
+
+#pragma region Clock
+
+auto PlatformGetWallClock() -> uint64_t
+{
+    LARGE_INTEGER counter;
+    QueryPerformanceCounter(&counter);
+    return (uint64_t)counter.QuadPart;
+}
+
+auto PlatformGetSecondsElapsed(uint64_t start, uint64_t end) -> float
+{
+    local uint64_t frequency = 0;
+    if (!frequency)
+    {
+        LARGE_INTEGER value;
+        QueryPerformanceFrequency(&value);
+        frequency = (uint64_t)value.QuadPart;
+    }
+    return (float)(end - start) / (float)frequency;
+}
+
+#pragma endregion Clock
@@ -0,0 +1,45 @@
+#include "radix_sort.h"
+#include <string.h>
+
+void RadixSort(uint32_t* keys, uint32_t* values, uint32_t* scratchKeys, uint32_t* scratchValues, uint32_t count,
+               uint32_t maxKey)
+{
+    uint32_t* sourceKeys = keys;
+    uint32_t* sourceValues = values;
+    uint32_t* destKeys = scratchKeys;
+    uint32_t* destValues = scratchValues;
+    for (uint32_t shift = 0; shift < 32 && (maxKey >> shift) != 0; shift += 8)
+    {
+        uint32_t offsets[256] = {};
+        for (uint32_t i = 0; i < count; ++i)
+        {
+            ++offsets[(sourceKeys[i] >> shift) & 0xFF];
+        }
+        uint32_t total = 0;
+        for (uint32_t& offset : offsets)
+        {
+            uint32_t bucketCount = offset;
+            offset = total;
+            total += bucketCount;
+        }
+        for (uint32_t i = 0; i < count; ++i)
+        {
+            uint32_t dest = offsets[(sourceKeys[i] >> shift) & 0xFF]++;
+            destKeys[dest] = sourceKeys[i];
+            destValues[dest] = sourceValues[i];
+        }
+
+        uint32_t* swapKeys = sourceKeys;
+        uint32_t* swapValues = sourceValues;
+        sourceKeys = destKeys;
+        sourceValues = destValues;
+        destKeys = swapKeys;
+        destValues = swapValues;
+    }
+
+    if (sourceKeys != keys)
+    {
+        memcpy(keys, sourceKeys, count * sizeof(uint32_t));
+        memcpy(values, sourceValues, count * sizeof(uint32_t));
+    }
+}
@@ -0,0 +1,76 @@
+#include "random.h"
+
+internal inline uint64_t SplitMix64(uint64_t& state)
+{
+    state += 0x9E3779B97F4A7C15ull;
+    uint64_t mixed = state;
+    mixed = (mixed ^ (mixed >> 30)) * 0xBF58476D1CE4E5B9ull;
+    mixed = (mixed ^ (mixed >> 27)) * 0x94D049BB133111EBull;
+    return mixed ^ (mixed >> 31);
+}
+
+auto RandomSeed(uint64_t seed, RandomStream stream, uint64_t index) -> RandomSeries
+{
+    // Each input goes through its own mixing round, so nearby seeds, streams and indices
+    // land far apart instead of cancelling out
+    uint64_t mix = seed;
+    mix = SplitMix64(mix) ^ stream;
+    mix = SplitMix64(mix) ^ index;
+    uint64_t low = SplitMix64(mix);
+    uint64_t high = SplitMix64(mix);
+
+    RandomSeries series;
+    series.state[0] = (uint32_t)low;
+    series.state[1] = (uint32_t)(low >> 32);
+    series.state[2] = (uint32_t)high;
+    series.state[3] = (uint32_t)(high >> 32);
+    if (!(low | high))
+    {
+        series.state[0] = 1;    // all zero would only ever give zeros
+    }
+    return series;
+}
+
+auto RandomSeed8(uint64_t seed, RandomStream stream, uint64_t index) -> RandomSeries8
+{
+    RandomSeries8 result;
+    for (uint32_t lane = 0; lane < LANE8_WIDTH; ++lane)
+    {
+        RandomSeries series = RandomSeed(seed, stream, index * LANE8_WIDTH + lane);
+        for (uint32_t word = 0; word < 4; ++word)
+        {
+            result.state[word][lane] = series.state[word];
+        }
+    }
+    return result;
+}
+
+SIMD_TARGET_AVX2 internal void FillRandomUnilateralAVX2(RandomSeries8& series, float* dest, uint32_t count)
+{
+    for (uint32_t i = 0; i < count; i += LANE8_WIDTH)
+    {
+        _mm256_storeu_ps(dest + i, RandomUnilateral8(series).v);
+    }
+}
+
+internal void FillRandomUnilateralSSE(RandomSeries8& series, float* dest, uint32_t count)
+{
+    for (uint32_t i = 0; i < count; i += LANE8_WIDTH)
+    {
+        _mm_storeu_ps(dest + i, RandomUnilateral4(series, 0).v);
+        _mm_storeu_ps(dest + i + LANE_WIDTH, RandomUnilateral4(series, 1).v);
+    }
+}
+
+void FillRandomUnilateral(RandomSeries8& series, float* dest, uint32_t count)
+{
+    ASSERT(count % LANE8_WIDTH == 0);
+    if (CpuHasAvx2())
+    {
+        FillRandomUnilateralAVX2(series, dest, count);
+    }
+    else
+    {
+        FillRandomUnilateralSSE(series, dest, count);
+    }
+}
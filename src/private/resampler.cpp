@@ -0,0 +1,308 @@
+#include "resampler.h"
+#include "simd.h"
+#include <math.h>
+#include <string.h>
+
+struct ResamplePreset
+{
+    int taps;
+    int phases;
+    double kaiserBeta;
+};
+
+internal ResamplePreset GetPreset(ResampleQuality quality)
+{
+    switch (quality)
+    {
+        case ResampleQuality::Linear: return {2, 1, 0.0};
+        case ResampleQuality::Low:    return {8, 32, 5.0};
+        case ResampleQuality::Medium: return {16, 64, 7.0};
+        case ResampleQuality::High:   return {32, 256, 9.0};
+    }
+    return {16, 64, 7.0};
+}
+
+// Zeroth order modified Bessel function of the first kind, for the Kaiser window
+internal double BesselI0(double x)
+{
+    double sum = 1.0;
+    double term = 1.0;
+    double halfX = x * 0.5;
+    for (int k = 1; k < 32; ++k)
+    {
+        term *= (halfX / k) * (halfX / k);
+        sum += term;
+        if (term < sum * 1e-12)
+        {
+            break;
+        }
+    }
+    return sum;
+}
+
+#pragma region Dot products
+
+internal void DotScalar(const float* row0, const float* row1, float blend,
+                        const float* left, const float* right, int taps, float* outLeft, float* outRight)
+{
+    float l = 0.0f;
+    float r = 0.0f;
+    for (int k = 0; k < taps; ++k)
+    {
+        float c = row0[k] + blend * (row1[k] - row0[k]);
+        l += c * left[k];
+        r += c * right[k];
+    }
+    *outLeft = l;
+    *outRight = r;
+}
+
+internal void DotSSE(const float* row0, const float* row1, float blend,
+                     const float* left, const float* right, int taps, float* outLeft, float* outRight)
+{
+    __m128 t = _mm_set1_ps(blend);
+    __m128 accLeft = _mm_setzero_ps();
+    __m128 accRight = _mm_setzero_ps();
+    for (int k = 0; k < taps; k += 4)
+    {
+        __m128 c0 = _mm_load_ps(row0 + k);
+        __m128 c1 = _mm_load_ps(row1 + k);
+        __m128 c = _mm_add_ps(c0, _mm_mul_ps(t, _mm_sub_ps(c1, c0)));
+        accLeft = _mm_add_ps(accLeft, _mm_mul_ps(c, _mm_loadu_ps(left + k)));
+        accRight = _mm_add_ps(accRight, _mm_mul_ps(c, _mm_loadu_ps(right + k)));
+    }
+    *outLeft = HorizontalAdd(accLeft);
+    *outRight = HorizontalAdd(accRight);
+}
+
+SIMD_TARGET_AVX2
+internal void DotAVX2(const float* row0, const float* row1, float blend,
+                      const float* left, const float* right, int taps, float* outLeft, float* outRight)
+{
+    __m256 t = _mm256_set1_ps(blend);
+    __m256 accLeft = _mm256_setzero_ps();
+    __m256 accRight = _mm256_setzero_ps();
+    for (int k = 0; k < taps; k += 8)
+    {
+        __m256 c0 = _mm256_loadu_ps(row0 + k);
+        __m256 c1 = _mm256_loadu_ps(row1 + k);
+        __m256 c = _mm256_fmadd_ps(t, _mm256_sub_ps(c1, c0), c0);
+        accLeft = _mm256_fmadd_ps(c, _mm256_loadu_ps(left + k), accLeft);
+        accRight = _mm256_fmadd_ps(c, _mm256_loadu_ps(right + k), accRight);
+    }
+    *outLeft = HorizontalAdd(_mm_add_ps(_mm256_castps256_ps128(accLeft), _mm256_extractf128_ps(accLeft, 1)));
+    *outRight = HorizontalAdd(_mm_add_ps(_mm256_castps256_ps128(accRight), _mm256_extractf128_ps(accRight, 1)));
+}
+
+#pragma endregion Dot products
+
+void ResamplerBuildKernel(ResamplerKernel& kernel, MemoryArena& arena, ResampleQuality quality, float cutoff)
+{
+    ResamplePreset preset = GetPreset(quality);
+    kernel.quality = quality;
+    kernel.taps = preset.taps;
+    kernel.phases = preset.phases;
+    kernel.coefficients = nullptr;
+    kernel.dot = DotScalar;
+    if (quality == ResampleQuality::Linear)
+    {
+        return;
+    }
+
+    int taps = preset.taps;
+    kernel.coefficients = (float*)PushSize_(arena, (size_t)(preset.phases + 1) * taps * sizeof(float), 32);
+
+    // Row p is the kernel for a read position p/phases past the tap center,
+    // the extra last row (p == phases) lets us blend from the final phase into the next sample
+    double center = taps / 2 - 1;
+    double windowScale = 1.0 / BesselI0(preset.kaiserBeta);
+    for (int p = 0; p <= preset.phases; ++p)
+    {
+        double frac = (double)p / preset.phases;
+        float* row = kernel.coefficients + p * taps;
+        double sum = 0.0;
+        for (int k = 0; k < taps; ++k)
+        {
+            double x = k - center - frac;
+            double sinc = x == 0.0 ? 2.0 * cutoff : sin(2.0 * M_PI * cutoff * x) / (M_PI * x);
+
+            double n = x / (taps / 2.0);
+            double window = fabs(n) < 1.0 ? BesselI0(preset.kaiserBeta * sqrt(1.0 - n * n)) * windowScale : 0.0;
+            row[k] = (float)(sinc * window);
+            sum += row[k];
+        }
+
+        // Unity gain at DC for every phase, otherwise pitch shifting wobbles the level
+        for (int k = 0; k < taps; ++k)
+        {
+            row[k] = (float)(row[k] / sum);
+        }
+    }
+
+    kernel.dot = CpuHasAvx2() && taps % 8 == 0 ? DotAVX2 : DotSSE;
+}
+
+void ResamplerInitialize(ResamplerState& state, MemoryArena& arena)
+{
+    state = {};
+    state.inputLeft = PushArray(arena, RESAMPLER_MAX_TAPS + RESAMPLER_INPUT_FRAMES, float);
+    state.inputRight = PushArray(arena, RESAMPLER_MAX_TAPS + RESAMPLER_INPUT_FRAMES, float);
+}
+
+void ResamplerSetRatio(ResamplerState& state, int inputRate, int outputRate, float pitch)
+{
+    state.step = ((double)inputRate / (double)outputRate) * pitch;
+}
+
+void ResamplerReset(ResamplerState& state, const ResamplerKernel* kernel, int inputRate, int outputRate, float pitch)
+{
+    state.kernel = kernel;
+    state.position = 0.0;
+    ResamplerSetRatio(state, inputRate, outputRate, pitch);
+
+    // Prime with silence so position 0 lines up with the center tap on the first input frame
+    state.inputCount = kernel->taps / 2 - 1;
+    memset(state.inputLeft, 0, (RESAMPLER_MAX_TAPS + RESAMPLER_INPUT_FRAMES) * sizeof(float));
+    memset(state.inputRight, 0, (RESAMPLER_MAX_TAPS + RESAMPLER_INPUT_FRAMES) * sizeof(float));
+}
+
+internal bool Refill(ResamplerState& state, ResamplerPullFunc pull, void* user)
+{
+    // Keep everything from the current read position on, that is the filter history
+    int base = (int)state.position;
+    int keep = state.inputCount - base;
+    if (keep > 0)
+    {
+        memmove(state.inputLeft, state.inputLeft + base, keep * sizeof(float));
+        memmove(state.inputRight, state.inputRight + base, keep * sizeof(float));
+    }
+    else
+    {
+        keep = 0;
+    }
+    state.position -= base;
+    state.inputCount = keep;
+
+    int capacity = RESAMPLER_MAX_TAPS + RESAMPLER_INPUT_FRAMES;
+    int wanted = capacity - keep;
+    memset(state.inputLeft + keep, 0, wanted * sizeof(float));
+    memset(state.inputRight + keep, 0, wanted * sizeof(float));
+    int got = pull(user, state.inputLeft + keep, state.inputRight + keep, wanted);
+    state.inputCount += got;
+    return got > 0;
+}
+
+int ResamplerMix(ResamplerState& state, ResamplerPullFunc pull, void* user,
+                 float* outLeft, float* outRight, int frameCount, float volume)
+{
+    const ResamplerKernel& kernel = *state.kernel;
+    int taps = kernel.taps;
+
+    int produced = 0;
+    while (produced < frameCount)
+    {
+        int base = (int)state.position;
+        if (base + taps > state.inputCount)
+        {
+            if (!Refill(state, pull, user))
+            {
+                break;
+            }
+            continue;
+        }
+
+        float frac = (float)(state.position - base);
+        float l, r;
+        if (kernel.quality == ResampleQuality::Linear)
+        {
+            l = state.inputLeft[base] + frac * (state.inputLeft[base + 1] - state.inputLeft[base]);
+            r = state.inputRight[base] + frac * (state.inputRight[base + 1] - state.inputRight[base]);
+        }
+        else
+        {
+            float phasePosition = frac * kernel.phases;
+            int phase = (int)phasePosition;
+            const float* row0 = kernel.coefficients + phase * taps;
+            kernel.dot(row0, row0 + taps, phasePosition - phase,
+                       state.inputLeft + base, state.inputRight + base, taps, &l, &r);
+        }
+
+        outLeft[produced] += l * volume;
+        outRight[produced] += r * volume;
+        ++produced;
+        state.position += state.step;
+    }
+    return produced;
+}
+
+struct BufferSource
+{
+    const float* left;
+    const float* right;
+    int frameCount;
+    int position;
+};
+
+internal int PullFromBuffer(void* user, float* left, float* right, int frameCount)
+{
+    BufferSource* source = (BufferSource*)user;
+    int count = source->frameCount - source->position;
+    if (count > frameCount)
+    {
+        count = frameCount;
+    }
+    if (count > 0)
+    {
+        memcpy(left, source->left + source->position, count * sizeof(float));
+        memcpy(right, source->right + source->position, count * sizeof(float));
+        source->position += count;
+    }
+    return count;
+}
+
+// Feeds silence after the real input so the filter tail gets flushed out
+internal int PullFromBufferWithTail(void* user, float* left, float* right, int frameCount)
+{
+    BufferSource* source = (BufferSource*)user;
+    int got = PullFromBuffer(user, left, right, frameCount);
+    if (got == 0 && source->position < source->frameCount + RESAMPLER_MAX_TAPS)
+    {
+        got = frameCount < RESAMPLER_MAX_TAPS ? frameCount : RESAMPLER_MAX_TAPS;
+        source->position += got;
+    }
+    return got;
+}
+
+int ResampleBuffer(MemoryArena& tempArena, ResampleQuality quality,
+                   const float* inLeft, const float* inRight, int inFrameCount, int inputRate,
+                   float* outLeft, float* outRight, int outCapacity, int outputRate)
+{
+    TemporaryMemory temp = BeginTemporaryMemory(tempArena);
+
+    // Decimating needs the cutoff pulled down to the output Nyquist or it aliases
+    float cutoff = 0.45f;
+    if (outputRate < inputRate)
+    {
+        cutoff *= (float)outputRate / (float)inputRate;
+    }
+
+    ResamplerKernel kernel;
+    ResamplerBuildKernel(kernel, tempArena, quality, cutoff);
+    ResamplerState state;
+    ResamplerInitialize(state, tempArena);
+    ResamplerReset(state, &kernel, inputRate, outputRate, 1.0f);
+
+    int outFrameCount = (int)((int64_t)inFrameCount * outputRate / inputRate);
+    if (outFrameCount > outCapacity)
+    {
+        outFrameCount = outCapacity;
+    }
+    memset(outLeft, 0, outFrameCount * sizeof(float));
+    memset(outRight, 0, outFrameCount * sizeof(float));
+
+    BufferSource source = {inLeft, inRight, inFrameCount, 0};
+    int produced = ResamplerMix(state, PullFromBufferWithTail, &source, outLeft, outRight, outFrameCount, 1.0f);
+
+    EndTemporaryMemory(temp);
+    return produced;
+}
@@ -0,0 +1,64 @@
+#include "sample_convert.h"
+#include "simd.h"
+
+void DitherInitialize(DitherState& dither, uint64_t seed)
+{
+    dither.random = RandomSeed8(seed, RandomStream_Audio, 0);
+}
+
+// Triangular noise of +-1 lsb: the difference of two 16 bit uniforms, both halves of one draw
+internal inline __m128 TriangularDither(RandomSeries8& random, uint32_t half)
+{
+    __m128i bits = RandomNext4(random, half).v;
+    __m128i difference = _mm_sub_epi32(_mm_and_si128(bits, _mm_set1_epi32(0xFFFF)), _mm_srli_epi32(bits, 16));
+    return _mm_mul_ps(_mm_cvtepi32_ps(difference), _mm_set1_ps(1.0f / 65536.0f));
+}
+
+void ConvertToInt16Interleaved(const float* left, const float* right, int16_t* out, int frameCount,
+                               float gain, DitherState* dither)
+{
+    const __m128 scale = _mm_set1_ps(gain * 32767.0f);
+    const __m128 low = _mm_set1_ps(-32768.0f);
+    const __m128 high = _mm_set1_ps(32767.0f);
+
+    int frame = 0;
+    for (; frame + 8 <= frameCount; frame += 8)
+    {
+        __m128 l0 = _mm_mul_ps(_mm_loadu_ps(left + frame), scale);
+        __m128 l1 = _mm_mul_ps(_mm_loadu_ps(left + frame + 4), scale);
+        __m128 r0 = _mm_mul_ps(_mm_loadu_ps(right + frame), scale);
+        __m128 r1 = _mm_mul_ps(_mm_loadu_ps(right + frame + 4), scale);
+        if (dither)
+        {
+            l0 = _mm_add_ps(l0, TriangularDither(dither->random, 0));
+            l1 = _mm_add_ps(l1, TriangularDither(dither->random, 1));
+            r0 = _mm_add_ps(r0, TriangularDither(dither->random, 0));
+            r1 = _mm_add_ps(r1, TriangularDither(dither->random, 1));
+        }
+
+        // Clamp first, cvtps turns anything past int32 range into 0x80000000 whatever the sign.
+        // It rounds to nearest.
+        __m128i li0 = _mm_cvtps_epi32(_mm_max_ps(_mm_min_ps(l0, high), low));
+        __m128i li1 = _mm_cvtps_epi32(_mm_max_ps(_mm_min_ps(l1, high), low));
+        __m128i ri0 = _mm_cvtps_epi32(_mm_max_ps(_mm_min_ps(r0, high), low));
+        __m128i ri1 = _mm_cvtps_epi32(_mm_max_ps(_mm_min_ps(r1, high), low));
+
+        // L0 R0 L1 R1 ... then the saturating pack halves them to int16
+        __m128i a = _mm_packs_epi32(_mm_unpacklo_epi32(li0, ri0), _mm_unpackhi_epi32(li0, ri0));
+        __m128i b = _mm_packs_epi32(_mm_unpacklo_epi32(li1, ri1), _mm_unpackhi_epi32(li1, ri1));
+        _mm_storeu_si128((__m128i*)(out + frame * 2), a);
+        _mm_storeu_si128((__m128i*)(out + frame * 2 + 8), b);
+    }
+
+    // Tail with the same rounding and saturation
+    for (; frame < frameCount; ++frame)
+    {
+        __m128 value = _mm_mul_ps(_mm_setr_ps(left[frame], right[frame], 0.0f, 0.0f), scale);
+        if (dither)
+        {
+            value = _mm_add_ps(value, TriangularDither(dither->random, 0));
+        }
+        __m128i packed = _mm_packs_epi32(_mm_cvtps_epi32(_mm_max_ps(_mm_min_ps(value, high), low)), _mm_setzero_si128());
+        *(int32_t*)(out + frame * 2) = _mm_cvtsi128_si32(packed);
+    }
+}
@@ -0,0 +1,154 @@
+#include "sequencer.h"
+#include <math.h>
+#include <string.h>
+
+auto TrackerCreateSong(MemoryArena& arena, int channelCount, int patternCount, int rowsPerPattern,
+                       int orderCount, int instrumentCount) -> TrackerSong*
+{
+    ASSERT(channelCount > 0 && channelCount <= SEQUENCER_MAX_CHANNELS);
+    TrackerSong* song = PushStruct(arena, TrackerSong);
+    *song = {};
+    song->channelCount = channelCount;
+    song->beatsPerMinute = 120.0f;
+    song->rowsPerBeat = 4;
+    song->loop = true;
+
+    song->patternCount = patternCount;
+    song->patterns = PushArray(arena, patternCount, TrackerPattern);
+    for (int pattern = 0; pattern < patternCount; ++pattern)
+    {
+        song->patterns[pattern].rowCount = rowsPerPattern;
+        song->patterns[pattern].cells = PushArray(arena, rowsPerPattern * channelCount, TrackerCell);
+        memset(song->patterns[pattern].cells, 0, rowsPerPattern * channelCount * sizeof(TrackerCell));
+    }
+
+    song->orderCount = orderCount;
+    song->orders = PushArray(arena, orderCount, uint8_t);
+    memset(song->orders, 0, orderCount);
+
+    song->instrumentCount = instrumentCount;
+    song->instruments = PushArray(arena, instrumentCount, TrackerInstrument);
+    for (int i = 0; i < instrumentCount; ++i)
+    {
+        song->instruments[i] = {};
+        song->instruments[i].baseNote = 60;
+        song->instruments[i].priority = MIXER_PRIORITY_HIGH;
+        song->instruments[i].volume = 1.0f;
+    }
+    return song;
+}
+
+internal void StopChannels(Sequencer& sequencer, Mixer& mixer)
+{
+    for (VoiceHandle& voice : sequencer.channelVoices)
+    {
+        MixerStop(mixer, voice);
+        voice = {};
+    }
+}
+
+internal void TriggerCell(Sequencer& sequencer, Mixer& mixer, int channel, const TrackerCell& cell)
+{
+    if (cell.note == NOTE_NONE)
+    {
+        return;
+    }
+
+    VoiceHandle& voice = sequencer.channelVoices[channel];
+    MixerStop(mixer, voice);
+    voice = {};
+    if (cell.note == NOTE_OFF || cell.instrument >= sequencer.song->instrumentCount)
+    {
+        return;
+    }
+
+    TrackerInstrument& instrument = sequencer.song->instruments[cell.instrument];
+    float volume = instrument.volume * (cell.volume ? cell.volume / 64.0f : 1.0f);
+    if (instrument.type == InstrumentType::Sine)
+    {
+        float toneHz = 440.0f * powf(2.0f, (cell.note - 69) / 12.0f);
+        voice = MixerPlaySine(mixer, toneHz, volume, instrument.bus, instrument.priority);
+    }
+    else if (instrument.sound)
+    {
+        voice = MixerPlaySound(mixer, instrument.sound, volume, false, instrument.bus, instrument.priority);
+        if (cell.note != instrument.baseNote)
+        {
+            MixerSetPitch(mixer, voice, powf(2.0f, (cell.note - instrument.baseNote) / 12.0f));
+        }
+    }
+}
+
+internal void AdvanceRow(Sequencer& sequencer)
+{
+    TrackerSong& song = *sequencer.song;
+    if (++sequencer.row >= song.patterns[song.orders[sequencer.order]].rowCount)
+    {
+        sequencer.row = 0;
+        if (++sequencer.order >= song.orderCount)
+        {
+            sequencer.order = 0;
+            sequencer.isPlaying = song.loop;
+        }
+    }
+
+    ++sequencer.rowsPlayed;
+    sequencer.nextRowSample = sequencer.startSample + (uint64_t)llround((double)sequencer.rowsPlayed * sequencer.samplesPerRow);
+}
+
+internal int SequencerSchedule(void* user, Mixer& mixer, uint64_t sampleTime, int maxFrames)
+{
+    Sequencer& sequencer = *(Sequencer*)user;
+    while (sequencer.isPlaying && sampleTime >= sequencer.nextRowSample)
+    {
+        TrackerSong& song = *sequencer.song;
+        int pattern = song.orders[sequencer.order];
+        for (int channel = 0; channel < song.channelCount; ++channel)
+        {
+            TriggerCell(sequencer, mixer, channel, TrackerGetCell(song, pattern, sequencer.row, channel));
+        }
+
+        AdvanceRow(sequencer);
+        if (!sequencer.isPlaying)
+        {
+            StopChannels(sequencer, mixer);
+        }
+    }
+
+    if (!sequencer.isPlaying)
+    {
+        return maxFrames;
+    }
+    uint64_t framesUntilRow = sequencer.nextRowSample - sampleTime;
+    return framesUntilRow < (uint64_t)maxFrames ? (int)framesUntilRow : maxFrames;
+}
+
+void SequencerPlay(Sequencer& sequencer, Mixer& mixer, TrackerSong* song)
+{
+    SequencerStop(sequencer, mixer);
+    ASSERT(song->orderCount > 0 && song->beatsPerMinute > 0.0f && song->rowsPerBeat > 0);
+
+    sequencer.song = song;
+    sequencer.order = 0;
+    sequencer.row = 0;
+    sequencer.samplesPerRow = 60.0 * mixer.samplesPerSecond / ((double)song->beatsPerMinute * song->rowsPerBeat);
+    // Frames of the current block were rendered already, the first row goes on the next unrendered one
+    sequencer.startSample = mixer.sampleClock;
+    sequencer.rowsPlayed = 0;
+    sequencer.nextRowSample = sequencer.startSample;
+    sequencer.isPlaying = true;
+    MixerSetScheduler(mixer, SequencerSchedule, &sequencer);
+}
+
+void SequencerStop(Sequencer& sequencer, Mixer& mixer)
+{
+    if (sequencer.song)
+    {
+        StopChannels(sequencer, mixer);
+    }
+    sequencer.isPlaying = false;
+    if (mixer.scheduler == SequencerSchedule)
+    {
+        MixerSetScheduler(mixer, nullptr, nullptr);
+    }
+}
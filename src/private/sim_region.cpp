@@ -0,0 +1,183 @@
+#include "sim_region.h"
+#include "lane.h"
+
+auto BeginSimRegion(MemoryArena& simArena, World& world, EntityStore& store, WorldPosition origin, v2 halfSize)
+    -> SimRegion*
+{
+    SimRegion* region = PushStruct(simArena, SimRegion);
+    region->origin = CanonicalizePosition(world, origin);
+    region->halfSize = halfSize;
+    WorldPosition minCorner = OffsetPosition(world, region->origin, -halfSize);
+    WorldPosition maxCorner = OffsetPosition(world, region->origin, halfSize);
+
+    // Count first so the columns can be sized exactly, it's just the block headers
+    uint32_t candidateCount = 0;
+    for (int32_t chunkY = minCorner.chunkY; chunkY <= maxCorner.chunkY; ++chunkY)
+    {
+        for (int32_t chunkX = minCorner.chunkX; chunkX <= maxCorner.chunkX; ++chunkX)
+        {
+            TileChunk* chunk = GetTileChunk(world.tileMap, chunkX, chunkY);
+            for (WorldEntityBlock* block = chunk ? chunk->firstEntityBlock : nullptr; block; block = block->next)
+            {
+                candidateCount += block->count;
+            }
+        }
+    }
+
+    uint32_t capacity = (candidateCount + SIM_LANES - 1) & ~(uint32_t)(SIM_LANES - 1);
+    region->capacity = capacity;
+    region->positionX = PushArray(simArena, capacity, float);
+    region->positionY = PushArray(simArena, capacity, float);
+    region->velocityX = PushArray(simArena, capacity, float);
+    region->velocityY = PushArray(simArena, capacity, float);
+    region->radius = PushArray(simArena, capacity, float);
+    region->flags = PushArray(simArena, capacity, uint32_t);
+    region->entitySlots = PushArray(simArena, capacity, uint32_t);
+
+    uint32_t count = 0;
+    for (int32_t chunkY = minCorner.chunkY; chunkY <= maxCorner.chunkY; ++chunkY)
+    {
+        for (int32_t chunkX = minCorner.chunkX; chunkX <= maxCorner.chunkX; ++chunkX)
+        {
+            TileChunk* chunk = GetTileChunk(world.tileMap, chunkX, chunkY);
+            if (!chunk)
+            {
+                continue;
+            }
+
+            // Entities are filed under the chunk they are in, so only their offsets need loading
+            v2 chunkBase = WorldSubtract(world, ChunkOrigin(chunkX, chunkY), region->origin);
+            for (WorldEntityBlock* block = chunk->firstEntityBlock; block; block = block->next)
+            {
+                for (uint32_t i = 0; i < block->count; ++i)
+                {
+                    uint32_t slot = block->entitySlots[i];
+                    uint32_t index = store.slots[slot].denseIndex;
+                    float relativeX = chunkBase.x + store.offsetX[index];
+                    float relativeY = chunkBase.y + store.offsetY[index];
+                    if (fabsf(relativeX) > halfSize.x || fabsf(relativeY) > halfSize.y)
+                    {
+                        continue;
+                    }
+
+                    region->positionX[count] = relativeX;
+                    region->positionY[count] = relativeY;
+                    region->velocityX[count] = store.velocityX[index];
+                    region->velocityY[count] = store.velocityY[index];
+                    region->radius[count] = store.radius[index];
+                    region->flags[count] = store.flags[index];
+                    region->entitySlots[count] = slot;
+                    ++count;
+                }
+            }
+        }
+    }
+    region->count = count;
+
+    // Scratch memory is reused frame to frame, the padding lanes must not pick up stale flags
+    uint32_t paddedCount = (count + SIM_LANES - 1) & ~(uint32_t)(SIM_LANES - 1);
+    for (uint32_t i = count; i < paddedCount; ++i)
+    {
+        region->positionX[i] = region->positionY[i] = 0.0f;
+        region->velocityX[i] = region->velocityY[i] = 0.0f;
+        region->radius[i] = 0.0f;
+        region->flags[i] = 0;
+    }
+    return region;
+}
+
+// origin + relative on one axis, canonicalized the same way CanonicalizeCoord does
+internal inline void ToChunkSpace(lane_f32 relative, int32_t originChunk, float originOffset, float chunkSide,
+                                  lane_u32& chunk, lane_f32& offset)
+{
+    lane_f32 side = LaneF32(chunkSide);
+    offset = relative + LaneF32(originOffset);
+    lane_u32 chunkShift = FloorToI32(offset * LaneF32(1.0f / chunkSide));
+    offset -= ConvertToF32(chunkShift) * side;
+    chunk = LaneU32((uint32_t)originChunk) + chunkShift;
+
+    lane_u32 overflow = offset >= side;
+    offset -= overflow & side;
+    chunk = chunk - overflow;  // true lanes are -1
+    offset = Maximum(offset, LaneF32(0.0f));
+}
+
+void EndSimRegion(SimRegion& region, World& world, EntityStore& store)
+{
+    alignas(16) int32_t chunkX[SIM_LANES];
+    alignas(16) int32_t chunkY[SIM_LANES];
+    alignas(16) float offsetX[SIM_LANES];
+    alignas(16) float offsetY[SIM_LANES];
+    for (uint32_t base = 0; base < region.count; base += SIM_LANES)
+    {
+        lane_u32 chunkLanes;
+        lane_f32 offsetLanes;
+        ToChunkSpace(LoadF32(region.positionX + base), region.origin.chunkX, region.origin.offset.x,
+                     world.chunkSideInMeters, chunkLanes, offsetLanes);
+        Store((uint32_t*)chunkX, chunkLanes);
+        Store(offsetX, offsetLanes);
+        ToChunkSpace(LoadF32(region.positionY + base), region.origin.chunkY, region.origin.offset.y,
+                     world.chunkSideInMeters, chunkLanes, offsetLanes);
+        Store((uint32_t*)chunkY, chunkLanes);
+        Store(offsetY, offsetLanes);
+
+        uint32_t laneCount = region.count - base < SIM_LANES ? region.count - base : SIM_LANES;
+        for (uint32_t lane = 0; lane < laneCount; ++lane)
+        {
+            uint32_t i = base + lane;
+            uint32_t slot = region.entitySlots[i];
+            uint32_t index = store.slots[slot].denseIndex;
+            if (store.chunkX[index] != chunkX[lane] || store.chunkY[index] != chunkY[lane])
+            {
+                ChangeEntityChunk(world, slot, GetEntityPosition(store, index), ChunkOrigin(chunkX[lane], chunkY[lane]));
+                store.chunkX[index] = chunkX[lane];
+                store.chunkY[index] = chunkY[lane];
+            }
+            store.offsetX[index] = offsetX[lane];
+            store.offsetY[index] = offsetY[lane];
+            store.velocityX[index] = region.velocityX[i];
+            store.velocityY[index] = region.velocityY[i];
+            store.flags[index] = region.flags[i];
+        }
+    }
+}
+
+void MoveSimEntities(SimRegion& region, float seconds)
+{
+    lane_f32 dt = LaneF32(seconds);
+    for (uint32_t i = 0; i < region.count; i += SIM_LANES)
+    {
+        lane_f32 stepScale = HasFlags(LoadU32(region.flags + i), EntityFlag_Moving) & dt;
+        lane_f32 positionX = LoadF32(region.positionX + i);
+        lane_f32 positionY = LoadF32(region.positionY + i);
+        positionX += LoadF32(region.velocityX + i) * stepScale;
+        positionY += LoadF32(region.velocityY + i) * stepScale;
+        Store(region.positionX + i, positionX);
+        Store(region.positionY + i, positionY);
+    }
+}
+
+// Flips the sign of the lanes that are past either edge and still heading further out
+internal inline lane_f32 ConfineAxis(lane_f32 position, lane_f32 velocity, lane_u32 confined, float minEdge, float maxEdge)
+{
+    lane_f32 zero = LaneF32(0.0f);
+    lane_u32 belowMin = (position < LaneF32(minEdge)) & (velocity < zero);
+    lane_u32 aboveMax = (position > LaneF32(maxEdge)) & (velocity > zero);
+    lane_u32 flip = (belowMin | aboveMax) & confined;
+    ConditionalAssign(velocity, flip, -velocity);
+    return velocity;
+}
+
+void ConfineSimEntities(SimRegion& region, v2 minCorner, v2 maxCorner)
+{
+    for (uint32_t i = 0; i < region.count; i += SIM_LANES)
+    {
+        lane_u32 confined = HasFlags(LoadU32(region.flags + i), EntityFlag_Confined);
+        lane_f32 velocityX = ConfineAxis(LoadF32(region.positionX + i), LoadF32(region.velocityX + i),
+                                         confined, minCorner.x, maxCorner.x);
+        lane_f32 velocityY = ConfineAxis(LoadF32(region.positionY + i), LoadF32(region.velocityY + i),
+                                         confined, minCorner.y, maxCorner.y);
+        Store(region.velocityX + i, velocityX);
+        Store(region.velocityY + i, velocityY);
+    }
+}
@@ -0,0 +1,120 @@
+#include "tile_map.h"
+#include <string.h>
+
+internal inline uint32_t HashChunk(int32_t chunkX, int32_t chunkY)
+{
+    uint32_t hash = (uint32_t)chunkX * 0x9E3779B1u ^ (uint32_t)chunkY * 0x85EBCA77u;
+    hash ^= hash >> 15;
+    hash *= 0x2C1B3C6Du;
+    return hash ^ (hash >> 13);
+}
+
+internal auto AllocateSlots(MemoryArena& arena, uint32_t slotCount) -> TileChunkSlot*
+{
+    TileChunkSlot* slots = PushArray(arena, slotCount, TileChunkSlot);
+    memset(slots, 0, slotCount * sizeof(TileChunkSlot));
+    return slots;
+}
+
+// Finds the slot holding the chunk, or the empty slot where it would go
+internal auto FindSlot(TileChunkSlot* slots, uint32_t slotCount, int32_t chunkX, int32_t chunkY) -> TileChunkSlot*
+{
+    uint32_t mask = slotCount - 1;
+    for (uint32_t index = HashChunk(chunkX, chunkY) & mask;; index = (index + 1) & mask)
+    {
+        TileChunkSlot* slot = slots + index;
+        if (!slot->chunk || (slot->chunkX == chunkX && slot->chunkY == chunkY))
+        {
+            return slot;
+        }
+    }
+}
+
+internal void GrowTable(TileMap& tileMap)
+{
+    uint32_t slotCount = tileMap.slotCount * 2;
+    TileChunkSlot* slots = AllocateSlots(*tileMap.arena, slotCount);
+    for (uint32_t i = 0; i < tileMap.slotCount; ++i)
+    {
+        TileChunkSlot& old = tileMap.slots[i];
+        if (old.chunk)
+        {
+            *FindSlot(slots, slotCount, old.chunkX, old.chunkY) = old;
+        }
+    }
+    tileMap.slots = slots;
+    tileMap.slotCount = slotCount;
+}
+
+void InitializeTileMap(TileMap& tileMap, MemoryArena& arena, float tileSideInMeters)
+{
+    tileMap.arena = &arena;
+    tileMap.tileSideInMeters = tileSideInMeters;
+    tileMap.slotCount = TILE_CHUNK_HASH_INITIAL;
+    tileMap.slots = AllocateSlots(arena, tileMap.slotCount);
+    tileMap.chunkCount = 0;
+}
+
+auto GetTileChunk(TileMap& tileMap, int32_t chunkX, int32_t chunkY) -> TileChunk*
+{
+    return FindSlot(tileMap.slots, tileMap.slotCount, chunkX, chunkY)->chunk;
+}
+
+auto GetOrCreateTileChunk(TileMap& tileMap, int32_t chunkX, int32_t chunkY) -> TileChunk*
+{
+    TileChunkSlot* slot = FindSlot(tileMap.slots, tileMap.slotCount, chunkX, chunkY);
+    if (slot->chunk)
+    {
+        return slot->chunk;
+    }
+
+    // Keep probe runs short, grow before the new chunk would push us past 3/4
+    if ((tileMap.chunkCount + 1) * 4 > tileMap.slotCount * 3)
+    {
+        GrowTable(tileMap);
+        slot = FindSlot(tileMap.slots, tileMap.slotCount, chunkX, chunkY);
+    }
+
+    TileChunk* chunk = PushStruct(*tileMap.arena, TileChunk);
+    chunk->chunkX = chunkX;
+    chunk->chunkY = chunkY;
+    chunk->state = TileChunkState_Blank;
+    memset(chunk->tiles, TileValue_Empty, sizeof(chunk->tiles));
+    chunk->firstEntityBlock = nullptr;
+
+    slot->chunkX = chunkX;
+    slot->chunkY = chunkY;
+    slot->chunk = chunk;
+    ++tileMap.chunkCount;
+    return chunk;
+}
+
+auto GetReadableTileChunk(TileMap& tileMap, int32_t chunkX, int32_t chunkY) -> TileChunk*
+{
+    TileChunk* chunk = GetTileChunk(tileMap, chunkX, chunkY);
+    if (!chunk || chunk->state == TileChunkState_Generating)
+    {
+        return nullptr;
+    }
+    // The tiles can't be read ahead of the state that says they are done
+    _ReadWriteBarrier();
+    return chunk;
+}
+
+auto GetTileValue(TileMap& tileMap, int32_t absTileX, int32_t absTileY) -> uint8_t
+{
+    TileChunk* chunk = GetReadableTileChunk(tileMap, TileToChunk(absTileX), TileToChunk(absTileY));
+    if (!chunk)
+    {
+        return TileValue_Empty;
+    }
+    return chunk->tiles[(absTileY & TILE_CHUNK_MASK) * TILE_CHUNK_DIM + (absTileX & TILE_CHUNK_MASK)];
+}
+
+void SetTileValue(TileMap& tileMap, int32_t absTileX, int32_t absTileY, uint8_t value)
+{
+    TileChunk* chunk = GetOrCreateTileChunk(tileMap, TileToChunk(absTileX), TileToChunk(absTileY));
+    ASSERT(chunk->state != TileChunkState_Generating);
+    chunk->state = TileChunkState_Ready;
+    chunk->tiles[(absTileY & TILE_CHUNK_MASK) * TILE_CHUNK_DIM + (absTileX & TILE_CHUNK_MASK)] = value;
+}
@@ -0,0 +1,85 @@
+#include "wav.h"
+
+#pragma pack(push, 1)
+struct WavHeader
+{
+    char riffId[4];
+    uint32_t riffSize;
+    char waveId[4];
+
+    char fmtId[4];
+    uint32_t fmtSize;
+    uint16_t formatTag;
+    uint16_t channels;
+    uint32_t samplesPerSecond;
+    uint32_t bytesPerSecond;
+    uint16_t blockAlign;
+    uint16_t bitsPerSample;
+
+    char dataId[4];
+    uint32_t dataSize;
+};
+#pragma pack(pop)
+
+internal void WriteHeader(WavWriter& writer)
+{
+    uint16_t blockAlign = (uint16_t)(writer.channels * writer.bitsPerSample / 8);
+
+    WavHeader header = {
+        {'R','I','F','F'}, (uint32_t)(sizeof(WavHeader) - 8 + writer.dataBytes), {'W','A','V','E'},
+        {'f','m','t',' '}, 16,
+        (uint16_t)(writer.bitsPerSample == 32 ? 3 : 1), // 3 = IEEE float, 1 = PCM
+        (uint16_t)writer.channels,
+        (uint32_t)writer.samplesPerSecond,
+        (uint32_t)writer.samplesPerSecond * blockAlign,
+        blockAlign,
+        (uint16_t)writer.bitsPerSample,
+        {'d','a','t','a'}, writer.dataBytes
+    };
+
+    DWORD written;
+    SetFilePointer(writer.file, 0, nullptr, FILE_BEGIN);
+    WriteFile(writer.file, &header, sizeof(header), &written, nullptr);
+}
+
+auto WavOpen(WavWriter& writer, const char* path, int samplesPerSecond, int channels, int bitsPerSample) -> bool
+{
+    writer.file = CreateFileA(path, GENERIC_WRITE, 0, nullptr, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (writer.file == INVALID_HANDLE_VALUE)
+    {
+        OutputDebugStringA("Failed to create wav file\n");
+        return false;
+    }
+
+    writer.samplesPerSecond = samplesPerSecond;
+    writer.channels = channels;
+    writer.bitsPerSample = bitsPerSample;
+    writer.dataBytes = 0;
+    WriteHeader(writer);
+    return true;
+}
+
+void WavWrite(WavWriter& writer, const void* data, uint32_t bytes)
+{
+    if (writer.file == INVALID_HANDLE_VALUE || bytes == 0)
+    {
+        return;
+    }
+
+    DWORD written = 0;
+    WriteFile(writer.file, data, bytes, &written, nullptr);
+    writer.dataBytes += written;
+}
+
+void WavClose(WavWriter& writer)
+{
+    if (writer.file == INVALID_HANDLE_VALUE)
+    {
+        return;
+    }
+
+    // Patch the sizes now that the data length is known
+    WriteHeader(writer);
+    CloseHandle(writer.file);
+    writer.file = INVALID_HANDLE_VALUE;
+}
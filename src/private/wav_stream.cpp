@@ -0,0 +1,181 @@
+#include "wav_stream.h"
+#include <string.h>
+
+// The largest frame we support is 32-bit float stereo
+#define WAV_STREAM_MAX_FRAME_BYTES 8
+
+// Maps the window containing byteOffset and returns a pointer to that byte
+internal uint8_t* MapWindow(WavStream& stream, uint64_t byteOffset)
+{
+    uint64_t granularity = PlatformGetMapGranularity();
+    uint64_t windowOffset = byteOffset - (byteOffset % granularity);
+
+    if (!stream.view || windowOffset != stream.viewOffset)
+    {
+        PlatformUnmapView(stream.view);
+        // A frame that starts in this granule may end in the next one, so map a little slack
+        stream.view = (uint8_t*)PlatformMapView(stream.file, windowOffset, (uint32_t)granularity + WAV_STREAM_MAX_FRAME_BYTES);
+        stream.viewOffset = windowOffset;
+        stream.viewSize = stream.view ? (uint32_t)granularity : 0;
+        if (!stream.view)
+        {
+            return nullptr;
+        }
+    }
+    return stream.view + (byteOffset - windowOffset);
+}
+
+internal bool ReadBytes(WavStream& stream, uint64_t offset, void* dest, uint32_t size)
+{
+    if (offset + size > stream.file.size)
+    {
+        return false;
+    }
+
+    uint8_t* out = (uint8_t*)dest;
+    while (size > 0)
+    {
+        uint8_t* at = MapWindow(stream, offset);
+        if (!at)
+        {
+            return false;
+        }
+        uint32_t available = (uint32_t)(stream.viewOffset + stream.viewSize - offset);
+        uint32_t count = size < available ? size : available;
+        memcpy(out, at, count);
+        out += count;
+        offset += count;
+        size -= count;
+    }
+    return true;
+}
+
+auto WavStreamOpen(WavStream& stream, const char* path) -> bool
+{
+    stream = {};
+    if (!PlatformOpenMappedFile(path, stream.file))
+    {
+        return false;
+    }
+
+    char riff[12];
+    if (!ReadBytes(stream, 0, riff, sizeof(riff)) || memcmp(riff, "RIFF", 4) != 0 || memcmp(riff + 8, "WAVE", 4) != 0)
+    {
+        WavStreamClose(stream);
+        return false;
+    }
+
+    bool haveFormat = false;
+    bool haveData = false;
+    uint64_t offset = 12;
+    while (!haveData && offset + 8 <= stream.file.size)
+    {
+        char chunkId[4];
+        uint32_t chunkSize;
+        ReadBytes(stream, offset, chunkId, 4);
+        ReadBytes(stream, offset + 4, &chunkSize, 4);
+        uint64_t chunkData = offset + 8;
+
+        if (memcmp(chunkId, "fmt ", 4) == 0 && chunkSize >= 16)
+        {
+            uint16_t format[8];
+            ReadBytes(stream, chunkData, format, 16);
+            uint16_t formatTag = format[0];
+            // WAVE_FORMAT_EXTENSIBLE keeps the real format in the sub format guid
+            if (formatTag == 0xFFFE && chunkSize >= 26)
+            {
+                ReadBytes(stream, chunkData + 24, &formatTag, 2);
+            }
+
+            stream.channels = format[1];
+            stream.samplesPerSecond = (int)(format[2] | ((uint32_t)format[3] << 16));
+            stream.bitsPerSample = format[7];
+            stream.isFloat = formatTag == 3;
+            haveFormat = (formatTag == 1 && stream.bitsPerSample == 16) ||
+                         (formatTag == 3 && stream.bitsPerSample == 32);
+            haveFormat = haveFormat && (stream.channels == 1 || stream.channels == 2);
+        }
+        else if (memcmp(chunkId, "data", 4) == 0 && haveFormat)
+        {
+            stream.bytesPerFrame = stream.channels * stream.bitsPerSample / 8;
+            stream.dataOffset = chunkData;
+            uint64_t dataSize = chunkSize;
+            if (chunkData + dataSize > stream.file.size)
+            {
+                dataSize = stream.file.size - chunkData;
+            }
+            stream.frameCount = dataSize / stream.bytesPerFrame;
+            haveData = true;
+        }
+
+        // Chunks are padded to even sizes
+        offset = chunkData + chunkSize + (chunkSize & 1);
+    }
+
+    if (!haveData)
+    {
+        OutputDebugStringA("Unsupported or malformed wav file\n");
+        WavStreamClose(stream);
+        return false;
+    }
+    return true;
+}
+
+void WavStreamClose(WavStream& stream)
+{
+    PlatformUnmapView(stream.view);
+    PlatformCloseMappedFile(stream.file);
+    stream = {};
+}
+
+int WavStreamMix(WavStream& stream, uint64_t& framePosition, float* left, float* right, int frameCount, float volume)
+{
+    int framesMixed = 0;
+    while (framesMixed < frameCount && framePosition < stream.frameCount)
+    {
+        uint64_t byteOffset = stream.dataOffset + framePosition * stream.bytesPerFrame;
+        uint8_t* at = MapWindow(stream, byteOffset);
+        if (!at)
+        {
+            break;
+        }
+
+        // Every frame that starts inside the window is fully mapped thanks to the slack
+        uint64_t windowEnd = stream.viewOffset + stream.viewSize;
+        uint64_t framesInWindow = (windowEnd - byteOffset + stream.bytesPerFrame - 1) / stream.bytesPerFrame;
+        uint64_t framesLeft = stream.frameCount - framePosition;
+        int count = frameCount - framesMixed;
+        if ((uint64_t)count > framesInWindow) count = (int)framesInWindow;
+        if ((uint64_t)count > framesLeft) count = (int)framesLeft;
+
+        float* outLeft = left + framesMixed;
+        float* outRight = right + framesMixed;
+        if (stream.isFloat)
+        {
+            float* in = (float*)at;
+            for (int i = 0; i < count; ++i)
+            {
+                float l = *in++;
+                float r = stream.channels == 2 ? *in++ : l;
+                outLeft[i] += l * volume;
+                outRight[i] += r * volume;
+            }
+        }
+        else
+        {
+            float scale = volume * (1.0f / 32768.0f);
+            int16_t* in = (int16_t*)at;
+            for (int i = 0; i < count; ++i)
+            {
+                float l = (float)*in++;
+                float r = stream.channels == 2 ? (float)*in++ : l;
+                outLeft[i] += l * scale;
+                outRight[i] += r * scale;
+            }
+        }
+
+        framesMixed += count;
+        framePosition += count;
+    }
+    return framesMixed;
+}
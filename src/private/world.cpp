@@ -0,0 +1,132 @@
+#include "world.h"
+
+void InitializeWorld(World& world, MemoryArena& arena, float tileSideInMeters)
+{
+    world.tileSideInMeters = tileSideInMeters;
+    world.chunkSideInMeters = tileSideInMeters * TILE_CHUNK_DIM;
+    world.firstFreeEntityBlock = nullptr;
+    InitializeTileMap(world.tileMap, arena, tileSideInMeters);
+}
+
+internal void CanonicalizeCoord(float chunkSide, int32_t& chunk, float& offset)
+{
+    // floorf so negative offsets move to the chunk below
+    int32_t chunkShift = (int32_t)floorf(offset / chunkSide);
+    chunk += chunkShift;
+    offset -= (float)chunkShift * chunkSide;
+
+    // Rounding can leave a value that is still chunkSide, or a hair under 0, fold those over
+    if (offset >= chunkSide)
+    {
+        offset -= chunkSide;
+        ++chunk;
+    }
+    if (offset < 0.0f)
+    {
+        offset = 0.0f;
+    }
+}
+
+auto CanonicalizePosition(const World& world, WorldPosition position) -> WorldPosition
+{
+    CanonicalizeCoord(world.chunkSideInMeters, position.chunkX, position.offset.x);
+    CanonicalizeCoord(world.chunkSideInMeters, position.chunkY, position.offset.y);
+    return position;
+}
+
+auto OffsetPosition(const World& world, WorldPosition position, v2 offset) -> WorldPosition
+{
+    position.offset += offset;
+    return CanonicalizePosition(world, position);
+}
+
+auto WorldSubtract(const World& world, WorldPosition a, WorldPosition b) -> v2
+{
+    // The chunk difference is an exact int, only the final meters go to float
+    v2 chunkDelta = V2((float)((int64_t)a.chunkX - b.chunkX), (float)((int64_t)a.chunkY - b.chunkY));
+    return world.chunkSideInMeters * chunkDelta + (a.offset - b.offset);
+}
+
+auto PositionFromTile(const World& world, int32_t absTileX, int32_t absTileY) -> WorldPosition
+{
+    WorldPosition position;
+    position.chunkX = TileToChunk(absTileX);
+    position.chunkY = TileToChunk(absTileY);
+    position.offset = world.tileSideInMeters * V2((float)(absTileX & TILE_CHUNK_MASK) + 0.5f,
+                                                  (float)(absTileY & TILE_CHUNK_MASK) + 0.5f);
+    return position;
+}
+
+void TileFromPosition(const World& world, WorldPosition position, int32_t& absTileX, int32_t& absTileY)
+{
+    int32_t tileX = (int32_t)(position.offset.x / world.tileSideInMeters);
+    int32_t tileY = (int32_t)(position.offset.y / world.tileSideInMeters);
+    tileX = tileX > TILE_CHUNK_MASK ? TILE_CHUNK_MASK : tileX;
+    tileY = tileY > TILE_CHUNK_MASK ? TILE_CHUNK_MASK : tileY;
+    absTileX = position.chunkX * TILE_CHUNK_DIM + tileX;
+    absTileY = position.chunkY * TILE_CHUNK_DIM + tileY;
+}
+
+void AddEntityToChunk(World& world, int32_t chunkX, int32_t chunkY, uint32_t entitySlot)
+{
+    TileChunk* chunk = GetOrCreateTileChunk(world.tileMap, chunkX, chunkY);
+    WorldEntityBlock* block = chunk->firstEntityBlock;
+    if (!block || block->count == WORLD_ENTITY_BLOCK_COUNT)
+    {
+        // Only the first block is ever partly filled, a new one goes in front
+        WorldEntityBlock* newBlock = world.firstFreeEntityBlock;
+        if (newBlock)
+        {
+            world.firstFreeEntityBlock = newBlock->next;
+        }
+        else
+        {
+            newBlock = PushStruct(*world.tileMap.arena, WorldEntityBlock);
+        }
+        newBlock->count = 0;
+        newBlock->next = block;
+        chunk->firstEntityBlock = newBlock;
+        block = newBlock;
+    }
+    block->entitySlots[block->count++] = entitySlot;
+}
+
+void RemoveEntityFromChunk(World& world, int32_t chunkX, int32_t chunkY, uint32_t entitySlot)
+{
+    TileChunk* chunk = GetTileChunk(world.tileMap, chunkX, chunkY);
+    if (!chunk)
+    {
+        return;
+    }
+
+    WorldEntityBlock* first = chunk->firstEntityBlock;
+    for (WorldEntityBlock* block = first; block; block = block->next)
+    {
+        for (uint32_t i = 0; i < block->count; ++i)
+        {
+            if (block->entitySlots[i] != entitySlot)
+            {
+                continue;
+            }
+
+            // Fill the hole from the first block so the others stay full
+            block->entitySlots[i] = first->entitySlots[--first->count];
+            if (first->count == 0)
+            {
+                chunk->firstEntityBlock = first->next;
+                first->next = world.firstFreeEntityBlock;
+                world.firstFreeEntityBlock = first;
+            }
+            return;
+        }
+    }
+}
+
+void ChangeEntityChunk(World& world, uint32_t entitySlot, WorldPosition from, WorldPosition to)
+{
+    if (from.chunkX != to.chunkX || from.chunkY != to.chunkY)
+    {
+        RemoveEntityFromChunk(world, from.chunkX, from.chunkY, entitySlot);
+        AddEntityToChunk(world, to.chunkX, to.chunkY, entitySlot);
+    }
+}
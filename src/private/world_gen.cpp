@@ -0,0 +1,195 @@
+#include "world_gen.h"
+#include "simd.h"
+#include "random.h"
+
+#define WORLD_GEN_OCTAVES 4
+#define WORLD_GEN_LARGEST_CELL_SHIFT 6     // the first octave's lattice is 64 tiles across, each next one half
+#define WORLD_GEN_WATER_LEVEL 0.36f
+#define WORLD_GEN_ROCK_LEVEL 0.64f
+#define WORLD_GEN_BOULDER_TRIES 8          // per chunk, about half land on open floor
+#define WORLD_GEN_LATTICE_DIM (((TILE_CHUNK_DIM - 1) >> (WORLD_GEN_LARGEST_CELL_SHIFT - WORLD_GEN_OCTAVES + 1)) + 2)
+
+void InitializeWorldGenerator(WorldGenerator& generator, uint32_t seed, PlatformWorkQueue* queue)
+{
+    generator.seed = seed;
+    generator.queue = queue;
+    generator.jobsInFlight = 0;
+    generator.chunksGenerated = 0;
+    for (uint32_t i = 0; i < WORLD_GEN_MAX_JOBS; ++i)
+    {
+        generator.jobs[i] = {};
+    }
+}
+
+#pragma region Noise
+
+internal inline uint32_t HashLattice(uint32_t seed, int32_t x, int32_t y)
+{
+    uint32_t hash = seed ^ (uint32_t)x * 0x27D4EB2Du ^ (uint32_t)y * 0x165667B1u;
+    hash ^= hash >> 15;
+    hash *= 0x2C1B3C6Du;
+    hash ^= hash >> 12;
+    hash *= 0x297A2D39u;
+    return hash ^ (hash >> 15);
+}
+
+// Value noise for every tile of a chunk at one lattice size. The lattice points the chunk
+// touches are hashed once, tiles only blend them, and all of it is integer exact so far
+// out chunks get the same quality as the ones near the origin.
+internal void AddValueNoise(uint32_t seed, int32_t chunkX, int32_t chunkY, int32_t cellShift, float amplitude,
+                            float* values)
+{
+    int32_t minTileX = chunkX * TILE_CHUNK_DIM;
+    int32_t minTileY = chunkY * TILE_CHUNK_DIM;
+    int32_t minCellX = minTileX >> cellShift;
+    int32_t minCellY = minTileY >> cellShift;
+    int32_t cellMask = (1 << cellShift) - 1;
+    float cellScale = 1.0f / (float)(1 << cellShift);
+
+    float lattice[WORLD_GEN_LATTICE_DIM][WORLD_GEN_LATTICE_DIM];
+    int32_t latticeDim = ((TILE_CHUNK_DIM - 1) >> cellShift) + 2;
+    for (int32_t y = 0; y < latticeDim; ++y)
+    {
+        for (int32_t x = 0; x < latticeDim; ++x)
+        {
+            uint32_t hash = HashLattice(seed, minCellX + x, minCellY + y);
+            lattice[y][x] = (float)(hash >> 8) * (1.0f / 16777216.0f);
+        }
+    }
+
+    for (int32_t y = 0; y < TILE_CHUNK_DIM; ++y)
+    {
+        int32_t tileY = minTileY + y;
+        int32_t cellY = (tileY >> cellShift) - minCellY;
+        float fractionY = (float)(tileY & cellMask) * cellScale;
+        float weightY = fractionY * fractionY * (3.0f - 2.0f * fractionY);
+        for (int32_t x = 0; x < TILE_CHUNK_DIM; ++x)
+        {
+            int32_t tileX = minTileX + x;
+            int32_t cellX = (tileX >> cellShift) - minCellX;
+            float fractionX = (float)(tileX & cellMask) * cellScale;
+            float weightX = fractionX * fractionX * (3.0f - 2.0f * fractionX);
+
+            float bottom = Lerp(lattice[cellY][cellX], weightX, lattice[cellY][cellX + 1]);
+            float top = Lerp(lattice[cellY + 1][cellX], weightX, lattice[cellY + 1][cellX + 1]);
+            values[y * TILE_CHUNK_DIM + x] += amplitude * Lerp(bottom, weightY, top);
+        }
+    }
+}
+
+#pragma endregion Noise
+
+void GenerateChunkTiles(uint32_t seed, int32_t chunkX, int32_t chunkY, uint8_t* tiles)
+{
+    // Octaves halve in size and weight, normalized back to [0, 1)
+    float elevation[TILE_CHUNK_DIM * TILE_CHUNK_DIM] = {};
+    float amplitude = 1.0f;
+    float totalAmplitude = 0.0f;
+    for (int32_t octave = 0; octave < WORLD_GEN_OCTAVES; ++octave)
+    {
+        AddValueNoise(seed + (uint32_t)octave * 0x9E3779B9u, chunkX, chunkY, WORLD_GEN_LARGEST_CELL_SHIFT - octave,
+                      amplitude, elevation);
+        totalAmplitude += amplitude;
+        amplitude *= 0.5f;
+    }
+
+    for (uint32_t i = 0; i < TILE_CHUNK_DIM * TILE_CHUNK_DIM; ++i)
+    {
+        float height = elevation[i] / totalAmplitude;
+        tiles[i] = height < WORLD_GEN_WATER_LEVEL ? TileValue_Water
+                 : height > WORLD_GEN_ROCK_LEVEL  ? TileValue_Wall
+                                                  : TileValue_Floor;
+    }
+
+    // Boulders only go on open floor. The chunk's own series picks the tile and whether this try places one.
+    uint64_t chunkIndex = (uint64_t)(uint32_t)chunkY << 32 | (uint32_t)chunkX;
+    RandomSeries series = RandomSeed(seed, RandomStream_WorldGen, chunkIndex);
+    for (uint32_t i = 0; i < WORLD_GEN_BOULDER_TRIES; ++i)
+    {
+        uint32_t bits = RandomNext(series);
+        uint32_t tile = bits & (TILE_CHUNK_DIM * TILE_CHUNK_DIM - 1);
+        if (bits >> 31 && tiles[tile] == TileValue_Floor)
+        {
+            tiles[tile] = TileValue_Wall;
+        }
+    }
+}
+
+#pragma region Jobs
+
+internal void GenerateChunkJob(void* data)
+{
+    WorldGenJob* job = (WorldGenJob*)data;
+    WorldGenerator* generator = job->generator;
+    TileChunk* chunk = job->chunk;
+    GenerateChunkTiles(generator->seed, chunk->chunkX, chunk->chunkY, chunk->tiles);
+
+    // Full barrier, the tiles are out before any reader can see Ready
+    InterlockedExchange(&chunk->state, TileChunkState_Ready);
+    InterlockedExchange(&job->isBusy, 0);
+    InterlockedDecrement(&generator->jobsInFlight);
+}
+
+internal auto FindFreeJob(WorldGenerator& generator) -> WorldGenJob*
+{
+    for (uint32_t i = 0; i < WORLD_GEN_MAX_JOBS; ++i)
+    {
+        if (!generator.jobs[i].isBusy)
+        {
+            return &generator.jobs[i];
+        }
+    }
+    return nullptr;
+}
+
+// Square rings outwards from the center, so what is nearest the camera is queued first
+auto GenerateChunksAround(WorldGenerator& generator, World& world, int32_t centerChunkX, int32_t centerChunkY,
+                          int32_t radius) -> uint32_t
+{
+    uint32_t queued = 0;
+    for (int32_t ring = 0; ring <= radius; ++ring)
+    {
+        for (int32_t y = -ring; y <= ring; ++y)
+        {
+            bool isEdgeRow = y == -ring || y == ring;
+            // Only the two ends of the rows in between are on the ring
+            for (int32_t x = -ring; x <= ring; x += isEdgeRow ? 1 : 2 * ring)
+            {
+                int32_t chunkX = centerChunkX + x;
+                int32_t chunkY = centerChunkY + y;
+                TileChunk* chunk = GetTileChunk(world.tileMap, chunkX, chunkY);
+                if (chunk && chunk->state != TileChunkState_Blank)
+                {
+                    continue;
+                }
+
+                WorldGenJob* job = FindFreeJob(generator);
+                if (!job)
+                {
+                    return queued;
+                }
+
+                chunk = GetOrCreateTileChunk(world.tileMap, chunkX, chunkY);
+                chunk->state = TileChunkState_Generating;
+                job->generator = &generator;
+                job->chunk = chunk;
+                job->isBusy = 1;
+                InterlockedIncrement(&generator.jobsInFlight);
+                PlatformAddWorkEntry(generator.queue, GenerateChunkJob, job);
+                ++generator.chunksGenerated;
+                ++queued;
+            }
+        }
+    }
+    return queued;
+}
+
+void WaitForWorldGenerator(WorldGenerator& generator)
+{
+    while (generator.jobsInFlight)
+    {
+        _mm_pause();
+    }
+}
+
+#pragma endregion Jobs
@@ -0,0 +1,65 @@
+#pragma once
+#include "memory.h"
+
+/*
+    NOTE: IMA style 4:1 ADPCM for in-memory sound banks.
+
+    Block layout, channels stored one after the other (planar) so each channel is
+    an independent decode chain:
+        per channel: int16 first sample, uint8 step index, uint8 pad,
+                     (ADPCM_BLOCK_FRAMES - 1) / 2 bytes of nibbles, low nibble first
+    The step table and the index adjustment are fused into one 89x16 table so a
+    sample costs two loads and an add. The AVX2 decoder runs 8 channel-blocks side
+    by side with gathers, the fallback interleaves the chains so they overlap.
+
+    The encoder tries all 16 codes per sample against the same tables the decoder
+    uses, so the reconstruction is bit exact.
+*/
+
+#define ADPCM_BLOCK_FRAMES 257
+#define ADPCM_CHANNEL_BYTES (4 + (ADPCM_BLOCK_FRAMES - 1) / 2)
+#define ADPCM_DECODE_LANES 8
+
+#pragma pack(push, 1)
+struct AdpcmFileHeader
+{
+    char magic[4];          // "ADPC"
+    uint32_t version;
+    uint32_t samplesPerSecond;
+    uint16_t channels;
+    uint16_t blockFrames;
+    uint32_t frameCount;
+    uint32_t blockCount;
+};
+#pragma pack(pop)
+
+struct AdpcmSound
+{
+    int samplesPerSecond;
+    int channels;
+    uint32_t frameCount;
+    uint32_t blockCount;
+    uint32_t blockBytes;    // channels * ADPCM_CHANNEL_BYTES
+    uint8_t* blocks;
+};
+
+//Decoded blocks for one voice, ADPCM_DECODE_LANES / channels blocks at a time
+struct AdpcmDecoder
+{
+    float* left;            // ADPCM_DECODE_LANES * ADPCM_BLOCK_FRAMES each
+    float* right;
+    uint32_t firstFrame;    // sound frame held at index 0
+    uint32_t frameCount;    // valid frames in the cache
+};
+
+auto AdpcmEncodedSize(int channels, uint32_t frameCount) -> size_t;
+//Planar int16 input, writes blockCount blocks into out
+auto AdpcmEncode(const int16_t* left, const int16_t* right, int channels, uint32_t frameCount, uint8_t* out) -> uint32_t;
+
+//Copies an .adp image (header + blocks) into the arena
+auto AdpcmLoad(AdpcmSound& sound, MemoryArena& arena, const void* file, size_t fileSize) -> bool;
+
+void AdpcmDecoderInitialize(AdpcmDecoder& decoder, MemoryArena& arena);
+//Adds up to frameCount frames from framePosition into out, returns frames produced
+int AdpcmMix(const AdpcmSound& sound, AdpcmDecoder& decoder, uint32_t& framePosition,
+             float* left, float* right, int frameCount, float volume);
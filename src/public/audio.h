@@ -0,0 +1,147 @@
+#pragma once
+#include "globals.h"
+#include "game.h"
+
+/*
+    NOTE: Platform audio device.
+    Every backend exposes the looping ring buffer model DirectSound uses: query the
+    play/write cursors, lock a byte range (which may wrap into two regions), fill it,
+    unlock. The cursor math deciding what to write next lives here once and is shared
+    by every backend.
+
+    Backends:
+        Null        - discards samples, cursors advance with the wall clock (benchmarks)
+        WavFile     - same clock as Null, appends everything written to a WAV file
+        DirectSound - Windows
+*/
+
+enum class AudioBackend
+{
+    Null,
+    WavFile,
+    DirectSound,
+};
+
+struct AudioRegions
+{
+    void* region1 = nullptr;
+    uint32_t region1Size = 0;
+    void* region2 = nullptr;
+    uint32_t region2Size = 0;
+};
+
+struct AudioDevice;
+
+struct AudioDeviceApi
+{
+    bool (*getCursors)(AudioDevice& device, uint32_t& playCursor, uint32_t& writeCursor);
+    bool (*lock)(AudioDevice& device, uint32_t byteToLock, uint32_t bytesToLock, AudioRegions& regions);
+    void (*unlock)(AudioDevice& device, AudioRegions& regions);
+    bool (*play)(AudioDevice& device);
+    void (*close)(AudioDevice& device);
+};
+
+struct AudioDevice
+{
+    AudioBackend backend = AudioBackend::Null;
+    const AudioDeviceApi* api = nullptr;
+    void* backendData = nullptr;
+
+    int samplesPerSecond = 0;
+    int channels = 2;
+    int bytesPerSample = sizeof(int16_t) * 2; // one stereo frame
+    uint32_t bufferSize = 0;                  // ring size in bytes
+
+    uint32_t runningSampleIndex = 0;          // next sample we are going to write
+    bool isPlaying = false;
+};
+
+struct AudioWriteRange
+{
+    uint32_t byteToLock = 0;
+    uint32_t bytesToWrite = 0;
+};
+
+/*
+    NOTE: Latency calibration.
+    Cards move the play cursor in coarse steps and our frames don't land at exact
+    intervals, so instead of a fixed write-ahead we measure both: AudioCalibrate polls
+    the cursors for a short while at startup, and every frame reports its duration.
+    The safety margin is the cursor granularity plus 3 sigma of frame time jitter,
+    and writes are aimed at the frame flip after next when the card is fast enough.
+*/
+struct AudioCalibration
+{
+    bool isCalibrated = false;
+    bool isSynced = false;                 // runningSampleIndex has been snapped to the write cursor
+
+    uint32_t cursorGranularityBytes = 0;   // largest single play cursor step observed
+    uint32_t writeCursorGapBytes = 0;      // how far the write cursor runs ahead of the play cursor
+
+    float targetSecondsPerFrame = 0.0f;
+    int frameCount = 0;
+    double frameMean = 0.0;                // running mean/variance of frame time (Welford)
+    double frameM2 = 0.0;
+
+    uint32_t safetyBytes = 0;
+    uint32_t expectedBytesPerFrame = 0;
+};
+
+auto AudioOpenNull(AudioDevice& device, int samplesPerSecond, uint32_t bufferSize) -> bool;
+auto AudioOpenWavFile(AudioDevice& device, const char* path, int samplesPerSecond, uint32_t bufferSize) -> bool;
+auto AudioOpenDirectSound(AudioDevice& device, HWND hwnd, int samplesPerSecond, uint32_t bufferSize) -> bool;
+
+inline auto AudioGetCursors(AudioDevice& device, uint32_t& playCursor, uint32_t& writeCursor) -> bool
+{
+    return device.api && device.api->getCursors(device, playCursor, writeCursor);
+}
+
+inline auto AudioLock(AudioDevice& device, uint32_t byteToLock, uint32_t bytesToLock, AudioRegions& regions) -> bool
+{
+    return device.api && device.api->lock(device, byteToLock, bytesToLock, regions);
+}
+
+inline void AudioUnlock(AudioDevice& device, AudioRegions& regions)
+{
+    device.api->unlock(device, regions);
+}
+
+inline auto AudioPlay(AudioDevice& device) -> bool
+{
+    if (!device.isPlaying && device.api)
+    {
+        device.isPlaying = device.api->play(device);
+    }
+    return device.isPlaying;
+}
+
+void AudioClose(AudioDevice& device);
+
+//Works out where the next write starts and how far ahead of the play cursor to fill
+auto AudioComputeWriteRange(AudioDevice& device, uint32_t latencyBytes, AudioWriteRange& range) -> bool;
+//Copies interleaved stereo samples into the ring and advances runningSampleIndex
+auto AudioWrite(AudioDevice& device, const AudioWriteRange& range, const int16_t* samples) -> bool;
+void AudioClear(AudioDevice& device);
+
+/*
+    NOTE: Zero copy path. AudioBeginWrite locks the write range and points the
+    sound buffer's regions straight at the device memory so the game synthesizes in
+    place, every backend has a lockable ring. Anything reading the samples (capture)
+    must do so before AudioEndWrite, the regions are invalid after the unlock.
+*/
+struct AudioWriteSession
+{
+    AudioRegions regions;
+    bool isLocked = false;
+};
+
+auto AudioBeginWrite(AudioDevice& device, const AudioWriteRange& range, SoundOutputBuffer& soundBuffer,
+                     AudioWriteSession& session) -> bool;
+void AudioEndWrite(AudioDevice& device, const SoundOutputBuffer& soundBuffer, AudioWriteSession& session);
+
+//Device must already be playing, spins for measureSeconds watching the cursors
+auto AudioCalibrate(AudioDevice& device, float targetSecondsPerFrame, float measureSeconds, AudioCalibration& calibration) -> bool;
+void AudioCalibrationObserveFrame(AudioDevice& device, AudioCalibration& calibration, float secondsElapsed);
+//Write range aligned to the expected frame flip, secondsSinceFlip is measured from the start of this frame
+auto AudioComputeCalibratedWriteRange(AudioDevice& device, AudioCalibration& calibration, float secondsSinceFlip,
+                                      AudioWriteRange& range) -> bool;
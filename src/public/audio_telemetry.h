@@ -0,0 +1,41 @@
+#pragma once
+#include "globals.h"
+#include "game.h"
+#include "audio.h"
+
+/*
+    NOTE: Per frame audio timing, kept in a ring of the last AUDIO_TELEMETRY_FRAMES frames.
+    Margin is how much audio was still queued ahead of the play cursor when we came to
+    write, i.e. how long we had left before the card ran dry. An underrun is a frame where
+    that queue had already been eaten into the region the card won't let us touch.
+    The overlay draws margin and mix cost against the frame budget; the CSV has the raw
+    cursors for offline tuning.
+*/
+
+#define AUDIO_TELEMETRY_FRAMES 256
+
+struct AudioTelemetryFrame
+{
+    uint64_t frameIndex;
+    uint32_t playCursor;
+    uint32_t writeCursor;
+    uint32_t byteToLock;    // end of what was queued before this frame's write
+    uint32_t bytesWritten;
+    float mixMs;
+    float marginMs;
+    bool underrun;
+};
+
+struct AudioTelemetry
+{
+    AudioTelemetryFrame frames[AUDIO_TELEMETRY_FRAMES];
+    uint64_t frameCount;
+    uint32_t underrunCount;
+    float worstMarginMs;
+};
+
+//queuedEnd is runningSampleIndex as a ring offset, read together with the cursors before the write range is computed
+void AudioTelemetryRecord(AudioTelemetry& telemetry, const AudioDevice& device, uint32_t playCursor, uint32_t writeCursor,
+                          uint32_t queuedEnd, uint32_t bytesWritten, float mixSeconds);
+void AudioTelemetryDraw(const AudioTelemetry& telemetry, OffscreenBuffer& buffer, float targetSecondsPerFrame);
+auto AudioTelemetryWriteCsv(const AudioTelemetry& telemetry, const char* path) -> bool;
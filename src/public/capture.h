@@ -0,0 +1,24 @@
+#pragma once
+#include "game.h"
+
+/*
+    NOTE: Gameplay capture for offline analysis.
+    The frame thread copies the back buffer into a pooled staging slot and the
+    frame's sound samples into a separate audio ring, and moves on; a background
+    thread converts and writes them out as a PPM stream (<base>.ppm) and a 16-bit
+    stereo WAV (<base>.wav). Audio never depends on a free slot. A video frame that
+    finds every slot busy is dropped and the previous frame is written again in its
+    place, so both files keep the same length.
+
+    The .ppm file is a plain concatenation of P6 frames, e.g.
+        ffmpeg -f image2pipe -c:v ppm -framerate 30 -i capture.ppm capture.mp4
+*/
+
+auto CaptureStart(const char* basePath, int width, int height, int samplesPerSecond) -> bool;
+// Frame thread side, each costs a memcpy. The sound buffer may point into locked device memory,
+// so CaptureAudio runs before the unlock and CaptureFrame submits the slot once the frame is rendered.
+void CaptureAudio(const SoundOutputBuffer& soundBuffer);
+void CaptureFrame(const OffscreenBuffer& buffer);
+// Flushes every queued frame before returning
+void CaptureStop();
+auto CaptureIsActive() -> bool;
@@ -0,0 +1,114 @@
+#pragma once
+#include <string.h>
+
+/*
+    NOTE: The command line is split into whitespace separated tokens, a token in double
+    quotes keeps its spaces and loses the quotes, e.g. -capture "runs/first run".
+    Names only match whole unquoted tokens, so -audio-null never matches -audio-null-x.
+    A value is the token right after its name and can't be another unquoted -option.
+*/
+
+struct CommandLineToken
+{
+    const char* start;
+    size_t length;
+    bool quoted;
+};
+
+//Advances cursor past the next token, false once the line is used up
+inline bool NextCommandLineToken(const char*& cursor, CommandLineToken& token)
+{
+    while (*cursor == ' ' || *cursor == '\t')
+    {
+        ++cursor;
+    }
+    if (!*cursor)
+    {
+        return false;
+    }
+
+    token.quoted = *cursor == '"';
+    if (token.quoted)
+    {
+        token.start = ++cursor;
+        while (*cursor && *cursor != '"')
+        {
+            ++cursor;
+        }
+        token.length = (size_t)(cursor - token.start);
+        if (*cursor)
+        {
+            ++cursor;
+        }
+    }
+    else
+    {
+        token.start = cursor;
+        while (*cursor && *cursor != ' ' && *cursor != '\t')
+        {
+            ++cursor;
+        }
+        token.length = (size_t)(cursor - token.start);
+    }
+    return true;
+}
+
+inline bool CommandLineTokenIs(const CommandLineToken& token, const char* name)
+{
+    size_t length = strlen(name);
+    return !token.quoted && token.length == length && strncmp(token.start, name, length) == 0;
+}
+
+//Copies the token following `name` on the command line into out, e.g. "-capture run1".
+//False if the option or its value is missing, or the value doesn't fit in outSize.
+inline bool GetCommandLineArgument(const char* cmdLine, const char* name, char* out, size_t outSize)
+{
+    if (outSize)
+    {
+        out[0] = 0;
+    }
+    if (!cmdLine)
+    {
+        return false;
+    }
+
+    const char* cursor = cmdLine;
+    CommandLineToken token;
+    while (NextCommandLineToken(cursor, token))
+    {
+        if (!CommandLineTokenIs(token, name))
+        {
+            continue;
+        }
+
+        CommandLineToken value;
+        if (!NextCommandLineToken(cursor, value) || value.length == 0 ||
+            (!value.quoted && value.start[0] == '-') || value.length >= outSize)
+        {
+            return false;
+        }
+        memcpy(out, value.start, value.length);
+        out[value.length] = 0;
+        return true;
+    }
+    return false;
+}
+
+inline bool HasCommandLineFlag(const char* cmdLine, const char* name)
+{
+    if (!cmdLine)
+    {
+        return false;
+    }
+
+    const char* cursor = cmdLine;
+    CommandLineToken token;
+    while (NextCommandLineToken(cursor, token))
+    {
+        if (CommandLineTokenIs(token, name))
+        {
+            return true;
+        }
+    }
+    return false;
+}
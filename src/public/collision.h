@@ -0,0 +1,43 @@
+#pragma once
+#include "memory.h"
+#include "game_math.h"
+#include "sim_region.h"
+
+/*
+    NOTE: Collision for the sim region's EntityFlag_Collides entities, all boxes.
+    Broad phase is a uniform grid rebuilt every frame. Cells are never smaller than the
+    largest swept box (a box grown by this frame's motion), so two boxes that can touch
+    have their centers in the same or neighbouring cells; past that they are sized for
+    about two colliders each, any finer and the walk spends its time on empty cells.
+    Each collider's key is its cell index; keys are radix sorted carrying the collider
+    along, then the collider data is gathered into that order, so the pair walk reads
+    forward through memory. A collider is paired with the rest of its own cell and the
+    forward half of its neighbours (right, and the three above), which finds every pair
+    exactly once.
+    Candidates whose swept boxes overlap go through a swept AABB test that gives the
+    time of first contact within the frame and the contact normal.
+*/
+
+struct Contact
+{
+    uint32_t a;         // sim region indices
+    uint32_t b;
+    float t;            // fraction of the frame at first contact, 0 if they already overlap
+    v2 normal;          // from b towards a
+};
+
+struct ContactList
+{
+    Contact* contacts;
+    uint32_t count;
+    uint32_t candidateCount;    // pairs the broad phase handed to the narrow phase
+    uint32_t droppedCount;      // contacts past capacity (8 per collider), not reported
+};
+
+//a's center relative to b at the start is offset, relative displacement over the frame is move. The boxes
+//touch once offset is within combinedRadius on both axes; t is when in [0, 1], normal points from b to a.
+auto SweptAabb(v2 offset, v2 move, float combinedRadius, float& t, v2& normal) -> bool;
+//Scratch comes from the arena, roll it back together with the region
+auto FindSimContacts(MemoryArena& scratchArena, SimRegion& region, float seconds) -> ContactList;
+//Equal mass elastic bounce along the normal, entities without EntityFlag_Moving act as immovable walls
+void ResolveSimContacts(SimRegion& region, ContactList& contacts);
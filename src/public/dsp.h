@@ -0,0 +1,113 @@
+#pragma once
+#include "memory.h"
+
+/*
+    NOTE: Effects that run on the mixer's planar float blocks.
+    Every process call gets a whole mixer block (a multiple of DSP_SUB_BLOCK frames).
+    Gains, peak detection, comb and allpass lines run 4 frames at a time with SSE.
+    Biquads are recursive per sample, so those run both channels side by side in
+    one register instead. The mixer enables flush-to-zero / denormals-are-zero around
+    processing so decaying tails never fall into denormals.
+*/
+
+#define DSP_SUB_BLOCK 16          // dynamics recompute their gain every 16 frames
+#define DSP_MAX_EFFECTS 8
+
+enum class BiquadType : uint8_t
+{
+    LowPass,
+    HighPass,
+    Peaking,
+    LowShelf,
+    HighShelf,
+};
+
+struct Biquad
+{
+    float b0, b1, b2, a1, a2;
+    float z1[4];  // lanes: left, right, unused, unused
+    float z2[4];
+};
+
+struct Compressor
+{
+    float threshold;      // linear
+    float ratio;
+    float attack;         // per sub block smoothing coefficients
+    float release;
+    float makeupGain;
+    float envelope;
+    float gain;
+};
+
+struct Limiter
+{
+    float ceiling;        // linear, output never exceeds this
+    float release;
+    float gain;
+};
+
+#define REVERB_COMB_COUNT 4
+#define REVERB_ALLPASS_COUNT 2
+
+struct DelayLine
+{
+    float* buffer;
+    int length;           // multiple of 4 so SSE groups never wrap
+    int index;
+};
+
+struct Reverb
+{
+    DelayLine combs[2][REVERB_COMB_COUNT];
+    DelayLine allpasses[2][REVERB_ALLPASS_COUNT];
+    float feedback;
+    float wet;
+    float dry;
+    float* scratch[3];    // mono input, wet left, wet right
+};
+
+enum class EffectType : uint8_t
+{
+    Biquad,
+    Compressor,
+    Limiter,
+    Reverb,
+};
+
+struct Effect
+{
+    EffectType type;
+    bool enabled;
+    void* state;
+};
+
+struct EffectChain
+{
+    Effect effects[DSP_MAX_EFFECTS];
+    int count;
+};
+
+void BiquadSet(Biquad& biquad, BiquadType type, float samplesPerSecond, float frequency, float q, float gainDb = 0.0f);
+void BiquadProcess(Biquad& biquad, float* left, float* right, int frameCount);
+
+void CompressorSet(Compressor& compressor, float samplesPerSecond, float thresholdDb, float ratio,
+                   float attackSeconds, float releaseSeconds, float makeupDb);
+void CompressorProcess(Compressor& compressor, float* left, float* right, int frameCount);
+
+void LimiterSet(Limiter& limiter, float samplesPerSecond, float ceilingDb, float releaseSeconds);
+void LimiterProcess(Limiter& limiter, float* left, float* right, int frameCount);
+
+void ReverbInitialize(Reverb& reverb, MemoryArena& arena, int samplesPerSecond, int maxFrameCount);
+void ReverbSet(Reverb& reverb, float roomSize, float wet, float dry);
+void ReverbProcess(Reverb& reverb, float* left, float* right, int frameCount);
+
+//Chain helpers, state comes from the arena and lives as long as it does
+auto EffectChainAddBiquad(EffectChain& chain, MemoryArena& arena) -> Biquad*;
+auto EffectChainAddCompressor(EffectChain& chain, MemoryArena& arena) -> Compressor*;
+auto EffectChainAddLimiter(EffectChain& chain, MemoryArena& arena) -> Limiter*;
+auto EffectChainAddReverb(EffectChain& chain, MemoryArena& arena, int samplesPerSecond, int maxFrameCount) -> Reverb*;
+void EffectChainProcess(EffectChain& chain, float* left, float* right, int frameCount);
+
+//out += in * gain over both channels
+void MixAddScaled(float* outLeft, float* outRight, const float* inLeft, const float* inRight, float gain, int frameCount);
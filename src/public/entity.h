@@ -0,0 +1,75 @@
+#pragma once
+#include "memory.h"
+#include "world.h"
+
+/*
+    NOTE: Entities are stored as structure of arrays. Every field is its own dense
+    column and entity i lives at index i of all of them, so a pass touches only the
+    columns it needs. Removing swaps the last entity into the hole, the columns never
+    have gaps. Dense indices move on removal, anything that keeps an entity around
+    holds an EntityId (slot plus generation, like the mixer's voice handles), and the
+    world files entities under their chunk by slot.
+    This is the low frequency store for the whole world. Positions are world positions
+    split into columns (chunk ints plus offset floats); they change only when a sim
+    region writes back what it simulated, see sim_region.h.
+*/
+
+#define ENTITY_INVALID_INDEX 0xFFFFFFFFu
+
+enum EntityFlag : uint32_t
+{
+    EntityFlag_Moving = 1 << 0,     // integrated every update
+    EntityFlag_Confined = 1 << 1,   // bounces off the ConfineSimEntities box
+    EntityFlag_Collides = 1 << 2,   // takes part in FindSimContacts
+};
+
+struct EntityId
+{
+    uint32_t slot;
+    uint32_t generation;    // 0 never resolves
+};
+
+struct EntitySlot
+{
+    uint32_t generation;
+    uint32_t denseIndex;    // or the next free slot while unused
+};
+
+struct EntityStore
+{
+    uint32_t capacity;
+    uint32_t count;
+
+    // Dense columns, capacity each
+    int32_t* chunkX;
+    int32_t* chunkY;
+    float* offsetX;
+    float* offsetY;
+    float* velocityX;
+    float* velocityY;
+    float* radius;          // half the side of the collision box
+    uint32_t* flags;
+    uint32_t* slotOf;       // dense index -> slot
+
+    EntitySlot* slots;
+    uint32_t firstFreeSlot;
+};
+
+void InitializeEntityStore(EntityStore& store, MemoryArena& arena, uint32_t capacity);
+//Returns a zero id when the store is full
+auto AddEntity(EntityStore& store, World& world, WorldPosition position, v2 velocity, float radius, uint32_t flags)
+    -> EntityId;
+void RemoveEntity(EntityStore& store, World& world, EntityId id);
+//ENTITY_INVALID_INDEX once the entity has been removed
+inline auto GetEntityIndex(const EntityStore& store, EntityId id) -> uint32_t
+{
+    if (id.slot < store.capacity && id.generation != 0 && store.slots[id.slot].generation == id.generation)
+    {
+        return store.slots[id.slot].denseIndex;
+    }
+    return ENTITY_INVALID_INDEX;
+}
+inline auto GetEntityPosition(const EntityStore& store, uint32_t index) -> WorldPosition
+{
+    return {store.chunkX[index], store.chunkY[index], {store.offsetX[index], store.offsetY[index]}};
+}
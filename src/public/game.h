@@ -6,6 +6,24 @@
 */
 
 
+#define Kilobytes(value) ((value) * 1024LL)
+#define Megabytes(value) (Kilobytes(value) * 1024LL)
+#define Gigabytes(value) (Megabytes(value) * 1024LL)
+
+struct PlatformWorkQueue;
+
+//Everything the game keeps between frames lives in here, the platform allocates it once (zeroed)
+struct GameMemory
+{
+    bool isInitialized = false;
+    uint64_t permanentStorageSize = 0;
+    void* permanentStorage = nullptr;
+    uint64_t transientStorageSize = 0;
+    void* transientStorage = nullptr;
+    PlatformWorkQueue* workQueue = nullptr;         // worker threads, nullptr runs work inline on the caller
+    PlatformWorkQueue* backgroundQueue = nullptr;   // work that may span frames, never waited on in a frame
+};
+
 struct OffscreenBuffer
 {
     void* data;
@@ -14,16 +32,79 @@ struct OffscreenBuffer
     int pitch{0};
 };
 
-struct SoundOutputBuffer
+/*
+    NOTE: Interleaved stereo samples. The platform usually hands us the audio device's
+    ring buffer directly, so the output can wrap: fill regions[0] and then regions[1].
+*/
+struct SoundRegion
 {
     int16_t* samples = nullptr;
-    int samplesPerSecond = 0;
     int sampleCount = 0;
+};
+
+struct SoundOutputBuffer
+{
+    SoundRegion regions[2];
+    int samplesPerSecond = 0;
+    int sampleCount = 0; // regions[0].sampleCount + regions[1].sampleCount
+
+};
+
+inline void SetContiguousSamples(SoundOutputBuffer& buffer, int16_t* samples, int sampleCount)
+{
+    buffer.regions[0] = {samples, sampleCount};
+    buffer.regions[1] = {};
+    buffer.sampleCount = sampleCount;
+}
 
+//Input for one frame, sticks are -1..1 with the dead zone already removed
+struct GameInput
+{
+    float secondsElapsed = 0.0f;
+    float stickX = 0.0f;
+    float stickY = 0.0f;
 };
+
 //game needs 4 things timer , controller/keyboard input , bitmap buffer to use, sound buffer to use
-void GameUpdateAndRender(OffscreenBuffer& buffer,SoundOutputBuffer& soundBuffer, int toneHz);
+void GameUpdateAndRender(GameMemory& memory, GameInput& input, OffscreenBuffer& buffer);
+//Audio only path, lets the platform pull samples without rendering a frame (offline bounce, benchmarks)
+void GameGetSoundSamples(GameMemory& memory, SoundOutputBuffer& soundBuffer, int toneHz);
 
 /*
    TODO: NOTE: Services that the platform layer provide to the game
-*/
\ No newline at end of file
+*/
+
+//Read only memory mapped file. Views are mapped on demand so only the part being read is resident.
+struct PlatformMappedFile
+{
+    void* fileHandle = nullptr;
+    void* mappingHandle = nullptr;
+    uint64_t size = 0;
+};
+
+auto PlatformOpenMappedFile(const char* path, PlatformMappedFile& file) -> bool;
+void PlatformCloseMappedFile(PlatformMappedFile& file);
+//offset must be a multiple of PlatformGetMapGranularity()
+auto PlatformMapView(PlatformMappedFile& file, uint64_t offset, uint32_t size) -> void*;
+void PlatformUnmapView(void* view);
+auto PlatformGetMapGranularity() -> uint32_t;
+
+/*
+    NOTE: Work queue. The game adds entries from one thread and then calls
+    PlatformCompleteAllWork, which runs entries on the calling thread too until the
+    queue is drained, so nothing added is left running afterwards. An entry must not
+    add entries. Without a queue entries run right away on the caller.
+    The background queue is never completed; its entries report back on their own,
+    and the game keeps fewer of them in flight than the queue holds (256). Adding to
+    a full queue runs queued entries on the adding thread until there is room.
+*/
+typedef void PlatformWorkQueueCallback(void* data);
+
+void PlatformAddWorkEntry(PlatformWorkQueue* queue, PlatformWorkQueueCallback* callback, void* data);
+void PlatformCompleteAllWork(PlatformWorkQueue* queue);
+//Threads that can run entries at once, the caller of PlatformCompleteAllWork included
+auto PlatformGetWorkerCount(PlatformWorkQueue* queue) -> uint32_t;
+
+//Monotonic, for budgeting work inside a frame
+auto PlatformGetWallClock() -> uint64_t;
+auto PlatformGetSecondsElapsed(uint64_t start, uint64_t end) -> float;
@@ -0,0 +1,514 @@
+#pragma once
+#include "globals.h"
+#include "simd.h"
+#include <math.h>
+
+/*
+    NOTE: Vector math for the game layer.
+    v2 and v3 are plain floats, two or three lanes don't pay for the shuffles. v4 and
+    m4x4 keep their rows in __m128 so the arithmetic is one SSE instruction per row and
+    a matrix * vector is four multiply-adds. rect2/rect3 are min/max boxes.
+    Loops over many values use the lane types in lane.h on SoA data instead, these are
+    for one-off positions, offsets and transforms.
+*/
+
+#pragma region Scalar
+
+// fminf/fmaxf have to honour NaNs and end up as calls, these are a single minss/maxss
+inline float Minimum(float a, float b)
+{
+    return a < b ? a : b;
+}
+
+inline float Maximum(float a, float b)
+{
+    return a > b ? a : b;
+}
+
+inline float Clamp(float min, float value, float max)
+{
+    return Minimum(Maximum(value, min), max);
+}
+
+inline float Clamp01(float value)
+{
+    return Clamp(0.0f, value, 1.0f);
+}
+
+inline float Square(float value)
+{
+    return value * value;
+}
+
+inline float Lerp(float a, float t, float b)
+{
+    return a + t * (b - a);
+}
+
+//numerator / divisor, or fallback when the divisor is 0
+inline float SafeRatio(float numerator, float divisor, float fallback = 0.0f)
+{
+    return divisor != 0.0f ? numerator / divisor : fallback;
+}
+
+#pragma endregion
+
+#pragma region v2
+
+struct v2
+{
+    float x;
+    float y;
+};
+
+inline v2 V2(float x, float y)
+{
+    return {x, y};
+}
+
+inline v2 operator+(v2 a, v2 b) { return {a.x + b.x, a.y + b.y}; }
+inline v2 operator-(v2 a, v2 b) { return {a.x - b.x, a.y - b.y}; }
+inline v2 operator-(v2 a) { return {-a.x, -a.y}; }
+inline v2 operator*(float s, v2 a) { return {s * a.x, s * a.y}; }
+inline v2 operator*(v2 a, float s) { return {s * a.x, s * a.y}; }
+inline v2& operator+=(v2& a, v2 b) { a = a + b; return a; }
+inline v2& operator-=(v2& a, v2 b) { a = a - b; return a; }
+inline v2& operator*=(v2& a, float s) { a = s * a; return a; }
+
+inline v2 Hadamard(v2 a, v2 b)
+{
+    return {a.x * b.x, a.y * b.y};
+}
+
+inline float Inner(v2 a, v2 b)
+{
+    return a.x * b.x + a.y * b.y;
+}
+
+inline float LengthSq(v2 a)
+{
+    return Inner(a, a);
+}
+
+inline float Length(v2 a)
+{
+    return sqrtf(LengthSq(a));
+}
+
+inline v2 Perp(v2 a)
+{
+    return {-a.y, a.x};
+}
+
+inline v2 Lerp(v2 a, float t, v2 b)
+{
+    return a + t * (b - a);
+}
+
+#pragma endregion
+
+#pragma region v3
+
+struct v3
+{
+    union
+    {
+        struct
+        {
+            float x, y, z;
+        };
+        struct
+        {
+            v2 xy;
+            float ignored;
+        };
+    };
+};
+
+inline v3 V3(float x, float y, float z)
+{
+    v3 result;
+    result.x = x;
+    result.y = y;
+    result.z = z;
+    return result;
+}
+
+inline v3 V3(v2 xy, float z)
+{
+    return V3(xy.x, xy.y, z);
+}
+
+inline v3 operator+(v3 a, v3 b) { return V3(a.x + b.x, a.y + b.y, a.z + b.z); }
+inline v3 operator-(v3 a, v3 b) { return V3(a.x - b.x, a.y - b.y, a.z - b.z); }
+inline v3 operator-(v3 a) { return V3(-a.x, -a.y, -a.z); }
+inline v3 operator*(float s, v3 a) { return V3(s * a.x, s * a.y, s * a.z); }
+inline v3 operator*(v3 a, float s) { return s * a; }
+inline v3& operator+=(v3& a, v3 b) { a = a + b; return a; }
+inline v3& operator-=(v3& a, v3 b) { a = a - b; return a; }
+inline v3& operator*=(v3& a, float s) { a = s * a; return a; }
+
+inline v3 Hadamard(v3 a, v3 b)
+{
+    return V3(a.x * b.x, a.y * b.y, a.z * b.z);
+}
+
+inline float Inner(v3 a, v3 b)
+{
+    return a.x * b.x + a.y * b.y + a.z * b.z;
+}
+
+inline v3 Cross(v3 a, v3 b)
+{
+    return V3(a.y * b.z - a.z * b.y, a.z * b.x - a.x * b.z, a.x * b.y - a.y * b.x);
+}
+
+inline float LengthSq(v3 a)
+{
+    return Inner(a, a);
+}
+
+inline float Length(v3 a)
+{
+    return sqrtf(LengthSq(a));
+}
+
+inline v3 Normalize(v3 a)
+{
+    return a * (1.0f / Length(a));
+}
+
+inline v3 Lerp(v3 a, float t, v3 b)
+{
+    return a + t * (b - a);
+}
+
+#pragma endregion
+
+#pragma region v4
+
+struct alignas(16) v4
+{
+    union
+    {
+        struct
+        {
+            float x, y, z, w;
+        };
+        struct
+        {
+            float r, g, b, a;
+        };
+        struct
+        {
+            v3 xyz;
+            float ignored;
+        };
+        float e[4];
+        __m128 m;
+    };
+};
+
+inline v4 V4(__m128 m)
+{
+    v4 result;
+    result.m = m;
+    return result;
+}
+
+inline v4 V4(float x, float y, float z, float w)
+{
+    return V4(_mm_setr_ps(x, y, z, w));
+}
+
+inline v4 V4(v3 xyz, float w)
+{
+    return V4(xyz.x, xyz.y, xyz.z, w);
+}
+
+inline v4 operator+(v4 a, v4 b) { return V4(_mm_add_ps(a.m, b.m)); }
+inline v4 operator-(v4 a, v4 b) { return V4(_mm_sub_ps(a.m, b.m)); }
+inline v4 operator-(v4 a) { return V4(_mm_xor_ps(a.m, _mm_set1_ps(-0.0f))); }
+inline v4 operator*(float s, v4 a) { return V4(_mm_mul_ps(_mm_set1_ps(s), a.m)); }
+inline v4 operator*(v4 a, float s) { return s * a; }
+inline v4& operator+=(v4& a, v4 b) { a = a + b; return a; }
+inline v4& operator-=(v4& a, v4 b) { a = a - b; return a; }
+inline v4& operator*=(v4& a, float s) { a = s * a; return a; }
+
+inline v4 Hadamard(v4 a, v4 b)
+{
+    return V4(_mm_mul_ps(a.m, b.m));
+}
+
+inline float Inner(v4 a, v4 b)
+{
+    return HorizontalAdd(_mm_mul_ps(a.m, b.m));
+}
+
+inline float LengthSq(v4 a)
+{
+    return Inner(a, a);
+}
+
+inline float Length(v4 a)
+{
+    return sqrtf(LengthSq(a));
+}
+
+inline v4 Lerp(v4 a, float t, v4 b)
+{
+    return a + t * (b - a);
+}
+
+inline v4 Clamp01(v4 a)
+{
+    return V4(_mm_min_ps(_mm_max_ps(a.m, _mm_setzero_ps()), _mm_set1_ps(1.0f)));
+}
+
+//0xAARRGGBB, the offscreen buffer's pixel layout, from a 0..1 color
+inline uint32_t PackColor(v4 color)
+{
+    __m128i channels = _mm_cvtps_epi32(_mm_mul_ps(Clamp01(color).m, _mm_set1_ps(255.0f)));
+    alignas(16) uint32_t c[4];
+    _mm_store_si128((__m128i*)c, channels);
+    return (c[3] << 24) | (c[0] << 16) | (c[1] << 8) | c[2];
+}
+
+#pragma endregion
+
+#pragma region rect2
+
+struct rect2
+{
+    v2 min;
+    v2 max;
+};
+
+inline rect2 RectMinMax(v2 min, v2 max)
+{
+    return {min, max};
+}
+
+inline rect2 RectMinDim(v2 min, v2 dim)
+{
+    return {min, min + dim};
+}
+
+inline rect2 RectCenterHalfDim(v2 center, v2 halfDim)
+{
+    return {center - halfDim, center + halfDim};
+}
+
+inline v2 GetCenter(rect2 rect)
+{
+    return 0.5f * (rect.min + rect.max);
+}
+
+inline v2 GetDim(rect2 rect)
+{
+    return rect.max - rect.min;
+}
+
+//Grows the rect by radius on every side, e.g. the Minkowski sum with a box of that half side
+inline rect2 AddRadius(rect2 rect, v2 radius)
+{
+    return {rect.min - radius, rect.max + radius};
+}
+
+inline rect2 Offset(rect2 rect, v2 offset)
+{
+    return {rect.min + offset, rect.max + offset};
+}
+
+//min inclusive, max exclusive
+inline bool IsInRectangle(rect2 rect, v2 point)
+{
+    return point.x >= rect.min.x && point.y >= rect.min.y && point.x < rect.max.x && point.y < rect.max.y;
+}
+
+inline bool RectanglesIntersect(rect2 a, rect2 b)
+{
+    return !(b.max.x <= a.min.x || b.min.x >= a.max.x || b.max.y <= a.min.y || b.min.y >= a.max.y);
+}
+
+//Empty (max <= min) when they don't overlap
+inline rect2 Intersect(rect2 a, rect2 b)
+{
+    return {V2(Maximum(a.min.x, b.min.x), Maximum(a.min.y, b.min.y)),
+            V2(Minimum(a.max.x, b.max.x), Minimum(a.max.y, b.max.y))};
+}
+
+inline rect2 Union(rect2 a, rect2 b)
+{
+    return {V2(Minimum(a.min.x, b.min.x), Minimum(a.min.y, b.min.y)),
+            V2(Maximum(a.max.x, b.max.x), Maximum(a.max.y, b.max.y))};
+}
+
+#pragma endregion
+
+#pragma region rect3
+
+struct rect3
+{
+    v3 min;
+    v3 max;
+};
+
+inline rect3 RectMinMax(v3 min, v3 max)
+{
+    return {min, max};
+}
+
+inline rect3 RectCenterHalfDim(v3 center, v3 halfDim)
+{
+    return {center - halfDim, center + halfDim};
+}
+
+inline v3 GetCenter(rect3 rect)
+{
+    return 0.5f * (rect.min + rect.max);
+}
+
+inline v3 GetDim(rect3 rect)
+{
+    return rect.max - rect.min;
+}
+
+inline rect3 AddRadius(rect3 rect, v3 radius)
+{
+    return {rect.min - radius, rect.max + radius};
+}
+
+inline bool IsInRectangle(rect3 rect, v3 point)
+{
+    return point.x >= rect.min.x && point.y >= rect.min.y && point.z >= rect.min.z &&
+           point.x < rect.max.x && point.y < rect.max.y && point.z < rect.max.z;
+}
+
+inline bool RectanglesIntersect(rect3 a, rect3 b)
+{
+    return !(b.max.x <= a.min.x || b.min.x >= a.max.x || b.max.y <= a.min.y || b.min.y >= a.max.y ||
+             b.max.z <= a.min.z || b.min.z >= a.max.z);
+}
+
+inline rect2 ToRect2(rect3 rect)
+{
+    return {rect.min.xy, rect.max.xy};
+}
+
+#pragma endregion
+
+#pragma region m4x4
+
+// Row major, transforms column vectors: p' = M * p
+struct alignas(16) m4x4
+{
+    union
+    {
+        float e[4][4];
+        __m128 rows[4];
+    };
+};
+
+inline m4x4 Identity()
+{
+    m4x4 result;
+    result.rows[0] = _mm_setr_ps(1.0f, 0.0f, 0.0f, 0.0f);
+    result.rows[1] = _mm_setr_ps(0.0f, 1.0f, 0.0f, 0.0f);
+    result.rows[2] = _mm_setr_ps(0.0f, 0.0f, 1.0f, 0.0f);
+    result.rows[3] = _mm_setr_ps(0.0f, 0.0f, 0.0f, 1.0f);
+    return result;
+}
+
+inline m4x4 Transpose(m4x4 a)
+{
+    _MM_TRANSPOSE4_PS(a.rows[0], a.rows[1], a.rows[2], a.rows[3]);
+    return a;
+}
+
+// Each result row is a's row weighting b's rows, four broadcasts and multiply-adds
+inline m4x4 operator*(const m4x4& a, const m4x4& b)
+{
+    m4x4 result;
+    for (int r = 0; r < 4; ++r)
+    {
+        __m128 row = _mm_mul_ps(_mm_set1_ps(a.e[r][0]), b.rows[0]);
+        row = _mm_add_ps(row, _mm_mul_ps(_mm_set1_ps(a.e[r][1]), b.rows[1]));
+        row = _mm_add_ps(row, _mm_mul_ps(_mm_set1_ps(a.e[r][2]), b.rows[2]));
+        row = _mm_add_ps(row, _mm_mul_ps(_mm_set1_ps(a.e[r][3]), b.rows[3]));
+        result.rows[r] = row;
+    }
+    return result;
+}
+
+// Columns weighted by the vector's components, the transposed view of the same multiply-adds
+inline v4 operator*(const m4x4& a, v4 p)
+{
+    m4x4 columns = Transpose(a);
+    __m128 result = _mm_mul_ps(columns.rows[0], _mm_set1_ps(p.x));
+    result = _mm_add_ps(result, _mm_mul_ps(columns.rows[1], _mm_set1_ps(p.y)));
+    result = _mm_add_ps(result, _mm_mul_ps(columns.rows[2], _mm_set1_ps(p.z)));
+    result = _mm_add_ps(result, _mm_mul_ps(columns.rows[3], _mm_set1_ps(p.w)));
+    return V4(result);
+}
+
+//Point transform, w = 1
+inline v3 operator*(const m4x4& a, v3 p)
+{
+    return (a * V4(p, 1.0f)).xyz;
+}
+
+inline m4x4 Translation(v3 t)
+{
+    m4x4 result = Identity();
+    result.e[0][3] = t.x;
+    result.e[1][3] = t.y;
+    result.e[2][3] = t.z;
+    return result;
+}
+
+inline m4x4 Scaling(v3 s)
+{
+    m4x4 result = Identity();
+    result.e[0][0] = s.x;
+    result.e[1][1] = s.y;
+    result.e[2][2] = s.z;
+    return result;
+}
+
+inline m4x4 ZRotation(float angle)
+{
+    float c = cosf(angle);
+    float s = sinf(angle);
+    m4x4 result = Identity();
+    result.e[0][0] = c;
+    result.e[0][1] = -s;
+    result.e[1][0] = s;
+    result.e[1][1] = c;
+    return result;
+}
+
+inline m4x4 XRotation(float angle)
+{
+    float c = cosf(angle);
+    float s = sinf(angle);
+    m4x4 result = Identity();
+    result.e[1][1] = c;
+    result.e[1][2] = -s;
+    result.e[2][1] = s;
+    result.e[2][2] = c;
+    return result;
+}
+
+//Maps the box [-halfWidth, halfWidth] x [-halfHeight, halfHeight] x [near, far] to clip space -1..1
+inline m4x4 Orthographic(float halfWidth, float halfHeight, float nearPlane, float farPlane)
+{
+    m4x4 result = Identity();
+    result.e[0][0] = 1.0f / halfWidth;
+    result.e[1][1] = 1.0f / halfHeight;
+    result.e[2][2] = 2.0f / (farPlane - nearPlane);
+    result.e[2][3] = -(farPlane + nearPlane) / (farPlane - nearPlane);
+    return result;
+}
+
+#pragma endregion
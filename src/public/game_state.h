@@ -0,0 +1,45 @@
+#pragma once
+#include "game.h"
+#include "memory.h"
+#include "mixer.h"
+#include "wav_stream.h"
+#include "sequencer.h"
+#include "world.h"
+#include "entity.h"
+#include "sim_region.h"
+#include "collision.h"
+#include "pathfinding.h"
+#include "world_gen.h"
+#include "random.h"
+#include "particles.h"
+
+/*
+    NOTE: Game side state, lives at the start of GameMemory::permanentStorage.
+    The transient arena covers all of GameMemory::transientStorage and holds per frame
+    scratch, like the sim region, that is rolled back at the end of every update. The
+    pathfinder's node pools are pushed onto it once, before any frame, so they stay.
+*/
+
+struct GameState
+{
+    MemoryArena permanentArena;
+    MemoryArena transientArena;
+
+    Mixer mixer;
+    VoiceHandle toneVoice;
+    WavStream music;
+    TrackerSong* song;
+    Sequencer sequencer;
+
+    World world;
+    WorldGenerator worldGenerator;
+    WorldPosition cameraPosition;
+    EntityStore entities;
+
+    Pathfinder pathfinder;
+    RandomSeries pathRandom;
+    PathRequest* demoPaths;
+
+    ParticleSystem particles;
+    float particleSpawnCarry;   // particles per emitter owed to the next frame, under PARTICLE_LANES
+};
@@ -7,4 +7,6 @@
 #define local static
 #define internal static
 
-#define M_PI 3.14159265358979323846
\ No newline at end of file
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
\ No newline at end of file
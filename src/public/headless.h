@@ -0,0 +1,51 @@
+#pragma once
+
+/*
+    NOTE: Windowless runner for tools and benchmarks, selected with -headless.
+    Every mode and its flags are listed here. Without a known mode it prints the
+    usage; the exit code is 0 on success and -1 on failure, which for a benchmark
+    includes results that disagree with its reference.
+
+    -bounce <path.wav> [-seconds N] [-tone Hz]
+        Renders the game's audio path as fast as possible into a WAV file and
+        reports samples-per-second throughput.
+
+    -adpcm-encode <in.wav> -out <out.adp> [-rate Hz]
+        Encodes a WAV into a 4:1 ADPCM sound, resampled to the game's output rate
+        or to -rate, then decodes it back and reports the compression ratio, SNR
+        and decode speed.
+
+    -bench-ring
+        Times a frame sized wrapping write and a whole buffer clear on the audio
+        ring, the per-sample walk against the span helpers.
+
+    -bench-entities
+        Moves 50k confined entities with the scalar whole world update, a sim
+        region over all of them and the camera sized region the game uses, and
+        checks the first frame against the scalar one.
+
+    -bench-collide
+        Simulates 10k colliders at the demo's density in one sim region with
+        collisions on, checks the first frame's contacts against every pair, and
+        reports the average and worst frame.
+
+    -bench-path
+        Runs random path queries on a walled tile map on one thread, across the
+        worker queue and in 1ms budgeted frames, and checks every path is valid.
+
+    -bench-worldgen
+        Generates the same square of chunks inline, on the background workers and
+        in reverse order, checks they give the same tiles, and reports the cost
+        per chunk and of the main thread's calls.
+
+    -bench-random
+        Fills with eight scalar random series, the SSE halves and the AVX2 lanes,
+        checks they give the same values, and reports ns per value and how evenly
+        the unilateral floats fill [0, 1).
+
+    -bench-particles
+        Updates and renders about 100k particles on one thread and on the whole
+        worker pool, and checks both give the same image.
+*/
+
+auto RunHeadless(const char* cmdLine) -> int;
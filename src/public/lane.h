@@ -0,0 +1,227 @@
+#pragma once
+#include "globals.h"
+#include "simd.h"
+
+/*
+    NOTE: Lane types so SIMD loops over SoA data read like the scalar code they replace.
+    lane_f32/lane_u32 are 4 wide SSE2 and always available. lane8_f32/lane8_u32 are 8
+    wide AVX2: every function on them carries SIMD_TARGET_AVX2, so they can only be
+    used inside functions that do too, picked at runtime with CpuHasAvx2 like the rest
+    of the wide paths.
+    Comparisons give all-ones/all-zero masks in a lane_u32. Branches become masks:
+    compute both sides and ConditionalAssign the lanes that take the other one. Loads
+    and stores are aligned, SoA columns padded to the lane count keep every group whole.
+*/
+
+#define LANE_WIDTH 4
+#define LANE8_WIDTH 8
+
+#pragma region 4 wide
+
+struct lane_f32
+{
+    __m128 v;
+};
+
+struct lane_u32
+{
+    __m128i v;
+};
+
+inline lane_f32 LaneF32(float value) { return {_mm_set1_ps(value)}; }
+inline lane_u32 LaneU32(uint32_t value) { return {_mm_set1_epi32((int)value)}; }
+inline lane_f32 LoadF32(const float* values) { return {_mm_load_ps(values)}; }
+inline lane_u32 LoadU32(const uint32_t* values) { return {_mm_load_si128((const __m128i*)values)}; }
+inline void Store(float* dest, lane_f32 value) { _mm_store_ps(dest, value.v); }
+inline void Store(uint32_t* dest, lane_u32 value) { _mm_store_si128((__m128i*)dest, value.v); }
+
+inline lane_f32 operator+(lane_f32 a, lane_f32 b) { return {_mm_add_ps(a.v, b.v)}; }
+inline lane_f32 operator-(lane_f32 a, lane_f32 b) { return {_mm_sub_ps(a.v, b.v)}; }
+inline lane_f32 operator*(lane_f32 a, lane_f32 b) { return {_mm_mul_ps(a.v, b.v)}; }
+inline lane_f32 operator/(lane_f32 a, lane_f32 b) { return {_mm_div_ps(a.v, b.v)}; }
+inline lane_f32 operator-(lane_f32 a) { return {_mm_xor_ps(a.v, _mm_set1_ps(-0.0f))}; }
+inline lane_f32 operator*(float s, lane_f32 a) { return LaneF32(s) * a; }
+inline lane_f32& operator+=(lane_f32& a, lane_f32 b) { a = a + b; return a; }
+inline lane_f32& operator-=(lane_f32& a, lane_f32 b) { a = a - b; return a; }
+inline lane_f32& operator*=(lane_f32& a, lane_f32 b) { a = a * b; return a; }
+
+inline lane_u32 operator<(lane_f32 a, lane_f32 b) { return {_mm_castps_si128(_mm_cmplt_ps(a.v, b.v))}; }
+inline lane_u32 operator<=(lane_f32 a, lane_f32 b) { return {_mm_castps_si128(_mm_cmple_ps(a.v, b.v))}; }
+inline lane_u32 operator>(lane_f32 a, lane_f32 b) { return {_mm_castps_si128(_mm_cmpgt_ps(a.v, b.v))}; }
+inline lane_u32 operator>=(lane_f32 a, lane_f32 b) { return {_mm_castps_si128(_mm_cmpge_ps(a.v, b.v))}; }
+inline lane_u32 operator==(lane_u32 a, lane_u32 b) { return {_mm_cmpeq_epi32(a.v, b.v)}; }
+
+inline lane_u32 operator+(lane_u32 a, lane_u32 b) { return {_mm_add_epi32(a.v, b.v)}; }
+inline lane_u32 operator-(lane_u32 a, lane_u32 b) { return {_mm_sub_epi32(a.v, b.v)}; }
+inline lane_u32 operator&(lane_u32 a, lane_u32 b) { return {_mm_and_si128(a.v, b.v)}; }
+inline lane_u32 operator|(lane_u32 a, lane_u32 b) { return {_mm_or_si128(a.v, b.v)}; }
+inline lane_u32 operator^(lane_u32 a, lane_u32 b) { return {_mm_xor_si128(a.v, b.v)}; }
+inline lane_u32 operator<<(lane_u32 a, int shift) { return {_mm_slli_epi32(a.v, shift)}; }
+inline lane_u32 operator>>(lane_u32 a, int shift) { return {_mm_srli_epi32(a.v, shift)}; }
+
+//Lanes where mask is set
+inline lane_f32 operator&(lane_u32 mask, lane_f32 a) { return {_mm_and_ps(_mm_castsi128_ps(mask.v), a.v)}; }
+//Bitwise xor of the float bits, e.g. with a sign mask
+inline lane_f32 operator^(lane_f32 a, lane_f32 b) { return {_mm_xor_ps(a.v, b.v)}; }
+
+//dest = mask ? source : dest, per lane
+inline void ConditionalAssign(lane_f32& dest, lane_u32 mask, lane_f32 source)
+{
+    __m128 m = _mm_castsi128_ps(mask.v);
+    dest.v = _mm_or_ps(_mm_andnot_ps(m, dest.v), _mm_and_ps(m, source.v));
+}
+
+inline void ConditionalAssign(lane_u32& dest, lane_u32 mask, lane_u32 source)
+{
+    dest.v = _mm_or_si128(_mm_andnot_si128(mask.v, dest.v), _mm_and_si128(mask.v, source.v));
+}
+
+inline lane_f32 Minimum(lane_f32 a, lane_f32 b) { return {_mm_min_ps(a.v, b.v)}; }
+inline lane_f32 Maximum(lane_f32 a, lane_f32 b) { return {_mm_max_ps(a.v, b.v)}; }
+inline lane_f32 Clamp(lane_f32 min, lane_f32 value, lane_f32 max) { return Minimum(Maximum(value, min), max); }
+inline lane_f32 SquareRoot(lane_f32 a) { return {_mm_sqrt_ps(a.v)}; }
+inline lane_f32 AbsoluteValue(lane_f32 a) { return {_mm_andnot_ps(_mm_set1_ps(-0.0f), a.v)}; }
+
+//Lanes with every bit of flag set
+inline lane_u32 HasFlags(lane_u32 flags, uint32_t flag)
+{
+    lane_u32 wanted = LaneU32(flag);
+    return (flags & wanted) == wanted;
+}
+
+inline lane_f32 ConvertToF32(lane_u32 a) { return {_mm_cvtepi32_ps(a.v)}; }  // as signed
+//SSE2 has no floor, truncate and step down the lanes where that rounded up. Result is signed.
+inline lane_u32 FloorToI32(lane_f32 a)
+{
+    __m128i truncated = _mm_cvttps_epi32(a.v);
+    __m128 roundedUp = _mm_cmpgt_ps(_mm_cvtepi32_ps(truncated), a.v);
+    return {_mm_add_epi32(truncated, _mm_castps_si128(roundedUp))};
+}
+
+inline bool AnyTrue(lane_u32 mask) { return _mm_movemask_epi8(mask.v) != 0; }
+inline bool AllTrue(lane_u32 mask) { return _mm_movemask_epi8(mask.v) == 0xFFFF; }
+//One bit per lane, lane 0 in bit 0
+inline uint32_t LaneMask(lane_u32 mask) { return (uint32_t)_mm_movemask_ps(_mm_castsi128_ps(mask.v)); }
+
+inline float HorizontalAdd(lane_f32 a) { return HorizontalAdd(a.v); }
+
+struct lane_v2
+{
+    lane_f32 x;
+    lane_f32 y;
+};
+
+inline lane_v2 operator+(lane_v2 a, lane_v2 b) { return {a.x + b.x, a.y + b.y}; }
+inline lane_v2 operator-(lane_v2 a, lane_v2 b) { return {a.x - b.x, a.y - b.y}; }
+inline lane_v2 operator*(lane_f32 s, lane_v2 a) { return {s * a.x, s * a.y}; }
+inline lane_f32 Inner(lane_v2 a, lane_v2 b) { return a.x * b.x + a.y * b.y; }
+
+#pragma endregion
+
+#pragma region 8 wide
+
+struct lane8_f32
+{
+    __m256 v;
+};
+
+struct lane8_u32
+{
+    __m256i v;
+};
+
+SIMD_TARGET_AVX2 inline lane8_f32 Lane8F32(float value) { return {_mm256_set1_ps(value)}; }
+SIMD_TARGET_AVX2 inline lane8_u32 Lane8U32(uint32_t value) { return {_mm256_set1_epi32((int)value)}; }
+SIMD_TARGET_AVX2 inline lane8_f32 Load8F32(const float* values) { return {_mm256_load_ps(values)}; }
+SIMD_TARGET_AVX2 inline lane8_u32 Load8U32(const uint32_t* values) { return {_mm256_load_si256((const __m256i*)values)}; }
+SIMD_TARGET_AVX2 inline void Store(float* dest, lane8_f32 value) { _mm256_store_ps(dest, value.v); }
+SIMD_TARGET_AVX2 inline void Store(uint32_t* dest, lane8_u32 value) { _mm256_store_si256((__m256i*)dest, value.v); }
+
+SIMD_TARGET_AVX2 inline lane8_f32 operator+(lane8_f32 a, lane8_f32 b) { return {_mm256_add_ps(a.v, b.v)}; }
+SIMD_TARGET_AVX2 inline lane8_f32 operator-(lane8_f32 a, lane8_f32 b) { return {_mm256_sub_ps(a.v, b.v)}; }
+SIMD_TARGET_AVX2 inline lane8_f32 operator*(lane8_f32 a, lane8_f32 b) { return {_mm256_mul_ps(a.v, b.v)}; }
+SIMD_TARGET_AVX2 inline lane8_f32 operator/(lane8_f32 a, lane8_f32 b) { return {_mm256_div_ps(a.v, b.v)}; }
+SIMD_TARGET_AVX2 inline lane8_f32 operator-(lane8_f32 a) { return {_mm256_xor_ps(a.v, _mm256_set1_ps(-0.0f))}; }
+SIMD_TARGET_AVX2 inline lane8_f32 operator*(float s, lane8_f32 a) { return Lane8F32(s) * a; }
+SIMD_TARGET_AVX2 inline lane8_f32& operator+=(lane8_f32& a, lane8_f32 b) { a = a + b; return a; }
+SIMD_TARGET_AVX2 inline lane8_f32& operator-=(lane8_f32& a, lane8_f32 b) { a = a - b; return a; }
+SIMD_TARGET_AVX2 inline lane8_f32& operator*=(lane8_f32& a, lane8_f32 b) { a = a * b; return a; }
+
+SIMD_TARGET_AVX2 inline lane8_u32 operator<(lane8_f32 a, lane8_f32 b)
+{
+    return {_mm256_castps_si256(_mm256_cmp_ps(a.v, b.v, _CMP_LT_OQ))};
+}
+SIMD_TARGET_AVX2 inline lane8_u32 operator<=(lane8_f32 a, lane8_f32 b)
+{
+    return {_mm256_castps_si256(_mm256_cmp_ps(a.v, b.v, _CMP_LE_OQ))};
+}
+SIMD_TARGET_AVX2 inline lane8_u32 operator>(lane8_f32 a, lane8_f32 b)
+{
+    return {_mm256_castps_si256(_mm256_cmp_ps(a.v, b.v, _CMP_GT_OQ))};
+}
+SIMD_TARGET_AVX2 inline lane8_u32 operator>=(lane8_f32 a, lane8_f32 b)
+{
+    return {_mm256_castps_si256(_mm256_cmp_ps(a.v, b.v, _CMP_GE_OQ))};
+}
+SIMD_TARGET_AVX2 inline lane8_u32 operator==(lane8_u32 a, lane8_u32 b) { return {_mm256_cmpeq_epi32(a.v, b.v)}; }
+
+SIMD_TARGET_AVX2 inline lane8_u32 operator+(lane8_u32 a, lane8_u32 b) { return {_mm256_add_epi32(a.v, b.v)}; }
+SIMD_TARGET_AVX2 inline lane8_u32 operator-(lane8_u32 a, lane8_u32 b) { return {_mm256_sub_epi32(a.v, b.v)}; }
+SIMD_TARGET_AVX2 inline lane8_u32 operator&(lane8_u32 a, lane8_u32 b) { return {_mm256_and_si256(a.v, b.v)}; }
+SIMD_TARGET_AVX2 inline lane8_u32 operator|(lane8_u32 a, lane8_u32 b) { return {_mm256_or_si256(a.v, b.v)}; }
+SIMD_TARGET_AVX2 inline lane8_u32 operator^(lane8_u32 a, lane8_u32 b) { return {_mm256_xor_si256(a.v, b.v)}; }
+SIMD_TARGET_AVX2 inline lane8_u32 operator<<(lane8_u32 a, int shift) { return {_mm256_slli_epi32(a.v, shift)}; }
+SIMD_TARGET_AVX2 inline lane8_u32 operator>>(lane8_u32 a, int shift) { return {_mm256_srli_epi32(a.v, shift)}; }
+
+SIMD_TARGET_AVX2 inline lane8_f32 operator&(lane8_u32 mask, lane8_f32 a)
+{
+    return {_mm256_and_ps(_mm256_castsi256_ps(mask.v), a.v)};
+}
+SIMD_TARGET_AVX2 inline lane8_f32 operator^(lane8_f32 a, lane8_f32 b) { return {_mm256_xor_ps(a.v, b.v)}; }
+
+SIMD_TARGET_AVX2 inline void ConditionalAssign(lane8_f32& dest, lane8_u32 mask, lane8_f32 source)
+{
+    dest.v = _mm256_blendv_ps(dest.v, source.v, _mm256_castsi256_ps(mask.v));
+}
+
+SIMD_TARGET_AVX2 inline void ConditionalAssign(lane8_u32& dest, lane8_u32 mask, lane8_u32 source)
+{
+    dest.v = _mm256_blendv_epi8(dest.v, source.v, mask.v);
+}
+
+SIMD_TARGET_AVX2 inline lane8_f32 Minimum(lane8_f32 a, lane8_f32 b) { return {_mm256_min_ps(a.v, b.v)}; }
+SIMD_TARGET_AVX2 inline lane8_f32 Maximum(lane8_f32 a, lane8_f32 b) { return {_mm256_max_ps(a.v, b.v)}; }
+SIMD_TARGET_AVX2 inline lane8_f32 Clamp(lane8_f32 min, lane8_f32 value, lane8_f32 max)
+{
+    return Minimum(Maximum(value, min), max);
+}
+SIMD_TARGET_AVX2 inline lane8_f32 SquareRoot(lane8_f32 a) { return {_mm256_sqrt_ps(a.v)}; }
+SIMD_TARGET_AVX2 inline lane8_f32 AbsoluteValue(lane8_f32 a) { return {_mm256_andnot_ps(_mm256_set1_ps(-0.0f), a.v)}; }
+
+SIMD_TARGET_AVX2 inline lane8_u32 HasFlags(lane8_u32 flags, uint32_t flag)
+{
+    lane8_u32 wanted = Lane8U32(flag);
+    return (flags & wanted) == wanted;
+}
+
+SIMD_TARGET_AVX2 inline lane8_f32 ConvertToF32(lane8_u32 a) { return {_mm256_cvtepi32_ps(a.v)}; }
+SIMD_TARGET_AVX2 inline lane8_u32 FloorToI32(lane8_f32 a) { return {_mm256_cvttps_epi32(_mm256_floor_ps(a.v))}; }
+
+SIMD_TARGET_AVX2 inline bool AnyTrue(lane8_u32 mask) { return !_mm256_testz_si256(mask.v, mask.v); }
+SIMD_TARGET_AVX2 inline uint32_t LaneMask(lane8_u32 mask)
+{
+    return (uint32_t)_mm256_movemask_ps(_mm256_castsi256_ps(mask.v));
+}
+
+struct lane8_v2
+{
+    lane8_f32 x;
+    lane8_f32 y;
+};
+
+SIMD_TARGET_AVX2 inline lane8_v2 operator+(lane8_v2 a, lane8_v2 b) { return {a.x + b.x, a.y + b.y}; }
+SIMD_TARGET_AVX2 inline lane8_v2 operator-(lane8_v2 a, lane8_v2 b) { return {a.x - b.x, a.y - b.y}; }
+SIMD_TARGET_AVX2 inline lane8_v2 operator*(lane8_f32 s, lane8_v2 a) { return {s * a.x, s * a.y}; }
+SIMD_TARGET_AVX2 inline lane8_f32 Inner(lane8_v2 a, lane8_v2 b) { return a.x * b.x + a.y * b.y; }
+
+#pragma endregion
@@ -0,0 +1,61 @@
+#pragma once
+#include "globals.h"
+#include "debug.h"
+
+/*
+    NOTE: Linear arena carved out of the memory the platform hands the game.
+    Nothing is ever freed individually, state lives as long as its arena.
+*/
+
+struct MemoryArena
+{
+    size_t size;
+    uint8_t* base;
+    size_t used;
+};
+
+inline void InitializeArena(MemoryArena& arena, size_t size, void* base)
+{
+    arena.size = size;
+    arena.base = (uint8_t*)base;
+    arena.used = 0;
+}
+
+inline void* PushSize_(MemoryArena& arena, size_t size, size_t alignment = 16)
+{
+    size_t alignmentOffset = 0;
+    size_t resultPointer = (size_t)(arena.base + arena.used);
+    if (resultPointer & (alignment - 1))
+    {
+        alignmentOffset = alignment - (resultPointer & (alignment - 1));
+    }
+
+    ASSERT(arena.used + alignmentOffset + size <= arena.size);
+    void* result = arena.base + arena.used + alignmentOffset;
+    arena.used += alignmentOffset + size;
+    return result;
+}
+
+#define PushStruct(arena, type) (type*)PushSize_(arena, sizeof(type), alignof(type) > 16 ? alignof(type) : 16)
+#define PushArray(arena, count, type) (type*)PushSize_(arena, (count) * sizeof(type), alignof(type) > 16 ? alignof(type) : 16)
+#define PushSize(arena, size) PushSize_(arena, size)
+//For arrays read with wider aligned loads than their element type needs, e.g. 32 for AVX
+#define PushArrayAligned(arena, count, type, alignment) (type*)PushSize_(arena, (count) * sizeof(type), alignment)
+
+//Scratch allocations that get rolled back together, e.g. a kernel built just for one offline job
+struct TemporaryMemory
+{
+    MemoryArena* arena;
+    size_t used;
+};
+
+inline TemporaryMemory BeginTemporaryMemory(MemoryArena& arena)
+{
+    return {&arena, arena.used};
+}
+
+inline void EndTemporaryMemory(TemporaryMemory temp)
+{
+    ASSERT(temp.arena->used >= temp.used);
+    temp.arena->used = temp.used;
+}
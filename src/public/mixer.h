@@ -0,0 +1,198 @@
+#pragma once
+#include "game.h"
+#include "memory.h"
+#include "wav_stream.h"
+#include "adpcm.h"
+#include "resampler.h"
+#include "dsp.h"
+#include "sample_convert.h"
+
+/*
+    NOTE: Game side software mixer.
+    Audio is rendered in fixed MIXER_BLOCK_FRAMES blocks no matter how the platform
+    slices the output, so effects always see whole blocks. Voices mix into their bus,
+    each bus runs its effect chain and is summed into the master bus, the master chain
+    (ending in a limiter) runs, and the block is converted to interleaved int16 as the
+    sound buffer regions ask for it.
+    A scheduler (the sequencer) can split a block at any sample: it is called with the
+    time of the next unrendered frame, applies what is due and says how long until the
+    next event, so voice changes land on exact samples rather than block or frame edges.
+    Positional voices are placed relative to a 2D listener: inverse distance rolloff faded
+    to silence at maxDistance, constant-power pan. One that ends up below
+    MIXER_VIRTUAL_GAIN goes virtual, it isn't mixed but its phase or play position keeps
+    moving, so hundreds of far away sources cost next to nothing and come back in time.
+    Voices come only from a fixed pool allocated in the arena at initialize. Playing
+    returns a VoiceHandle, slot index plus generation; freeing a slot bumps its
+    generation so stale handles just stop resolving. When the pool is full, the lowest
+    priority voice (virtual, then oldest first) is stolen if it is not above the new one.
+    Streamed wavs and in-memory adpcm sounds share the sampled voice path: at another
+    rate, or with pitch != 1, they go through the voice's resampler. A voice stepping
+    through its source faster than 1 is decimating, so it gets a kernel with the cutoff
+    pulled down to match: kernel i serves steps up to 2^i, the last one anything above.
+*/
+
+#define MIXER_BLOCK_FRAMES 256
+#define MIXER_KERNEL_COUNT 3        // resampler kernels for steps up to 1, 2 and beyond
+#define MIXER_MAX_VOICES 128        // default voice pool capacity
+#define MIXER_PRIORITY_LOW 64
+#define MIXER_PRIORITY_NORMAL 128
+#define MIXER_PRIORITY_HIGH 192
+#define MIXER_VIRTUAL_GAIN 0.001f   // -60dB
+
+enum class VoiceSource : uint8_t
+{
+    None,
+    Sine,
+    Stream,
+    Adpcm,
+};
+
+enum class MixerBus : uint8_t
+{
+    Master,
+    Music,
+    Effects,
+
+    Count
+};
+
+struct VoiceHandle
+{
+    uint32_t index;
+    uint32_t generation;    // 0 never resolves
+};
+
+struct MixerVoice
+{
+    // Pool bookkeeping
+    uint32_t generation;
+    uint32_t nextFree;
+    uint32_t activeSlot;    // position in Mixer::activeVoices
+    uint8_t priority;
+    uint64_t playSerial;    // counts plays, lower is older
+
+    VoiceSource source;
+    MixerBus bus;
+    bool loop;
+    float volume;
+
+    // Positional
+    bool isPositional;
+    bool isVirtual;
+    float x;
+    float y;
+    float minDistance;  // full volume inside, pan narrows to center
+    float maxDistance;  // silent from here on
+    float gainLeft;     // last applied pan gains, ramped from to avoid zipper noise
+    float gainRight;
+    double skipRemainder;   // fractional source frames while virtual and resampling
+
+    // Sine
+    float toneHz;
+    float phase;
+
+    // Stream
+    WavStream* stream;
+    uint64_t streamPosition;    // kept per voice, several voices may play one stream
+
+    // Adpcm
+    AdpcmSound* sound;
+    uint32_t framePosition;
+    AdpcmDecoder decoder;
+
+    // Stream and Adpcm
+    int sourceSamplesPerSecond;
+    float pitch;
+    bool resampling;    // once on, stays on so buffered input isn't skipped
+    ResamplerState resampler;
+};
+
+struct Mixer;
+// Applies events due at sampleTime and returns frames (1..maxFrames) until the next one
+typedef int (*MixerScheduleFunc)(void* user, Mixer& mixer, uint64_t sampleTime, int maxFrames);
+
+struct MixerBusState
+{
+    float* left;        // MIXER_BLOCK_FRAMES each
+    float* right;
+    float volume;
+    EffectChain effects;
+};
+
+struct Mixer
+{
+    bool isInitialized;
+    int samplesPerSecond;
+    ResamplerKernel kernels[MIXER_KERNEL_COUNT]; // shared by every voice, picked by step
+
+    MixerBusState buses[(int)MixerBus::Count];
+    Limiter* masterLimiter;
+    bool ditherEnabled;
+    DitherState dither;
+    int blockPosition;      // frames of the current master block already handed out
+    uint64_t sampleClock;   // frames rendered so far, the time of the next block's first frame
+
+    MixerScheduleFunc scheduler;
+    void* schedulerUser;
+
+    float listenerX;
+    float listenerY;
+    float* voiceLeft;       // scratch for positional voices, MIXER_BLOCK_FRAMES each
+    float* voiceRight;
+    int virtualVoiceCount;  // as of the last block
+
+    MixerVoice* voices;
+    uint32_t voiceCapacity;
+    uint32_t firstFreeVoice;
+    uint32_t* activeVoices; // dense list of playing slots, the only ones a block visits
+    uint32_t activeVoiceCount;
+    uint64_t playCount;
+};
+
+void MixerInitialize(Mixer& mixer, MemoryArena& arena, int samplesPerSecond,
+                     ResampleQuality quality = ResampleQuality::Medium, uint32_t voiceCapacity = MIXER_MAX_VOICES);
+auto MixerPlaySine(Mixer& mixer, float toneHz, float volume, MixerBus bus = MixerBus::Effects,
+                   uint8_t priority = MIXER_PRIORITY_NORMAL) -> VoiceHandle;
+auto MixerPlayStream(Mixer& mixer, WavStream* stream, float volume, bool loop, MixerBus bus = MixerBus::Music,
+                     uint8_t priority = MIXER_PRIORITY_HIGH) -> VoiceHandle;
+auto MixerPlaySound(Mixer& mixer, AdpcmSound* sound, float volume, bool loop, MixerBus bus = MixerBus::Effects,
+                    uint8_t priority = MIXER_PRIORITY_NORMAL) -> VoiceHandle;
+//nullptr once the voice has finished or been stolen
+inline auto MixerGetVoice(Mixer& mixer, VoiceHandle handle) -> MixerVoice*
+{
+    if (handle.index < mixer.voiceCapacity && mixer.voices[handle.index].generation == handle.generation &&
+        mixer.voices[handle.index].source != VoiceSource::None)
+    {
+        return &mixer.voices[handle.index];
+    }
+    return nullptr;
+}
+inline auto MixerIsPlaying(Mixer& mixer, VoiceHandle handle) -> bool
+{
+    return MixerGetVoice(mixer, handle) != nullptr;
+}
+void MixerStop(Mixer& mixer, VoiceHandle handle);
+void MixerSetVolume(Mixer& mixer, VoiceHandle handle, float volume);
+void MixerSetTone(Mixer& mixer, VoiceHandle handle, float toneHz);
+void MixerSetPitch(Mixer& mixer, VoiceHandle handle, float pitch);
+void MixerSetPosition(Mixer& mixer, VoiceHandle handle, float x, float y);
+void MixerSetDistance(Mixer& mixer, VoiceHandle handle, float minDistance, float maxDistance);
+inline void MixerSetListener(Mixer& mixer, float x, float y)
+{
+    mixer.listenerX = x;
+    mixer.listenerY = y;
+}
+inline auto MixerGetEffects(Mixer& mixer, MixerBus bus) -> EffectChain&
+{
+    return mixer.buses[(int)bus].effects;
+}
+inline void MixerSetDither(Mixer& mixer, bool enabled)
+{
+    mixer.ditherEnabled = enabled;
+}
+inline void MixerSetScheduler(Mixer& mixer, MixerScheduleFunc scheduler, void* user)
+{
+    mixer.scheduler = scheduler;
+    mixer.schedulerUser = user;
+}
+void MixerOutput(Mixer& mixer, SoundOutputBuffer& soundBuffer);
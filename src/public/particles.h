@@ -0,0 +1,93 @@
+#pragma once
+#include "game.h"
+#include "memory.h"
+#include "world.h"
+#include "random.h"
+
+/*
+    NOTE: Particles are structure of arrays like the entities, but they never touch the
+    world: positions are floats relative to the system's origin and the pool is a ring.
+    Spawning always takes the next PARTICLE_LANES slots after the last spawn, so once the
+    ring is full the oldest particles are recycled first. Dead slots stay in place with
+    no life left and are skipped with masks, nothing is ever compacted.
+    UpdateParticles walks the pool in batches of PARTICLE_BATCH_SIZE on the work queue,
+    8 wide with AVX2 or as two 4 wide SSE2 halves. One pass integrates, ages and fades
+    each particle, and writes an 8 byte render command for every live one that is on
+    screen into its batch's slice of the command array, sorted by the screen band (a
+    power of two run of rows, at most PARTICLE_RENDER_BANDS of them) of its top row.
+    RenderParticles gives each job a run of bands and it adds the 2x2 quads of just
+    those bands' commands, plus the band above for quads reaching down into its first
+    row, with saturating adds. Saturating adds of positive colors don't depend on
+    order, so the image is the same however the jobs ran.
+    Spawning runs on the calling thread from the system's RandomStream_Particles
+    series, with the SSE2 halves only, so a replay gets the same particles on any CPU.
+    The AVX2 update may fuse multiply-adds where SSE2 rounds twice, so the two paths can
+    drift apart in the last bits. Particles are only drawn, nothing reads them back.
+*/
+
+#define PARTICLE_LANES 8
+#define PARTICLE_BATCH_SIZE 4096    // particles per claimed batch, a multiple of PARTICLE_LANES
+#define PARTICLE_MAX_JOBS 64
+#define PARTICLE_RENDER_BANDS 64
+#define PARTICLE_SIDE_IN_PIXELS 2
+
+struct ParticleRenderCommand
+{
+    uint32_t pixel;         // y << 16 | x of the quad's top left, always fully on screen
+    uint32_t color;         // 0x00RRGGBB, already faded
+};
+
+struct ParticleEmitter
+{
+    v2 position;            // meters from the system origin
+    float positionSpread;   // meters either way on each axis
+    v2 velocity;            // meters per second
+    float speedSpread;      // up to this many meters per second more, in any direction
+    float lifetime;         // seconds
+    float lifetimeSpread;   // seconds either way
+    v3 color;               // 0 to 1 per channel at full life
+};
+
+struct ParticleCamera
+{
+    v2 offset;              // camera position minus the system origin, meters
+    float metersToPixels;
+    int32_t width;          // of the buffer that will be rendered into
+    int32_t height;
+};
+
+struct ParticleSystem
+{
+    WorldPosition origin;
+    float drag;             // fraction of velocity lost per second
+    uint32_t capacity;      // multiple of PARTICLE_BATCH_SIZE
+    uint32_t count;         // slots ever spawned into, at most capacity
+    uint32_t nextSpawn;     // ring position, multiple of PARTICLE_LANES
+    RandomSeries8 random;
+
+    float* positionX;       // meters from origin
+    float* positionY;
+    float* velocityX;
+    float* velocityY;
+    float* life;            // 1 when spawned, dead at 0 or below
+    float* lifeRate;        // life lost per second, 1 / lifetime
+    uint32_t* color;        // 0x00RRGGBB at full life
+
+    ParticleRenderCommand* commands;    // capacity, PARTICLE_BATCH_SIZE per batch, sorted by band
+    ParticleRenderCommand* unsortedCommands;    // same layout, written before the band sort
+    uint32_t* bandEnds;                 // PARTICLE_RENDER_BANDS per batch, command offsets in the batch
+    uint32_t bandShift;                 // row >> bandShift is the band, from the last update's camera
+    uint32_t bandCount;                 // bands the last update's camera covers
+    uint32_t liveCount;                 // as of the last update
+};
+
+//capacity is rounded up to a whole number of batches
+void InitializeParticleSystem(ParticleSystem& system, MemoryArena& arena, uint32_t capacity, WorldPosition origin,
+                              float drag, uint64_t seed);
+//Spawns count rounded up to PARTICLE_LANES, recycling the oldest when the ring is full
+void SpawnParticles(ParticleSystem& system, const ParticleEmitter& emitter, uint32_t count);
+//Moves, ages and fades every particle and rebuilds the render commands for the camera
+void UpdateParticles(ParticleSystem& system, float seconds, const ParticleCamera& camera,
+                     PlatformWorkQueue* workQueue);
+//Adds the commands from the last update into the buffer, which has to match the camera's size
+void RenderParticles(ParticleSystem& system, OffscreenBuffer& buffer, PlatformWorkQueue* workQueue);
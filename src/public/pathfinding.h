@@ -0,0 +1,113 @@
+#pragma once
+#include "game.h"
+#include "memory.h"
+#include "tile_map.h"
+
+/*
+    NOTE: Grid A* over the tile map, 8-connected, diagonals can't cut wall corners.
+    Only floor tiles are walkable. Costs are integers (10 straight, 14 diagonal) with
+    the octile distance as the heuristic, so a search is exact and repeatable.
+    Each search runs inside a square window of tiles around its start and goal that
+    is copied out of the tile map first; a pair that doesn't fit in PATH_MAX_WINDOW_DIM
+    is refused. A window that is too small can miss a detour outside it: that is
+    reported as no path.
+    All the memory comes from Pathfinder, allocated once: one search context per
+    thread that can run searches, each with node arrays for the largest window and
+    an indexed binary heap. Node state is tagged with a per-search stamp instead of
+    being cleared, so a query allocates and clears nothing.
+    Callers own their PathRequest and queue a pointer to it, and must keep it alive
+    until its status leaves PathStatus_Pending. RunPathRequests takes queued requests
+    in order on every worker until the queue or the time budget runs out, whatever is
+    left waits for the next call. Searches look at the clock every
+    PATH_EXPANSIONS_PER_CHECK expansions too: one that runs out of budget is parked in
+    its context, open set and all, and carries on first thing in the next call, so a
+    frame only goes over by one slice of expansions per worker. A parked search keeps
+    the window it copied when it started, later tile map edits don't reach it.
+*/
+
+#define PATH_MAX_WINDOW_DIM 128     // tiles
+#define PATH_WINDOW_MARGIN 16       // tiles added around the start/goal box for detours
+#define PATH_MAX_LENGTH 256         // tiles kept per path, start and goal included
+#define PATH_EXPANSIONS_PER_CHECK 256
+
+enum PathStatus : uint32_t
+{
+    PathStatus_Pending,
+    PathStatus_Found,
+    PathStatus_NoPath,      // or start/goal aren't floor
+    PathStatus_TooFar,      // start and goal don't fit in one search window
+};
+
+struct PathRequest
+{
+    int32_t startX;
+    int32_t startY;
+    int32_t goalX;
+    int32_t goalY;
+
+    PathStatus status;
+    uint32_t cost;          // 10 per straight step, 14 per diagonal
+    uint32_t totalLength;   // tiles on the whole path
+    uint32_t length;        // tiles stored, the first PATH_MAX_LENGTH of it
+    int32_t tileX[PATH_MAX_LENGTH];
+    int32_t tileY[PATH_MAX_LENGTH];
+};
+
+// Window nodes are row major, y up like the tile map
+struct PathWindow
+{
+    int32_t minX;
+    int32_t minY;
+    uint32_t width;
+    uint32_t height;
+};
+
+//Estimate (cost so far + heuristic) in the top half, ties go to the larger cost so far
+struct PathHeapEntry
+{
+    uint64_t key;
+    uint32_t node;
+};
+
+struct PathSearchContext
+{
+    uint32_t stamp;
+    uint32_t* nodeStamp;    // node is part of the current search when == stamp
+    uint32_t* costSoFar;
+    uint32_t* parent;
+    uint32_t* heapIndex;    // PATH_NODE_CLOSED once expanded
+    uint8_t* walkable;      // this search's window, copied out of the tile map
+    PathHeapEntry* heap;
+    uint32_t heapCount;
+
+    PathRequest* suspended; // search that ran out of budget, resumed by the next RunPathRequests
+    PathWindow window;
+    uint32_t startNode;
+    uint32_t goalNode;
+
+    uint32_t searches;
+    uint32_t expandedNodes;
+};
+
+struct Pathfinder
+{
+    uint32_t contextCount;
+    PathSearchContext* contexts;
+
+    PathRequest** queue;    // ring of pending requests
+    uint32_t queueCapacity;
+    uint32_t queueFirst;
+    uint32_t queueCount;
+    uint32_t suspendedCount;    // searches parked in a context, out of the queue but not finished
+};
+
+//contextCount is how many threads may search at once, normally PlatformGetWorkerCount
+void InitializePathfinder(Pathfinder& pathfinder, MemoryArena& arena, uint32_t contextCount, uint32_t queueCapacity);
+//Marks the request pending and queues it, false when the queue is full
+auto QueuePathRequest(Pathfinder& pathfinder, PathRequest& request) -> bool;
+//Searches on the calling thread, no queue involved. The context can't have a suspended search.
+void FindPath(PathSearchContext& context, TileMap& tileMap, PathRequest& request);
+//Returns how many requests finished, suspended searches included. The tile map must not change until it returns.
+//Keep calling while queueCount or suspendedCount is non zero to finish everything.
+auto RunPathRequests(Pathfinder& pathfinder, TileMap& tileMap, PlatformWorkQueue* workQueue, float budgetSeconds)
+    -> uint32_t;
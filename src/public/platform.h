@@ -0,0 +1,12 @@
+#pragma once
+#include "game.h"
+
+/*
+    NOTE: Platform layer pieces shared by the windowed and headless entry points
+*/
+
+auto PlatformAllocateGameMemory(GameMemory& memory) -> bool;
+void PlatformFreeGameMemory(GameMemory& memory);
+//Starts threadCount workers that live until the process exits, 0 gives a queue that runs everything on the caller
+auto PlatformCreateWorkQueue(uint32_t threadCount) -> PlatformWorkQueue*;
+auto PlatformGetProcessorCount() -> uint32_t;
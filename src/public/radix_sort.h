@@ -0,0 +1,12 @@
+#pragma once
+#include "globals.h"
+
+/*
+    NOTE: LSD radix sort of uint32 keys carrying a uint32 value each, 8 bits per pass.
+    Stable, and it only runs as many passes as maxKey needs, so small key ranges (cell
+    indices, store indices) sort in two passes. The caller provides scratch arrays the
+    same size as the input; the result always ends up back in keys/values.
+*/
+
+void RadixSort(uint32_t* keys, uint32_t* values, uint32_t* scratchKeys, uint32_t* scratchValues, uint32_t count,
+               uint32_t maxKey);
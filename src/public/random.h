@@ -0,0 +1,177 @@
+#pragma once
+#include "globals.h"
+#include "debug.h"
+#include "lane.h"
+
+/*
+    NOTE: xoshiro128** random series, 16 bytes of state and a handful of shifts, adds
+    and xors per value. Multiplies are by 5 and 9 only, so the wide versions do them
+    with shifts and run on plain SSE2.
+    Every series comes from RandomSeed: a base seed, the subsystem's stream and an index
+    inside that stream, mixed with splitmix64. Streams never share a seed, so adding
+    draws to one subsystem doesn't shift any other. Work that is split across threads
+    seeds per work item (chunk, emitter, batch), never per thread, so results don't
+    depend on how many workers ran it or in what order.
+    RandomSeries8 is eight series side by side, lane i being exactly the scalar series
+    with index 8 * index + i. RandomNext8 draws all eight with AVX2. RandomNext4 draws
+    one half with SSE2; drawing half 0 then half 1 gives the same eight values and
+    leaves the same state, so the two paths can be picked per machine.
+    Unilateral floats keep the top 24 bits: [0, 1) in steps of 2^-24.
+*/
+
+enum RandomStream : uint32_t
+{
+    RandomStream_Entities,
+    RandomStream_Paths,
+    RandomStream_WorldGen,
+    RandomStream_Particles,
+    RandomStream_Audio,
+    RandomStream_Benchmark,
+};
+
+struct RandomSeries
+{
+    uint32_t state[4];
+};
+
+struct alignas(32) RandomSeries8
+{
+    uint32_t state[4][LANE8_WIDTH];
+};
+
+auto RandomSeed(uint64_t seed, RandomStream stream, uint64_t index) -> RandomSeries;
+auto RandomSeed8(uint64_t seed, RandomStream stream, uint64_t index) -> RandomSeries8;
+
+//Fills count floats in [0, 1), count needs to be a multiple of 8
+void FillRandomUnilateral(RandomSeries8& series, float* dest, uint32_t count);
+
+#pragma region Scalar
+
+inline uint32_t RotateLeft(uint32_t value, int shift)
+{
+    return (value << shift) | (value >> (32 - shift));
+}
+
+inline uint32_t RandomNext(RandomSeries& series)
+{
+    uint32_t* s = series.state;
+    uint32_t result = RotateLeft(s[1] * 5, 7) * 9;
+    uint32_t t = s[1] << 9;
+    s[2] ^= s[0];
+    s[3] ^= s[1];
+    s[1] ^= s[2];
+    s[0] ^= s[3];
+    s[2] ^= t;
+    s[3] = RotateLeft(s[3], 11);
+    return result;
+}
+
+inline float RandomUnilateral(RandomSeries& series)
+{
+    return (float)(RandomNext(series) >> 8) * (1.0f / 16777216.0f);
+}
+
+inline float RandomBilateral(RandomSeries& series)
+{
+    return 2.0f * RandomUnilateral(series) - 1.0f;
+}
+
+//[0, count) without the modulo bias of the low bits
+inline uint32_t RandomChoice(RandomSeries& series, uint32_t count)
+{
+    return (uint32_t)(((uint64_t)RandomNext(series) * count) >> 32);
+}
+
+inline float RandomBetween(RandomSeries& series, float min, float max)
+{
+    return min + (max - min) * RandomUnilateral(series);
+}
+
+#pragma endregion Scalar
+
+#pragma region Wide
+
+inline lane_u32 RotateLeft(lane_u32 value, int shift)
+{
+    return (value << shift) | (value >> (32 - shift));
+}
+
+//half 0 is lanes 0-3, half 1 lanes 4-7
+inline lane_u32 RandomNext4(RandomSeries8& series, uint32_t half)
+{
+    ASSERT(half < 2);
+    half *= LANE_WIDTH;
+    lane_u32 s0 = LoadU32(series.state[0] + half);
+    lane_u32 s1 = LoadU32(series.state[1] + half);
+    lane_u32 s2 = LoadU32(series.state[2] + half);
+    lane_u32 s3 = LoadU32(series.state[3] + half);
+
+    lane_u32 times5 = (s1 << 2) + s1;
+    lane_u32 rotated = RotateLeft(times5, 7);
+    lane_u32 result = (rotated << 3) + rotated;
+    lane_u32 t = s1 << 9;
+    s2 = s2 ^ s0;
+    s3 = s3 ^ s1;
+    s1 = s1 ^ s2;
+    s0 = s0 ^ s3;
+    s2 = s2 ^ t;
+    s3 = RotateLeft(s3, 11);
+
+    Store(series.state[0] + half, s0);
+    Store(series.state[1] + half, s1);
+    Store(series.state[2] + half, s2);
+    Store(series.state[3] + half, s3);
+    return result;
+}
+
+inline lane_f32 RandomUnilateral4(RandomSeries8& series, uint32_t half)
+{
+    return ConvertToF32(RandomNext4(series, half) >> 8) * LaneF32(1.0f / 16777216.0f);
+}
+
+inline lane_f32 RandomBilateral4(RandomSeries8& series, uint32_t half)
+{
+    return LaneF32(2.0f) * RandomUnilateral4(series, half) - LaneF32(1.0f);
+}
+
+SIMD_TARGET_AVX2 inline lane8_u32 RotateLeft(lane8_u32 value, int shift)
+{
+    return (value << shift) | (value >> (32 - shift));
+}
+
+SIMD_TARGET_AVX2 inline lane8_u32 RandomNext8(RandomSeries8& series)
+{
+    lane8_u32 s0 = Load8U32(series.state[0]);
+    lane8_u32 s1 = Load8U32(series.state[1]);
+    lane8_u32 s2 = Load8U32(series.state[2]);
+    lane8_u32 s3 = Load8U32(series.state[3]);
+
+    lane8_u32 times5 = (s1 << 2) + s1;
+    lane8_u32 rotated = RotateLeft(times5, 7);
+    lane8_u32 result = (rotated << 3) + rotated;
+    lane8_u32 t = s1 << 9;
+    s2 = s2 ^ s0;
+    s3 = s3 ^ s1;
+    s1 = s1 ^ s2;
+    s0 = s0 ^ s3;
+    s2 = s2 ^ t;
+    s3 = RotateLeft(s3, 11);
+
+    Store(series.state[0], s0);
+    Store(series.state[1], s1);
+    Store(series.state[2], s2);
+    Store(series.state[3], s3);
+    return result;
+}
+
+SIMD_TARGET_AVX2 inline lane8_f32 RandomUnilateral8(RandomSeries8& series)
+{
+    return ConvertToF32(RandomNext8(series) >> 8) * Lane8F32(1.0f / 16777216.0f);
+}
+
+SIMD_TARGET_AVX2 inline lane8_f32 RandomBilateral8(RandomSeries8& series)
+{
+    return Lane8F32(2.0f) * RandomUnilateral8(series) - Lane8F32(1.0f);
+}
+
+#pragma endregion Wide
@@ -0,0 +1,67 @@
+#pragma once
+#include "memory.h"
+
+/*
+    NOTE: Sample rate conversion and pitch shifting.
+    Polyphase windowed sinc (Kaiser window). The kernel is stored as phases+1 rows of
+    taps coefficients and the fractional position blends two adjacent rows, so any
+    ratio works with the same table - one kernel per quality preset serves every
+    voice. Inner loops are SSE, or AVX2/FMA when the CPU has it (picked at runtime).
+
+    Presets trade CPU for fidelity:
+        Linear  - 2 point interpolation, no table
+        Low     - 8 taps,  32 phases
+        Medium  - 16 taps, 64 phases
+        High    - 32 taps, 256 phases
+*/
+
+enum class ResampleQuality : uint8_t
+{
+    Linear,
+    Low,
+    Medium,
+    High,
+};
+
+#define RESAMPLER_MAX_TAPS 32
+#define RESAMPLER_INPUT_FRAMES 512
+
+typedef void (*ResamplerDotFunc)(const float* row0, const float* row1, float blend,
+                                 const float* left, const float* right, int taps, float* outLeft, float* outRight);
+
+struct ResamplerKernel
+{
+    ResampleQuality quality;
+    int taps;
+    int phases;
+    float* coefficients; // (phases + 1) * taps
+    ResamplerDotFunc dot;
+};
+
+//Pulls planar input for a streaming resampler. Buffers arrive zeroed, returns frames written (0 = end of source).
+typedef int (*ResamplerPullFunc)(void* user, float* left, float* right, int frameCount);
+
+struct ResamplerState
+{
+    const ResamplerKernel* kernel;
+    double step;        // input frames consumed per output frame (rate ratio * pitch)
+    double position;    // read position inside the input buffer
+    int inputCount;
+    float* inputLeft;   // RESAMPLER_MAX_TAPS + RESAMPLER_INPUT_FRAMES each
+    float* inputRight;
+};
+
+//cutoff is relative to the input rate, 0.5 is Nyquist. Use ~0.45 for realtime banks, scale it down when decimating.
+void ResamplerBuildKernel(ResamplerKernel& kernel, MemoryArena& arena, ResampleQuality quality, float cutoff);
+
+void ResamplerInitialize(ResamplerState& state, MemoryArena& arena);
+void ResamplerReset(ResamplerState& state, const ResamplerKernel* kernel, int inputRate, int outputRate, float pitch);
+void ResamplerSetRatio(ResamplerState& state, int inputRate, int outputRate, float pitch);
+//Adds up to frameCount resampled frames (scaled by volume) into out. Returns frames produced, short once the source ends.
+int ResamplerMix(ResamplerState& state, ResamplerPullFunc pull, void* user,
+                 float* outLeft, float* outRight, int frameCount, float volume);
+
+//Offline conversion of a whole planar buffer (asset import). Builds a kernel with the right anti-alias cutoff in temp memory.
+int ResampleBuffer(MemoryArena& tempArena, ResampleQuality quality,
+                   const float* inLeft, const float* inRight, int inFrameCount, int inputRate,
+                   float* outLeft, float* outRight, int outCapacity, int outputRate);
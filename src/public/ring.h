@@ -0,0 +1,106 @@
+#pragma once
+#include "globals.h"
+#include "simd.h"
+#include <string.h>
+
+/*
+    NOTE: Byte ring buffer helpers.
+    A read or write that wraps is split once into at most two contiguous spans, then
+    each span is a single memcpy/memset. Nothing walks the ring per sample.
+    Clears bigger than a core's cache use streaming stores so they don't evict whatever
+    the caller is working on; below that plain memset wins, the lines are still hot.
+*/
+
+#define RING_STREAMING_BYTES (1024 * 1024)
+
+struct RingSpan
+{
+    void* first;
+    uint32_t firstSize;
+    void* second;       // start of the ring when the range wraps, else nullptr
+    uint32_t secondSize;
+};
+
+inline auto RingSplit(void* base, uint32_t capacity, uint32_t offset, uint32_t size) -> RingSpan
+{
+    RingSpan span = {};
+    if (offset >= capacity || size > capacity)
+    {
+        return span;
+    }
+
+    uint32_t untilEnd = capacity - offset;
+    span.first = (uint8_t*)base + offset;
+    span.firstSize = size < untilEnd ? size : untilEnd;
+    span.second = span.firstSize < size ? base : nullptr;
+    span.secondSize = size - span.firstSize;
+    return span;
+}
+
+inline void RingSpanCopyIn(const RingSpan& span, const void* source)
+{
+    memcpy(span.first, source, span.firstSize);
+    if (span.secondSize)
+    {
+        memcpy(span.second, (const uint8_t*)source + span.firstSize, span.secondSize);
+    }
+}
+
+inline void RingSpanCopyOut(const RingSpan& span, void* dest)
+{
+    memcpy(dest, span.first, span.firstSize);
+    if (span.secondSize)
+    {
+        memcpy((uint8_t*)dest + span.firstSize, span.second, span.secondSize);
+    }
+}
+
+inline void MemoryZeroStreaming(void* dest, size_t size)
+{
+    uint8_t* at = (uint8_t*)dest;
+    size_t head = (16 - ((size_t)at & 15)) & 15;
+    if (size < head + 16)
+    {
+        memset(at, 0, size);
+        return;
+    }
+
+    memset(at, 0, head);
+    at += head;
+    size -= head;
+
+    __m128i zero = _mm_setzero_si128();
+    size_t wide = size & ~(size_t)63;
+    for (size_t i = 0; i < wide; i += 64)
+    {
+        _mm_stream_si128((__m128i*)(at + i), zero);
+        _mm_stream_si128((__m128i*)(at + i + 16), zero);
+        _mm_stream_si128((__m128i*)(at + i + 32), zero);
+        _mm_stream_si128((__m128i*)(at + i + 48), zero);
+    }
+    // Streaming stores are weakly ordered, fence before anyone else reads the ring
+    _mm_sfence();
+    memset(at + wide, 0, size - wide);
+}
+
+inline void RingSpanZero(const RingSpan& span)
+{
+    if (span.firstSize >= RING_STREAMING_BYTES) MemoryZeroStreaming(span.first, span.firstSize);
+    else memset(span.first, 0, span.firstSize);
+
+    if (span.secondSize >= RING_STREAMING_BYTES) MemoryZeroStreaming(span.second, span.secondSize);
+    else if (span.secondSize) memset(span.second, 0, span.secondSize);
+}
+
+//Both return the offset just past the data
+inline auto RingWrite(void* base, uint32_t capacity, uint32_t offset, const void* source, uint32_t size) -> uint32_t
+{
+    RingSpanCopyIn(RingSplit(base, capacity, offset, size), source);
+    return (uint32_t)(((uint64_t)offset + size) % capacity);
+}
+
+inline auto RingRead(const void* base, uint32_t capacity, uint32_t offset, void* dest, uint32_t size) -> uint32_t
+{
+    RingSpanCopyOut(RingSplit((void*)base, capacity, offset, size), dest);
+    return (uint32_t)(((uint64_t)offset + size) % capacity);
+}
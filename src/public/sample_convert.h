@@ -0,0 +1,22 @@
+#pragma once
+#include "globals.h"
+#include "random.h"
+
+/*
+    NOTE: Output stage shared by the mixer and every backend that needs device samples.
+    One pass over planar float: master gain, optional TPDF dither, round, saturate and
+    interleave into int16 stereo. Runs 8 frames per iteration with SSE2, clamping in
+    float so loud input never wraps. Dither noise comes from the RandomStream_Audio
+    series, drawn 4 lanes at a time from alternating halves.
+*/
+
+struct DitherState
+{
+    RandomSeries8 random;
+};
+
+void DitherInitialize(DitherState& dither, uint64_t seed);
+
+//Full scale float is +-1.0. dither may be null for a plain rounded conversion.
+void ConvertToInt16Interleaved(const float* left, const float* right, int16_t* out, int frameCount,
+                               float gain, DitherState* dither);
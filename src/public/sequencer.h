@@ -0,0 +1,87 @@
+#pragma once
+#include "memory.h"
+#include "mixer.h"
+#include "adpcm.h"
+
+/*
+    NOTE: Tracker style music sequencer.
+    A song is a list of patterns played in order, each pattern a grid of rows by channels
+    of cells. Everything lives in the arena the song was created from. The sequencer
+    hooks into the mixer as its scheduler, so every row lands on the exact sample it is
+    due at instead of on the next frame or mixer block.
+*/
+
+#define SEQUENCER_MAX_CHANNELS 8
+#define NOTE_NONE 0     // cell does nothing
+#define NOTE_OFF 255    // cell stops the channel, notes 1..127 are midi numbers
+
+struct TrackerCell
+{
+    uint8_t note;
+    uint8_t instrument;
+    uint8_t volume;     // 1..64, 0 keeps the instrument volume
+    uint8_t pad;
+};
+
+struct TrackerPattern
+{
+    int rowCount;
+    TrackerCell* cells; // rowCount * song channelCount, row major
+};
+
+enum class InstrumentType : uint8_t
+{
+    Sine,
+    Sound,
+};
+
+struct TrackerInstrument
+{
+    InstrumentType type;
+    MixerBus bus;
+    uint8_t baseNote;   // the note a sound plays back at its recorded pitch
+    uint8_t priority;
+    float volume;
+    AdpcmSound* sound;
+};
+
+struct TrackerSong
+{
+    int channelCount;
+    float beatsPerMinute;
+    int rowsPerBeat;
+    bool loop;
+
+    int patternCount;
+    TrackerPattern* patterns;
+    int orderCount;
+    uint8_t* orders;    // pattern index per position
+    int instrumentCount;
+    TrackerInstrument* instruments;
+};
+
+struct Sequencer
+{
+    TrackerSong* song;
+    bool isPlaying;
+    int order;
+    int row;
+
+    uint64_t startSample;   // mixer time of the first row
+    uint64_t rowsPlayed;    // row times come from this so they never drift
+    double samplesPerRow;
+    uint64_t nextRowSample;
+
+    VoiceHandle channelVoices[SEQUENCER_MAX_CHANNELS];
+};
+
+auto TrackerCreateSong(MemoryArena& arena, int channelCount, int patternCount, int rowsPerPattern,
+                       int orderCount, int instrumentCount) -> TrackerSong*;
+inline auto TrackerGetCell(TrackerSong& song, int pattern, int row, int channel) -> TrackerCell&
+{
+    return song.patterns[pattern].cells[row * song.channelCount + channel];
+}
+
+//Starts at the mixer's next rendered frame and installs the sequencer as the mixer's scheduler
+void SequencerPlay(Sequencer& sequencer, Mixer& mixer, TrackerSong* song);
+void SequencerStop(Sequencer& sequencer, Mixer& mixer);
@@ -0,0 +1,44 @@
+#pragma once
+#include "memory.h"
+#include "world.h"
+#include "entity.h"
+
+/*
+    NOTE: Only the part of the world around the camera is simulated. Each frame
+    BeginSimRegion walks the chunks overlapping the region bounds, pulls the entities
+    inside them out of the entity store into compact SoA columns (from a scratch arena,
+    usually the transient one), with positions as plain floats relative to the region
+    origin. Simulation runs over just those columns, SIM_LANES at a time, and
+    EndSimRegion writes them back, moving entities between chunk lists when they have
+    crossed a chunk edge. Everything outside the bounds stays dormant, so a frame costs
+    what is near the camera no matter how big the world gets.
+    Don't add or remove entities between Begin and End, the region holds store slots.
+*/
+
+#define SIM_LANES 4
+
+struct SimRegion
+{
+    WorldPosition origin;
+    v2 halfSize;            // meters either side of the origin
+
+    uint32_t count;
+    uint32_t capacity;      // multiple of SIM_LANES, lanes past count are zeroed and never written back
+
+    float* positionX;       // meters from origin
+    float* positionY;
+    float* velocityX;
+    float* velocityY;
+    float* radius;
+    uint32_t* flags;
+    uint32_t* entitySlots;
+};
+
+auto BeginSimRegion(MemoryArena& simArena, World& world, EntityStore& store, WorldPosition origin, v2 halfSize)
+    -> SimRegion*;
+void EndSimRegion(SimRegion& region, World& world, EntityStore& store);
+
+//position += velocity * seconds for EntityFlag_Moving entities
+void MoveSimEntities(SimRegion& region, float seconds);
+//Flips the velocity of EntityFlag_Confined entities outside the box (region relative) that still head out
+void ConfineSimEntities(SimRegion& region, v2 minCorner, v2 maxCorner);
@@ -0,0 +1,30 @@
+#pragma once
+#include <immintrin.h>
+
+/*
+    NOTE: SSE2 is always there on x64 so it is the baseline. Wider paths are compiled
+    per function with a target attribute and picked at runtime with CpuHasAvx2, the
+    build itself never assumes more than SSE2.
+*/
+
+#define SIMD_TARGET_AVX2 __attribute__((target("avx2,fma")))
+
+inline bool CpuHasAvx2()
+{
+    static int hasAvx2 = -1;
+    if (hasAvx2 < 0)
+    {
+        __builtin_cpu_init();
+        hasAvx2 = __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma");
+    }
+    return hasAvx2 != 0;
+}
+
+inline float HorizontalAdd(__m128 value)
+{
+    __m128 shuffled = _mm_shuffle_ps(value, value, _MM_SHUFFLE(2, 3, 0, 1));
+    __m128 sums = _mm_add_ps(value, shuffled);
+    shuffled = _mm_movehl_ps(shuffled, sums);
+    sums = _mm_add_ss(sums, shuffled);
+    return _mm_cvtss_f32(sums);
+}
@@ -0,0 +1,79 @@
+#pragma once
+#include "memory.h"
+
+/*
+    NOTE: Sparse tile map. Tiles live in TILE_CHUNK_DIM x TILE_CHUNK_DIM chunks that are
+    only allocated (from the map's arena) when something is written to them, so an empty
+    world costs nothing past the hash table.
+    Chunks are found through an open addressed table of {chunk x, chunk y, pointer}
+    slots with linear probing, a lookup is one hash and usually one cache line. The
+    table doubles from the arena when it gets 3/4 full; the old one is simply abandoned.
+    Rendering walks the visible area chunk by chunk so each chunk is looked up once.
+    A chunk is also the unit the world files entities under, see world.h.
+    Chunks can be filled on worker threads (world_gen.h). Only the main thread touches
+    the table and creates chunks; a worker is handed a chunk in TileChunkState_Generating,
+    writes its tiles and then publishes it by swapping the state to Ready. Until then
+    readers must treat it as all empty, GetReadableTileChunk does that.
+*/
+
+#define TILE_CHUNK_SHIFT 4
+#define TILE_CHUNK_DIM (1 << TILE_CHUNK_SHIFT)
+#define TILE_CHUNK_MASK (TILE_CHUNK_DIM - 1)
+#define TILE_CHUNK_HASH_INITIAL 1024    // slots, power of two
+
+enum TileValue : uint8_t
+{
+    TileValue_Empty,    // never written, or a chunk that doesn't exist
+    TileValue_Floor,
+    TileValue_Wall,
+    TileValue_Water,
+};
+
+enum TileChunkState : uint32_t
+{
+    TileChunkState_Blank,       // never filled, every tile is empty
+    TileChunkState_Generating,  // tiles belong to a worker, don't read them
+    TileChunkState_Ready,
+};
+
+struct WorldEntityBlock;
+
+struct TileChunk
+{
+    int32_t chunkX;
+    int32_t chunkY;
+    LONG volatile state;                            // TileChunkState
+    uint8_t tiles[TILE_CHUNK_DIM * TILE_CHUNK_DIM];  // row major
+    WorldEntityBlock* firstEntityBlock;             // entities inside this chunk, owned by the world
+};
+
+struct TileChunkSlot
+{
+    int32_t chunkX;
+    int32_t chunkY;
+    TileChunk* chunk;   // nullptr = empty slot
+};
+
+struct TileMap
+{
+    MemoryArena* arena;
+    float tileSideInMeters;
+
+    TileChunkSlot* slots;
+    uint32_t slotCount;
+    uint32_t chunkCount;
+};
+
+//Tiles are addressed with absolute int32 coordinates, the chunk is the top bits
+inline auto TileToChunk(int32_t absTile) -> int32_t
+{
+    return absTile >> TILE_CHUNK_SHIFT;   // arithmetic shift, so negative tiles floor too
+}
+
+void InitializeTileMap(TileMap& tileMap, MemoryArena& arena, float tileSideInMeters);
+auto GetTileChunk(TileMap& tileMap, int32_t chunkX, int32_t chunkY) -> TileChunk*;
+auto GetOrCreateTileChunk(TileMap& tileMap, int32_t chunkX, int32_t chunkY) -> TileChunk*;
+//nullptr unless the chunk exists and no worker is still writing it
+auto GetReadableTileChunk(TileMap& tileMap, int32_t chunkX, int32_t chunkY) -> TileChunk*;
+auto GetTileValue(TileMap& tileMap, int32_t absTileX, int32_t absTileY) -> uint8_t;
+void SetTileValue(TileMap& tileMap, int32_t absTileX, int32_t absTileY, uint8_t value);
@@ -0,0 +1,20 @@
+#pragma once
+#include "globals.h"
+
+/*
+    NOTE: Minimal RIFF/WAVE writer. The header goes out first with zero sizes
+    and gets patched in WavClose once we know how much data was written.
+*/
+
+struct WavWriter
+{
+    HANDLE file = INVALID_HANDLE_VALUE;
+    int samplesPerSecond = 0;
+    int channels = 0;
+    int bitsPerSample = 0;
+    uint32_t dataBytes = 0;
+};
+
+auto WavOpen(WavWriter& writer, const char* path, int samplesPerSecond, int channels, int bitsPerSample) -> bool;
+void WavWrite(WavWriter& writer, const void* data, uint32_t bytes);
+void WavClose(WavWriter& writer);
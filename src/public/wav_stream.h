@@ -0,0 +1,37 @@
+#pragma once
+#include "game.h"
+
+/*
+    NOTE: Streaming WAV reader.
+    The file is memory mapped but only a single window (one allocation granule plus a
+    frame of slack) is mapped at a time, so a long music track costs one window of
+    resident memory no matter how large the file is. PCM is converted to float on the
+    way into the mixer, nothing is decoded up front. The read position belongs to the
+    caller, so several voices can play one stream; far apart they remap the window.
+
+    Supports 16-bit PCM and 32-bit float, mono or stereo.
+*/
+
+struct WavStream
+{
+    PlatformMappedFile file;
+
+    int channels;
+    int bitsPerSample;
+    int samplesPerSecond;
+    bool isFloat;
+    int bytesPerFrame;
+
+    uint64_t dataOffset;   // byte offset of the first frame in the file
+    uint64_t frameCount;
+
+    uint8_t* view;
+    uint64_t viewOffset;
+    uint32_t viewSize;
+};
+
+auto WavStreamOpen(WavStream& stream, const char* path) -> bool;
+void WavStreamClose(WavStream& stream);
+//Adds up to frameCount frames from framePosition on, scaled by volume, into the planar left/right buffers.
+//Advances framePosition and returns frames read.
+int WavStreamMix(WavStream& stream, uint64_t& framePosition, float* left, float* right, int frameCount, float volume);
@@ -0,0 +1,59 @@
+#pragma once
+#include "memory.h"
+#include "game_math.h"
+#include "tile_map.h"
+
+/*
+    NOTE: World space is split into the tile map's chunks. A position is the chunk it
+    is in plus a float offset in meters from that chunk's min corner, so the float part
+    never grows past one chunk side and keeps the same precision millions of tiles out.
+    Math between two positions goes through WorldSubtract, which gives a plain v2 in
+    meters that is small whenever the two are close, and that is what hot loops use.
+    Every chunk keeps the entity store slots of the entities inside it, in a list of
+    fixed size blocks, so the sim region can find what is near the camera without
+    looking at the rest of the world. Emptied blocks go on a free list for reuse.
+*/
+
+#define WORLD_ENTITY_BLOCK_COUNT 16
+
+struct WorldEntityBlock
+{
+    uint32_t count;
+    uint32_t entitySlots[WORLD_ENTITY_BLOCK_COUNT];
+    WorldEntityBlock* next;
+};
+
+struct World
+{
+    TileMap tileMap;
+    float tileSideInMeters;
+    float chunkSideInMeters;
+    WorldEntityBlock* firstFreeEntityBlock;
+};
+
+struct WorldPosition
+{
+    int32_t chunkX;
+    int32_t chunkY;
+    v2 offset;      // meters from the chunk's min corner, [0, chunkSideInMeters) once canonical
+};
+
+void InitializeWorld(World& world, MemoryArena& arena, float tileSideInMeters);
+
+//Moves whole chunks out of the offset until it is back inside [0, chunkSide)
+auto CanonicalizePosition(const World& world, WorldPosition position) -> WorldPosition;
+auto OffsetPosition(const World& world, WorldPosition position, v2 offset) -> WorldPosition;
+//a - b in meters
+auto WorldSubtract(const World& world, WorldPosition a, WorldPosition b) -> v2;
+
+auto PositionFromTile(const World& world, int32_t absTileX, int32_t absTileY) -> WorldPosition;   // tile center
+void TileFromPosition(const World& world, WorldPosition position, int32_t& absTileX, int32_t& absTileY);
+inline auto ChunkOrigin(int32_t chunkX, int32_t chunkY) -> WorldPosition
+{
+    return {chunkX, chunkY, {0.0f, 0.0f}};
+}
+
+void AddEntityToChunk(World& world, int32_t chunkX, int32_t chunkY, uint32_t entitySlot);
+void RemoveEntityFromChunk(World& world, int32_t chunkX, int32_t chunkY, uint32_t entitySlot);
+//Moves the entity between chunk lists when from and to are in different chunks
+void ChangeEntityChunk(World& world, uint32_t entitySlot, WorldPosition from, WorldPosition to);
@@ -0,0 +1,45 @@
+#pragma once
+#include "game.h"
+#include "world.h"
+
+/*
+    NOTE: Procedural chunk generation. A chunk's tiles are a pure function of the world
+    seed and the chunk's coordinates: fractal value noise over a hashed integer lattice
+    picks water, floor or rock for every tile, then boulders are scattered with the
+    chunk's own random series. Nothing depends on which thread ran it or in what order, so a replayed
+    session sees the same world.
+    GenerateChunksAround runs on the main thread. It creates any chunk in range that
+    was never filled, marks it Generating and queues it on the background queue,
+    nearest first. The job fills the tiles and publishes the chunk (see tile_map.h).
+    Chunks already created by something else, e.g. an entity filed there, are still
+    generated as long as they are Blank; tiles set by hand are left alone.
+*/
+
+#define WORLD_GEN_MAX_JOBS 64   // in flight at once, well under what the work queue holds
+
+struct WorldGenerator;
+
+struct WorldGenJob
+{
+    WorldGenerator* generator;
+    TileChunk* chunk;
+    LONG volatile isBusy;
+};
+
+struct WorldGenerator
+{
+    uint32_t seed;
+    PlatformWorkQueue* queue;
+    LONG volatile jobsInFlight;
+    uint32_t chunksGenerated;   // queued so far, main thread only
+    WorldGenJob jobs[WORLD_GEN_MAX_JOBS];
+};
+
+void InitializeWorldGenerator(WorldGenerator& generator, uint32_t seed, PlatformWorkQueue* queue);
+//Fills the chunk's tiles, callable from any thread
+void GenerateChunkTiles(uint32_t seed, int32_t chunkX, int32_t chunkY, uint8_t* tiles);
+//Queues every Blank chunk within radius chunks of the center, returns how many were queued
+auto GenerateChunksAround(WorldGenerator& generator, World& world, int32_t centerChunkX, int32_t centerChunkY,
+                          int32_t radius) -> uint32_t;
+//Spins until every queued chunk is published
+void WaitForWorldGenerator(WorldGenerator& generator);